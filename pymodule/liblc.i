@@ -51,6 +51,27 @@
 #include "packet-set.h"
 #include "packet-set.c"
 
+#include "peeling-set.h"
+#include "peeling-set.c"
+
+#include "coef-generator.h"
+#include "coef-generator.c"
+
+#include "encoder.h"
+#include "encoder.c"
+
+#include "block-encoder.h"
+#include "block-encoder.c"
+
+#include "block-decoder.h"
+#include "block-decoder.c"
+
+#include "fulcrum.h"
+#include "fulcrum.c"
+
+#include "decoder-manager.h"
+#include "decoder-manager.c"
+
 #include "general.c"
 
 STATIC_ENSURE_EQUAL(check_coef_header_size,
@@ -62,11 +83,26 @@ typedef uint8_t bool_t;
 %include "linear-code.h"
 %include "coded-packet.h"
 %include "packet-set.h"
+%include "peeling-set.h"
+%include "coef-generator.h"
+%include "encoder.h"
+%include "block-encoder.h"
+%include "block-decoder.h"
+%include "fulcrum.h"
+%include "decoder-manager.h"
 %include "macro-pywrite.h"
 
 %pointer_functions(coded_packet_t, codedPacket)
 %pointer_functions(packet_set_t, packetSet)
+%pointer_functions(peeling_set_t, peelingSet)
+%pointer_functions(encoder_t, encoder)
+%pointer_functions(coef_generator_t, coefGenerator)
+%pointer_functions(block_encoder_t, blockEncoder)
+%pointer_functions(block_decoder_t, blockDecoder)
+%pointer_functions(fulcrum_encoder_t, fulcrumEncoder)
+%pointer_functions(decoder_manager_t, decoderManager)
 %pointer_functions(reduction_stat_t, reductionStat)
+%pointer_functions(receiver_state_t, receiverState)
 
 //---------------------------------------------------------------------------
 
@@ -95,8 +131,16 @@ typedef uint8_t bool_t;
 
   WRAP_PYWRITE(coded_packet_pyrepr, coded_packet_pywrite, coded_packet_t*);
   WRAP_PYWRITE(packet_set_pyrepr, packet_set_pywrite, packet_set_t*);
+  WRAP_PYWRITE(peeling_set_pyrepr, peeling_set_pywrite, peeling_set_t*);
+  WRAP_PYWRITE(encoder_pyrepr, encoder_pywrite, encoder_t*);
   WRAP_PYWRITE(reduction_stat_pyrepr, reduction_stat_pywrite, 
 	       reduction_stat_t*);
+  WRAP_PYWRITE(receiver_state_pyrepr, receiver_state_pywrite, 
+	       receiver_state_t*);
+  WRAP_PYWRITE(decoder_manager_pyrepr, decoder_manager_pywrite, 
+	       decoder_manager_t*);
+  WRAP_PYWRITE(block_decoder_pyrepr, block_decoder_pywrite, 
+	       block_decoder_t*);
 
   coded_packet_t* packet_set_get_coded_packet
     (packet_set_t* set, uint16_t packet_id)
@@ -315,6 +315,10 @@ class PacketSet:
         self.decodedList.append(packetId)
         self.lastDecodedList.append(packetId)
 
+    def notifyFull(self, requiredMinCoefPos):
+        # the freed decoded packets go to the store of decoded packets
+        packet_set_free_decoded(self.content, requiredMinCoefPos)
+
     def add(self, codedPacket):
         codedPacket = codedPacket.clone()
         self.lastDecodedList = []
@@ -33,6 +33,8 @@ LIBLCDIR = "../src"
 
 extension = Extension("liblcmodule", ["liblcmodule.c"])
 extension.undef_macros.append("NDEBUG")
+# keep the freed decoded packets, see DECODED_STORE_SIZE in packet-set.h
+extension.define_macros.append(("CONF_DECODED_STORE_SIZE", "8"))
 extension.include_dirs.append(LIBLCDIR)
 
 setup(name="liblcmodule", version="0.1",
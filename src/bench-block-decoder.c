@@ -0,0 +1,167 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Decoding time of one generation of K source packets in GF(256),
+ *          with the block decoder (coefficients, then payloads), and for
+ *          comparison with packet_set_add when the generation fits in
+ *          the window of the coded packets.
+ *
+ * Usage: bench-block-decoder [MAX_K]
+ *
+ * Built with CONF_CODED_PACKET_SIZE=1024; the coded packets are dense
+ * random combinations of the K source packets (without losses).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "block-decoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define L 3
+#define DATA_SIZE CODED_PACKET_SIZE
+#define MAX_K BLOCK_DECODER_MAX_K
+#define PACKET_SET_K MIN(MAX_CODED_PACKET-1, 1<<log2_window_size(L))
+
+uint8_t source_table[MAX_K][DATA_SIZE];
+uint8_t result[MAX_K][DATA_SIZE];
+uint8_t* source_ptr_table[MAX_K];
+uint8_t* result_ptr_table[MAX_K];
+uint8_t coef_table[MAX_K];
+uint8_t coded_data[DATA_SIZE];
+block_decoder_t decoder;
+packet_set_t set;
+
+static double get_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void make_coded_packet(uint16_t k)
+{
+  uint16_t j;
+  for (j=0; j<k; j++)
+    coef_table[j] = rand() & 0xff;
+  lc_vector_linear_combination(coef_table, source_ptr_table, k, DATA_SIZE,
+			       L, coded_data);
+}
+
+static void bench_block_decoder(uint16_t k, void* memory)
+{
+  double header_time = 0, payload_time = 0, t;
+  block_decoder_init(&decoder, L, k, DATA_SIZE, memory,
+		     block_decoder_get_memory_size(k, DATA_SIZE));
+  while (!block_decoder_is_complete(&decoder)) {
+    make_coded_packet(k);
+    t = get_time();
+    block_decoder_add(&decoder, coef_table, coded_data, DATA_SIZE);
+    header_time += get_time() - t;
+  }
+  t = get_time();
+  block_decoder_decode(&decoder, result_ptr_table);
+  payload_time = get_time() - t;
+
+  if (memcmp(result, source_table, (size_t)k*DATA_SIZE) != 0) {
+    fprintf(stderr, "ERROR: K=%u: bad decoded packets\n", k);
+    exit(EXIT_FAILURE);
+  }
+  printf("block decoder K=%4u: %9.3f ms (coefficients %9.3f ms,"
+	 " payloads %9.3f ms), %7.1f MB/s\n", k,
+	 (header_time + payload_time) * 1e3, header_time * 1e3,
+	 payload_time * 1e3, 
+	 k * DATA_SIZE / (header_time + payload_time) / 1e6);
+}
+
+static void bench_packet_set(uint16_t k)
+{
+  coded_packet_t pkt;
+  double add_time = 0, t;
+  uint16_t j, nb_decoded = 0;
+  reduction_stat_t stat;
+  packet_set_init(&set, L, NULL, NULL, NULL, NULL);
+  while (nb_decoded < k) {
+    make_coded_packet(k);
+    coded_packet_init(&pkt, L);
+    for (j=0; j<k; j++)
+      coded_packet_set_coef(&pkt, j, coef_table[j]);
+    memcpy(coded_packet_data(&pkt), coded_data, DATA_SIZE);
+    pkt.data_size = DATA_SIZE;
+    t = get_time();
+    packet_set_add(&set, &pkt, &stat, true);
+    add_time += get_time() - t;
+    nb_decoded += stat.decoded;
+  }
+  printf("packet set    K=%4u: %9.3f ms, %7.1f MB/s\n", k, add_time * 1e3,
+	 k * DATA_SIZE / add_time / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t max_k = (argc > 1) ? atoi(argv[1]) : MAX_K;
+  uint16_t i, j, k;
+  if (max_k == 0 || max_k > MAX_K) {
+    fprintf(stderr, "MAX_K must be between 1 and %u\n", MAX_K);
+    exit(EXIT_FAILURE);
+  }
+  void* memory = malloc(block_decoder_get_memory_size(max_k, DATA_SIZE));
+  if (memory == NULL) {
+    fprintf(stderr, "ERROR: cannot allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  srand(1);
+  for (i=0; i<max_k; i++) {
+    for (j=0; j<DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+    source_ptr_table[i] = source_table[i];
+    result_ptr_table[i] = result[i];
+  }
+
+  printf("payload %u bytes, GF(256)\n", DATA_SIZE);
+  if (PACKET_SET_K <= max_k) {
+    bench_packet_set(PACKET_SET_K);
+    bench_block_decoder(PACKET_SET_K, memory);
+  }
+  for (k=16; k<=max_k; k*=2)
+    if (k != PACKET_SET_K)
+      bench_block_decoder(k, memory);
+  free(memory);
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
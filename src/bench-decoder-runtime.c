@@ -0,0 +1,164 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Decoding throughput of the decoder runtime, with an increasing
+ *          number of worker threads.
+ *
+ * Usage: bench-decoder-runtime [MAX_WORKER [NB_FLOW]]
+ *
+ * The coded packets of all flows (sliding window, GF(256), no loss) are
+ * generated beforehand, then dispatched in turn to the runtime; the time is
+ * measured until all workers are stopped.
+ *
+ * The speedup is bounded by the number of cores (one of them runs the
+ * dispatcher, which copies every coded packet) and is not assumed here:
+ * it is only what this benchmark reports on the machine.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "general.h"
+#include "decoder-runtime.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define L 3
+#define NB_SOURCE 400
+#define DATA_SIZE 64
+#define WINDOW MIN(MAX_CODED_PACKET-1, 15) /* < header window of GF(256) */
+
+decoder_runtime_t runtime;
+uint32_t nb_decoded_table[DECODER_RUNTIME_MAX_WORKER];
+
+static double get_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void count_decoded(void* notif_data, uint16_t worker_index,
+			  uint32_t flow_id, coded_packet_t* pkt)
+{ nb_decoded_table[worker_index] ++; }
+
+static void make_combination(coded_packet_t* pkt, uint16_t first,
+			     uint16_t last)
+{
+  uint8_t data[DATA_SIZE];
+  uint16_t i, j;
+  coded_packet_init(pkt, L);
+  for (i=first; i<=last; i++) {
+    coded_packet_t src;
+    for (j=0; j<DATA_SIZE; j++)
+      data[j] = rand() & 0xff;
+    coded_packet_init_from_base_packet(&src, L, i, data, DATA_SIZE);
+    coded_packet_add_mult(pkt, 1 + rand()%255, &src);
+  }
+}
+
+/* returns the number of packets per second */
+static double bench_runtime(coded_packet_t* pkt_table, uint16_t nb_flow,
+			    uint16_t nb_worker, double base_rate)
+{
+  uint16_t i, f;
+  memset(nb_decoded_table, 0, sizeof(nb_decoded_table));
+  double t = get_time();
+  if (!decoder_runtime_start(&runtime, nb_worker, L, NB_SOURCE,
+			     count_decoded, NULL)) {
+    fprintf(stderr, "ERROR: cannot start the runtime\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i=0; i<NB_SOURCE; i++)
+    for (f=0; f<nb_flow; f++)
+      decoder_runtime_dispatch(&runtime, f, i, &pkt_table[f*NB_SOURCE+i]);
+  decoder_runtime_stop(&runtime);
+  t = get_time() - t;
+
+  uint32_t nb_decoded = 0, nb_wait = 0;
+  for (i=0; i<nb_worker; i++) {
+    nb_decoded += nb_decoded_table[i];
+    nb_wait += runtime.worker[i].queue.producer_stat.nb_wait;
+  }
+  double rate = (double)nb_flow * NB_SOURCE / t;
+  printf("%2u workers, %3u flows: %8.0f packets/s (x%.2f), decode %7.1f MB/s,"
+	 " %u/%u decoded, %u migrations, %u waits for a full queue\n",
+	 nb_worker, nb_flow, rate, (base_rate > 0) ? rate / base_rate : 1.0,
+	 (double)nb_decoded * DATA_SIZE / t / 1e6,
+	 nb_decoded, nb_flow * NB_SOURCE, runtime.stat.nb_migration,
+	 nb_wait);
+  return rate;
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t max_worker = (argc > 1) ? atoi(argv[1]) : 4;
+  uint16_t nb_flow = (argc > 2) ? atoi(argv[2]) : 64;
+  uint16_t i, f, nb_worker;
+
+  if (max_worker == 0 || max_worker > DECODER_RUNTIME_MAX_WORKER
+      || nb_flow == 0) {
+    fprintf(stderr, "MAX_WORKER must be between 1 and %u\n",
+	    DECODER_RUNTIME_MAX_WORKER);
+    exit(EXIT_FAILURE);
+  }
+  coded_packet_t* pkt_table = malloc(sizeof(coded_packet_t)
+				     * nb_flow * NB_SOURCE);
+  if (pkt_table == NULL) {
+    fprintf(stderr, "ERROR: cannot allocate the coded packets\n");
+    exit(EXIT_FAILURE);
+  }
+  srand(1);
+  for (f=0; f<nb_flow; f++)
+    for (i=0; i<NB_SOURCE; i++)
+      make_combination(&pkt_table[f*NB_SOURCE+i],
+		       (i >= WINDOW-1) ? i-(WINDOW-1) : 0, i);
+
+  /* the speedup (xN) is relative to one worker; the dispatcher is one
+     more thread, so it is only meaningful up to (cores - 1) workers */
+  long nb_core = sysconf(_SC_NPROCESSORS_ONLN);
+  double base_rate = 0;
+  printf("%ld cores\n", nb_core);
+  for (nb_worker=1; nb_worker<=max_worker; nb_worker*=2) {
+    if (nb_worker + 1 > nb_core)
+      printf("(more threads than cores)\n");
+    double rate = bench_runtime(pkt_table, nb_flow, nb_worker, base_rate);
+    if (nb_worker == 1)
+      base_rate = rate;
+  }
+  free(pkt_table);
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
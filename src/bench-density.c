@@ -0,0 +1,163 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Cost of the density of the coded packets (encoder_set_density):
+ *          encoding time, decoding time and eliminations with 
+ *          packet_set_add, and extra coded packets needed.
+ *
+ * Usage: bench-density [NB_GENERATION]
+ *
+ * Each generation of WINDOW source packets is put in the window of the
+ * encoder, and coded packets are generated until the receiver has decoded
+ * all of them (without losses).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "encoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define WINDOW MIN(16, ENCODER_MAX_WINDOW)
+#define DATA_SIZE CODED_PACKET_SIZE
+#define MAX_PACKET_PER_GENERATION (10*WINDOW)
+
+uint8_t source_table[WINDOW][DATA_SIZE];
+
+static double get_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench_density(uint8_t l, uint16_t density, uint16_t band_width,
+			  uint16_t nb_generation)
+{
+  static encoder_t encoder; /* large */
+  static packet_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt;
+  double encode_time = 0, decode_time = 0, t;
+  uint32_t nb_packet = 0, nb_coef = 0, nb_elimination = 0;
+  uint16_t g, i, j, nb_failed = 0;
+
+  encoder_init(&encoder, l, WINDOW, 1);
+  encoder_set_density(&encoder, density, band_width);
+
+  for (g=0; g<nb_generation; g++) {
+    if (!encoder_is_empty(&encoder))
+      encoder_ack(&encoder, encoder_get_next_coef_pos(&encoder)-1);
+    uint16_t coef_pos_base = encoder_get_next_coef_pos(&encoder);
+    t = get_time();
+    for (i=0; i<WINDOW; i++)
+      encoder_add_source(&encoder, source_table[i], DATA_SIZE);
+    encode_time += get_time() - t;
+    packet_set_init(&set, l, NULL, NULL, NULL, NULL);
+
+    uint16_t nb_decoded = 0;
+    for (i=0; i<MAX_PACKET_PER_GENERATION && nb_decoded < WINDOW; i++) {
+      t = get_time();
+      encoder_generate(&encoder, &pkt);
+      encode_time += get_time() - t;
+      nb_packet ++;
+      for (j=pkt.coef_pos_min; j<=pkt.coef_pos_max; j++)
+	nb_coef += (coded_packet_get_coef(&pkt, j) != 0);
+
+      t = get_time();
+      packet_set_add(&set, &pkt, &stat, true);
+      decode_time += get_time() - t;
+      nb_decoded += stat.decoded;
+      nb_elimination += stat.elimination;
+    }
+    nb_failed += (nb_decoded < WINDOW);
+    for (j=0; j<WINDOW; j++) {
+      coded_packet_t* decoded 
+	= packet_set_get_decoded_packet(&set, coef_pos_base+j);
+      if (decoded != NULL
+	  && memcmp(coded_packet_data(decoded), source_table[j], DATA_SIZE)
+	  != 0) {
+	fprintf(stderr, "ERROR: bad decoded packet\n");
+	exit(EXIT_FAILURE);
+      }
+    }
+  }
+
+  double nb_byte = (double)nb_generation * WINDOW * DATA_SIZE;
+  printf("GF(%3u) density=%3u/%u band=%2u: %6.2f packets/gen"
+	 " (overhead %5.2f), %5.2f coefs/packet, %6.1f elim/gen,"
+	 " encode %7.1f MB/s, decode %7.1f MB/s%s\n",
+	 1<<(1<<l), density, ENCODER_DENSITY_FULL, band_width,
+	 (double)nb_packet / nb_generation,
+	 (double)nb_packet / nb_generation - WINDOW,
+	 (double)nb_coef / nb_packet, (double)nb_elimination / nb_generation,
+	 nb_byte / encode_time / 1e6, nb_byte / decode_time / 1e6,
+	 nb_failed > 0 ? " (some generations not decoded)" : "");
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t nb_generation = (argc > 1) ? atoi(argv[1]) : 100;
+  uint16_t density_table[] = { ENCODER_DENSITY_FULL, ENCODER_DENSITY_FULL/2,
+			       ENCODER_DENSITY_FULL/4, ENCODER_DENSITY_FULL/8 };
+  uint16_t band_table[] = { 0, WINDOW/2, WINDOW/4 };
+  uint16_t i, j;
+  uint8_t l;
+
+  if (nb_generation == 0 
+      || (uint32_t)nb_generation * WINDOW >= MAX_COEF_POS) {
+    fprintf(stderr, "NB_GENERATION must be between 1 and %u\n",
+	    (MAX_COEF_POS-1) / WINDOW);
+    exit(EXIT_FAILURE);
+  }
+  srand(1);
+  for (i=0; i<WINDOW; i++)
+    for (j=0; j<DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    if (WINDOW > (1<<log2_window_size(l)))
+      continue;
+    for (i=0; i<sizeof(density_table)/sizeof(density_table[0]); i++)
+      bench_density(l, density_table[i], 0, nb_generation);
+    for (i=1; i<sizeof(band_table)/sizeof(band_table[0]); i++)
+      bench_density(l, ENCODER_DENSITY_FULL, band_table[i], nb_generation);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
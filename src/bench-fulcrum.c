@@ -0,0 +1,178 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Compare Fulcrum coding (inner and outer decoding) with random
+ *          linear coding in GF(256): coded packets needed per block, and
+ *          encoding/decoding time.
+ *
+ * Usage: bench-fulcrum [K [R [NB_BLOCK]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "encoder.h"
+#include "fulcrum.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define MAX_K 16
+#define DATA_SIZE CODED_PACKET_SIZE
+#define MAX_PACKET_PER_BLOCK 1000
+#define SEED UINT64_C(0x9e3779b97f4a7c15) /* of the encoders */
+
+#define SCHEME_GF256         0
+#define SCHEME_FULCRUM_INNER 1
+#define SCHEME_FULCRUM_OUTER 2
+
+static const char* scheme_name[] = { "gf256", "fulcrum-inner", 
+				     "fulcrum-outer" };
+
+uint8_t source_table[MAX_K][DATA_SIZE];
+
+static double get_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool is_block_decoded(packet_set_t* set, uint16_t coef_pos_base,
+			     uint16_t k)
+{
+  uint16_t j;
+  for (j=0; j<k; j++)
+    if (!bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE,
+			coef_pos_base+j))
+      return false;
+  return true;
+}
+
+static void bench_scheme(int scheme, uint16_t k, uint16_t r, 
+			 uint16_t nb_block)
+{
+  static encoder_t encoder; /* large */
+  static fulcrum_encoder_t fulcrum;
+  static packet_set_t set;
+  block_encoder_t outer;
+  coded_packet_t pkt, outer_pkt;
+  uint8_t* data_table[MAX_K];
+  double encode_time = 0, decode_time = 0, t;
+  uint32_t nb_packet = 0;
+  uint16_t b, i, nb_failed = 0;
+
+  encoder_init(&encoder, 3, k, SEED);
+  fulcrum_encoder_init(&fulcrum, k, r, SEED);
+  block_encoder_init(&outer, 3, k, r);
+  for (i=0; i<k; i++)
+    data_table[i] = source_table[i];
+
+  for (b=0; b<nb_block; b++) {
+    uint16_t coef_pos_base = b*(k+r);
+    for (i=0; i<k; i++)
+      source_table[i][b % DATA_SIZE] ^= b;
+
+    t = get_time();
+    if (scheme == SCHEME_GF256) {
+      /* the window of the encoder is the block */
+      if (!encoder_is_empty(&encoder))
+	encoder_ack(&encoder, encoder_get_next_coef_pos(&encoder)-1);
+      coef_pos_base = encoder_get_next_coef_pos(&encoder);
+      for (i=0; i<k; i++)
+	encoder_add_source(&encoder, source_table[i], DATA_SIZE);
+    } else fulcrum_encoder_set_block(&fulcrum, coef_pos_base, data_table,
+				     DATA_SIZE);
+    encode_time += get_time() - t;
+    packet_set_init(&set, (scheme == SCHEME_FULCRUM_INNER) ? 0 : 3,
+		    NULL, NULL, NULL, NULL);
+
+    for (i=0; i<MAX_PACKET_PER_BLOCK; i++) {
+      t = get_time();
+      if (scheme == SCHEME_GF256)
+	encoder_generate(&encoder, &pkt);
+      else fulcrum_encoder_generate(&fulcrum, &pkt);
+      encode_time += get_time() - t;
+      nb_packet ++;
+
+      t = get_time();
+      if (scheme == SCHEME_FULCRUM_OUTER) {
+	fulcrum_map_to_outer(&outer, coef_pos_base, &pkt, &outer_pkt);
+	packet_set_add(&set, &outer_pkt, NULL, true);
+      } else packet_set_add(&set, &pkt, NULL, true);
+      bool is_decoded = is_block_decoded(&set, coef_pos_base, k);
+      decode_time += get_time() - t;
+      if (is_decoded)
+	break;
+    }
+    nb_failed += (i == MAX_PACKET_PER_BLOCK);
+  }
+
+  double nb_byte = (double)nb_block * k * DATA_SIZE;
+  printf("%-14s K=%u R=%u: %6.2f packets/block (overhead %5.2f),"
+	 " encode %7.1f MB/s, decode %7.1f MB/s%s\n",
+	 scheme_name[scheme], k, r, (double)nb_packet / nb_block, 
+	 (double)nb_packet / nb_block - k,
+	 nb_byte / encode_time / 1e6, nb_byte / decode_time / 1e6,
+	 nb_failed > 0 ? " (some blocks not decoded)" : "");
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t k = (argc > 1) ? atoi(argv[1]) : MAX_K;
+  uint16_t r = (argc > 2) ? atoi(argv[2]) : 2;
+  uint16_t nb_block = (argc > 3) ? atoi(argv[3]) : 200;
+  fulcrum_encoder_t fulcrum;
+  uint16_t i, j;
+
+  if (k == 0 || k > MAX_K || k+r > MAX_CODED_PACKET || k > ENCODER_MAX_WINDOW
+      || nb_block == 0 || (uint32_t)nb_block*(k+r) >= MAX_COEF_POS
+      || !fulcrum_encoder_init(&fulcrum, k, r, SEED)) {
+    fprintf(stderr, "unsupported parameters (K+R at most %u, K at most %u)\n",
+	    MAX_CODED_PACKET, MAX_K);
+    exit(EXIT_FAILURE);
+  }
+  srand(1);
+  for (i=0; i<k; i++)
+    for (j=0; j<DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+
+  bench_scheme(SCHEME_GF256, k, r, nb_block);
+  bench_scheme(SCHEME_FULCRUM_INNER, k, r, nb_block);
+  bench_scheme(SCHEME_FULCRUM_OUTER, k, r, nb_block);
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
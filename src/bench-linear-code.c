@@ -0,0 +1,286 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Throughput of the kernels of linear-code.c (vector add, mul,
+ *          mul_add, and coefficient get/set/scan) in every field, for 
+ *          sizes from 16 bytes to 64 KiB, on aligned and unaligned buffers
+ *          (get and set are limited to 65535 coefficients).
+ *
+ * Usage: bench-linear-code [MS_PER_REPETITION]
+ *
+ * Each measure is a warmup, which also finds the number of calls lasting
+ * about MS_PER_REPETITION milliseconds, then NB_REPETITION repetitions of
+ * these calls: the best and median repetitions are reported in GB/s and
+ * cycles/byte (time stamp counter, x86 only).
+ * The results are written in JSON on stdout, one measure per line (so
+ * that the outputs of two builds can be compared with diff), and as a 
+ * table on stderr.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif /* defined(__x86_64__) || defined(__i386__) */
+
+#include "general.h"
+#include "linear-code.h"
+#include "coded-packet.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_REPETITION 7
+#define DEFAULT_MS_PER_REPETITION 5
+#define MIN_SIZE 16
+#define MAX_SIZE 0xffff /* (sizes are uint16_t: "64 KiB" is 64 KiB - 1) */
+#define ALIGNMENT 64
+
+#define KERNEL_ADD     0
+#define KERNEL_MUL     1
+#define KERNEL_MUL_ADD 2
+#define KERNEL_GET     3
+#define KERNEL_SET     4
+#define KERNEL_SCAN    5
+#define NB_KERNEL      6
+
+static const char* kernel_name[NB_KERNEL] = {
+  "add", "mul", "mul_add", "get", "set", "scan"
+};
+
+uint8_t* buffer1;
+uint8_t* buffer2;
+uint8_t* buffer3;
+coded_packet_t scan_packet;
+volatile uint8_t sink; /* keeps the results of get alive */
+
+static double get_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t get_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else /* defined(__x86_64__) || defined(__i386__) */
+  return 0;
+#endif /* defined(__x86_64__) || defined(__i386__) */
+}
+
+/* one call of the kernel on `size` bytes; returns the number of bytes */
+static uint32_t run_kernel(uint8_t kernel, uint8_t l, uint8_t* data1, 
+			   uint8_t* data2, uint8_t* result, uint16_t size)
+{
+  uint16_t nb_coef = size << (3-l);
+  uint16_t result_size, i;
+  uint8_t value = 0;
+  uint8_t coef_mask = (1<<(1<<l)) - 1;
+
+  switch (kernel) {
+  case KERNEL_ADD:
+    lc_vector_add(data1, size, data2, size, result, &result_size);
+    return size;
+  case KERNEL_MUL:
+    lc_vector_mul(0x53 & coef_mask, data1, size, l, result);
+    return size;
+  case KERNEL_MUL_ADD:
+    lc_vector_mul_add(0x53 & coef_mask, data1, size, l, result);
+    return size;
+  case KERNEL_GET:
+    for (i=0; i<nb_coef; i++)
+      value ^= lc_vector_get(data1, size, l, i);
+    sink = value;
+    return size;
+  case KERNEL_SET:
+    for (i=0; i<nb_coef; i++)
+      lc_vector_set(result, size, l, i, i & coef_mask);
+    return size;
+  case KERNEL_SCAN:
+    /* (only the coefficient header is scanned: `size` is ignored) */
+    scan_packet.coef_pos_min = 0;
+    scan_packet.coef_pos_max = (1<<log2_window_size(l)) - 1;
+    coded_packet_adjust_min_max_coef(&scan_packet);
+    return COEF_HEADER_SIZE;
+  default:
+    FATAL("invalid kernel");
+  }
+  return 0;
+}
+
+static int compare_double(const void* p1, const void* p2)
+{
+  double d1 = *(const double*)p1, d2 = *(const double*)p2;
+  return (d1 > d2) - (d1 < d2);
+}
+
+static void bench_kernel(uint8_t kernel, uint8_t l, uint16_t size, 
+			 uint8_t offset, double repetition_time)
+{
+  double time_table[NB_REPETITION];
+  uint64_t cycle_table[NB_REPETITION];
+  uint64_t nb_byte = 0;
+  uint32_t nb_iteration, r, i;
+
+  if (kernel == KERNEL_SCAN) {
+    coded_packet_init(&scan_packet, l);
+    coded_packet_set_coef(&scan_packet, (1<<log2_window_size(l)) - 1, 1);
+  }
+
+  /* warmup: doubles the number of calls until it lasts long enough */
+  for (nb_iteration=1; nb_iteration < (1u<<30); nb_iteration *= 2) {
+    double start_time = get_time();
+    for (i=0; i<nb_iteration; i++)
+      run_kernel(kernel, l, buffer1 + offset, buffer2 + offset,
+		 buffer3 + offset, size);
+    if (get_time() - start_time >= repetition_time)
+      break;
+  }
+
+  for (r=0; r<NB_REPETITION; r++) {
+    uint64_t start_cycle = get_cycles();
+    double start_time = get_time();
+    nb_byte = 0;
+    for (i=0; i<nb_iteration; i++)
+      nb_byte += run_kernel(kernel, l, buffer1 + offset, buffer2 + offset,
+			    buffer3 + offset, size);
+    time_table[r] = get_time() - start_time;
+    cycle_table[r] = get_cycles() - start_cycle;
+  }
+
+  /* best and median repetition (the cycles of the best one) */
+  double best_time = time_table[0];
+  uint64_t best_cycle = cycle_table[0];
+  for (r=1; r<NB_REPETITION; r++)
+    if (time_table[r] < best_time) {
+      best_time = time_table[r];
+      best_cycle = cycle_table[r];
+    }
+  qsort(time_table, NB_REPETITION, sizeof(double), compare_double);
+  double median_time = time_table[NB_REPETITION/2];
+  if (best_time <= 0)
+    best_time = 1e-9;
+
+  double best_rate = nb_byte / best_time / 1e9;
+  double median_rate = nb_byte / median_time / 1e9;
+  double cycle_per_byte = (double)best_cycle / nb_byte;
+
+  printf("{\"kernel\":\"%s\", \"field\":%u, \"size\":%u, \"aligned\":%s,"
+	 " \"bytes\":%llu, \"best_gbps\":%.4f, \"median_gbps\":%.4f,"
+	 " \"cycles_per_byte\":%.4f}", kernel_name[kernel], 1<<(1<<l), 
+	 (kernel == KERNEL_SCAN) ? COEF_HEADER_SIZE : size, 
+	 (offset == 0) ? "true" : "false", (unsigned long long)nb_byte,
+	 best_rate, median_rate, cycle_per_byte);
+  fprintf(stderr, "%-8s GF(%3u) %5u bytes %-9s %9.3f GB/s %9.3f cycles/byte\n",
+	  kernel_name[kernel], 1<<(1<<l), 
+	  (kernel == KERNEL_SCAN) ? COEF_HEADER_SIZE : size,
+	  (offset == 0) ? "aligned" : "unaligned", best_rate, cycle_per_byte);
+}
+
+static uint8_t* alloc_buffer(void)
+{
+  void* result = NULL;
+  if (posix_memalign(&result, ALIGNMENT, MAX_SIZE + ALIGNMENT) != 0) {
+    fprintf(stderr, "ERROR: cannot allocate memory\n");
+    exit(EXIT_FAILURE);
+  }
+  return result;
+}
+
+int main(int argc, char** argv)
+{
+  double repetition_time = ((argc > 1) ? atof(argv[1])
+			    : DEFAULT_MS_PER_REPETITION) * 1e-3;
+  uint32_t i;
+  uint8_t kernel, l, offset;
+  if (repetition_time <= 0) {
+    fprintf(stderr, "MS_PER_REPETITION must be positive\n");
+    exit(EXIT_FAILURE);
+  }
+  buffer1 = alloc_buffer();
+  buffer2 = alloc_buffer();
+  buffer3 = alloc_buffer();
+  srand(1);
+  for (i=0; i<MAX_SIZE + ALIGNMENT; i++) {
+    buffer1[i] = rand() & 0xff;
+    buffer2[i] = rand() & 0xff;
+    buffer3[i] = rand() & 0xff;
+  }
+
+  printf("{\"benchmark\":\"linear-code\", \"compiler\":\"%s\","
+	 " \"gf256\":\"%s\", \"repetitions\":%u,"
+	 " \"ms_per_repetition\":%g, \"cycle_counter\":%s,\n"
+	 " \"results\":[\n", __VERSION__,
+#ifdef WITH_GF256_MUL_TABLE
+	 "mul-table",
+#else /* WITH_GF256_MUL_TABLE */
+	 "log-table",
+#endif /* WITH_GF256_MUL_TABLE */
+	 NB_REPETITION, repetition_time * 1e3,
+#if defined(__x86_64__) || defined(__i386__)
+	 "true"
+#else /* defined(__x86_64__) || defined(__i386__) */
+	 "false"
+#endif /* defined(__x86_64__) || defined(__i386__) */
+	 );
+  bool is_first = true;
+  for (kernel=0; kernel<NB_KERNEL; kernel++)
+    for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+      uint32_t size;
+      for (size=MIN_SIZE; size<=MAX_SIZE; size = (size == MAX_SIZE/2+1) ?
+	     MAX_SIZE : 2*size) {
+	/* (coefficient positions are uint16_t) */
+	if ((kernel == KERNEL_GET || kernel == KERNEL_SET)
+	    && (size << (3-l)) > 0xffff)
+	  break;
+	for (offset=0; offset<=1; offset++) {
+	  printf("%s  ", is_first ? "" : ",\n");
+	  is_first = false;
+	  bench_kernel(kernel, l, size, offset, repetition_time);
+	  fflush(stdout);
+	}
+	if (kernel == KERNEL_SCAN)
+	  break;
+      }
+    }
+  printf("\n]}\n");
+
+  free(buffer1);
+  free(buffer2);
+  free(buffer3);
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,352 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   End-to-end decoding of a sliding window flow: encoder, erasure
+ *          channel, and packet_set_add at the receiver, for each field, 
+ *          window, payload size and loss rate.
+ *
+ * Usage: bench-packet-set [SEED [NB_SOURCE [BURST_LENGTH]]]
+ *
+ * At each slot, the encoder sends one random combination of its window,
+ * through a Bernoulli channel or a Gilbert-Elliott channel (bursts of 
+ * BURST_LENGTH losses on average). A new source packet enters the window 
+ * at a rate adapted to the loss rate (with REDUNDANCY_MARGIN extra), when
+ * the window is not full (immediately when it is empty); the receiver
+ * acknowledges the source packets it has decoded in order (ideal feedback:
+ * immediate and without loss), and they leave the window. Hence no source
+ * packet is abandoned: a packet set cannot decode past a source packet 
+ * that is never recovered.
+ *
+ * The flow is simulated first, giving the received packets, which are 
+ * then decoded again by a new packet set (only this replay is timed).
+ * The channel, the sources and the coefficients only depend on SEED: the
+ * counters are the same for two runs with the same seed, and the times can
+ * be compared between two versions of the decoder.
+ *
+ * The delay of a source packet is the number of slots from the one where
+ * it entered the window, to the one where it is decoded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "encoder.h"
+#include "coef-generator.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define DEFAULT_SEED 1
+#define DEFAULT_NB_SOURCE 2000
+#define DEFAULT_BURST_LENGTH 4
+#define MAX_SOURCE (MAX_COEF_POS-1)
+#define REDUNDANCY_MARGIN 0.10
+#define MAX_SENT_PER_SOURCE 8
+#define MAX_DATA_SIZE CODED_PACKET_SIZE
+
+#define CHANNEL_BERNOULLI        0
+#define CHANNEL_GILBERT_ELLIOTT  1
+
+#define STREAM_SOURCE  0 /* streams of the generators (for one seed) */
+#define STREAM_CHANNEL 1
+
+typedef struct {
+  uint8_t kind;   /* CHANNEL_BERNOULLI or CHANNEL_GILBERT_ELLIOTT */
+  double loss;    /* average loss rate */
+} channel_config_t;
+
+static const channel_config_t channel_table[] = {
+  { CHANNEL_BERNOULLI, 0.0 },
+  { CHANNEL_BERNOULLI, 0.1 },
+  { CHANNEL_BERNOULLI, 0.3 },
+  { CHANNEL_GILBERT_ELLIOTT, 0.1 },
+  { CHANNEL_GILBERT_ELLIOTT, 0.3 }
+};
+#define NB_CHANNEL (sizeof(channel_table)/sizeof(channel_table[0]))
+
+static const uint16_t window_table[] = { 4, 8, 16 };
+#define NB_WINDOW (sizeof(window_table)/sizeof(window_table[0]))
+
+static const uint16_t data_size_table[] = { 64, 256, 1024 };
+#define NB_DATA_SIZE (sizeof(data_size_table)/sizeof(data_size_table[0]))
+
+uint64_t seed = DEFAULT_SEED;
+uint16_t nb_source = DEFAULT_NB_SOURCE;
+double burst_length = DEFAULT_BURST_LENGTH;
+
+uint8_t source_table[MAX_SOURCE][MAX_DATA_SIZE];
+coded_packet_t* received_table; /* the received packets, in order */
+uint32_t* received_slot;  /* the index of each of them in the sent packets */
+uint32_t first_slot[MAX_SOURCE]; /* slot where each source entered the window */
+uint32_t decoded_slot[MAX_SOURCE];
+uint32_t delay_table[MAX_SOURCE];
+
+encoder_t encoder;
+packet_set_t set;
+uint32_t current_slot;
+uint16_t nb_decoded, nb_bad_decoded;
+uint16_t nb_in_order; /* the source packets before it are all decoded */
+uint16_t current_data_size;
+
+/*---------------------------------------------------------------------------*/
+
+static double get_time(clockid_t clock_id)
+{
+  struct timespec ts;
+  clock_gettime(clock_id, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* uniform in [0,1) */
+static double get_random(coef_generator_t* generator)
+{ return coef_generator_next(generator) / 4294967296.0; }
+
+typedef struct {
+  coef_generator_t generator;
+  channel_config_t config;
+  bool is_bad; /* state of the Gilbert-Elliott channel */
+} channel_t;
+
+static void channel_init(channel_t* channel, channel_config_t* config)
+{
+  coef_generator_init_stream(&channel->generator, seed, STREAM_CHANNEL);
+  channel->config = *config;
+  channel->is_bad = false;
+}
+
+/* returns true if the next packet is lost */
+static bool channel_is_lost(channel_t* channel)
+{
+  double loss = channel->config.loss;
+  if (channel->config.kind == CHANNEL_BERNOULLI)
+    return get_random(&channel->generator) < loss;
+
+  /* Gilbert-Elliott: all the packets are lost in the bad state, none in 
+     the good one; the bad state lasts burst_length packets on average, 
+     and the stationary probability of the bad state is `loss` */
+  if (loss <= 0)
+    return false;
+  double p_bad_to_good = 1.0 / burst_length;
+  double p_good_to_bad = loss * p_bad_to_good / (1.0 - loss);
+  double p = get_random(&channel->generator);
+  if (channel->is_bad) {
+    if (p < p_bad_to_good)
+      channel->is_bad = false;
+  } else if (p < p_good_to_bad)
+    channel->is_bad = true;
+  return channel->is_bad;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void notify_packet_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint16_t coef_pos = pkt->coef_pos_min;
+  if (coef_pos >= nb_source || pkt->data_size < current_data_size
+      || memcmp(coded_packet_data(pkt), source_table[coef_pos],
+		current_data_size) != 0) {
+    nb_bad_decoded ++;
+    return;
+  }
+  decoded_slot[coef_pos] = current_slot;
+  nb_decoded ++;
+  while (nb_in_order < nb_source && decoded_slot[nb_in_order] != UINT32_MAX)
+    nb_in_order ++;
+}
+
+static void reset_decoded(void)
+{
+  uint16_t i;
+  for (i=0; i<nb_source; i++)
+    decoded_slot[i] = UINT32_MAX;
+  nb_decoded = 0;
+  nb_bad_decoded = 0;
+  nb_in_order = 0;
+}
+
+/* simulates the flow; returns the number of received packets */
+static uint32_t simulate_flow(uint8_t l, uint16_t window, channel_t* channel,
+			      uint32_t* nb_slot)
+{
+  double rate = (1.0 - channel->config.loss) / (1.0 + REDUNDANCY_MARGIN);
+  double credit = 1;
+  uint32_t nb_received = 0;
+  uint32_t max_slot = (uint32_t)nb_source * MAX_SENT_PER_SOURCE;
+  uint16_t next_source = 0;
+
+  reset_decoded();
+  packet_set_init(&set, l, notify_packet_decoded, packet_set_free_decoded, NULL,
+		  NULL);
+  encoder_init(&encoder, l, window, seed);
+  for (current_slot=0; current_slot < max_slot; current_slot++) {
+    if (nb_in_order > 0)
+      encoder_ack(&encoder, nb_in_order-1);
+    if (next_source < nb_source && encoder.nb_source < window
+	&& (credit >= 1 || encoder_is_empty(&encoder))) {
+      first_slot[next_source] = current_slot;
+      encoder_add_source(&encoder, source_table[next_source],
+			 current_data_size);
+      next_source ++;
+      credit = MAX(credit - 1, 0);
+    }
+    credit = MIN(credit + rate, 1);
+    if (encoder_is_empty(&encoder))
+      break;
+    coded_packet_t* pkt = &received_table[nb_received];
+    encoder_generate(&encoder, pkt);
+    if (channel_is_lost(channel))
+      continue;
+    received_slot[nb_received++] = current_slot;
+    packet_set_add(&set, pkt, NULL, true);
+  }
+  *nb_slot = current_slot;
+  return nb_received;
+}
+
+static int compare_uint32(const void* p1, const void* p2)
+{
+  uint32_t v1 = *(const uint32_t*)p1, v2 = *(const uint32_t*)p2;
+  return (v1 > v2) - (v1 < v2);
+}
+
+static void bench_packet_set(uint8_t l, uint16_t window, uint16_t data_size,
+			     channel_config_t* config)
+{
+  channel_t channel;
+  uint32_t nb_sent, i; /* (one packet is sent per slot) */
+
+  channel_init(&channel, config);
+  current_data_size = data_size;
+  uint32_t nb_received = simulate_flow(l, window, &channel, &nb_sent);
+
+  /* replay */
+  reset_decoded();
+  packet_set_init(&set, l, notify_packet_decoded, packet_set_free_decoded, NULL,
+		  NULL);
+  double start_time = get_time(CLOCK_MONOTONIC);
+  double start_cpu_time = get_time(CLOCK_PROCESS_CPUTIME_ID);
+  for (i=0; i<nb_received; i++) {
+    current_slot = received_slot[i];
+    packet_set_add(&set, &received_table[i], NULL, true);
+  }
+  double cpu_time = get_time(CLOCK_PROCESS_CPUTIME_ID) - start_cpu_time;
+  double time = get_time(CLOCK_MONOTONIC) - start_time;
+
+  if (nb_bad_decoded > 0) {
+    fprintf(stderr, "ERROR: %u bad decoded packets\n", nb_bad_decoded);
+    exit(EXIT_FAILURE);
+  }
+
+  /* delays of the decoded source packets (in sent packets) */
+  uint32_t nb_delay = 0;
+  for (i=0; i<nb_source; i++)
+    if (decoded_slot[i] != UINT32_MAX)
+      delay_table[nb_delay++] = decoded_slot[i] - first_slot[i];
+  qsort(delay_table, nb_delay, sizeof(uint32_t), compare_uint32);
+
+  double nb_byte = (double)nb_decoded * data_size;
+  printf("GF(%3u) window=%2u size=%4u %-9s loss=%4.2f:"
+	 " decoded %5.1f%%, %7.1f MB/s, %6.2f CPU ns/byte,"
+	 " %5.3f sent/source, %5.3f received/decoded,",
+	 1<<(1<<l), window, data_size, 
+	 (config->kind == CHANNEL_BERNOULLI) ? "bernoulli" : "gilbert",
+	 config->loss, 100.0 * nb_decoded / nb_source,
+	 (time > 0) ? nb_byte / time / 1e6 : 0.0,
+	 (nb_byte > 0) ? cpu_time * 1e9 / nb_byte : 0.0,
+	 (double)nb_sent / nb_source, 
+	 (nb_decoded > 0) ? (double)nb_received / nb_decoded : 0.0);
+  if (nb_delay > 0)
+    printf(" delay p50=%u p90=%u p99=%u max=%u\n",
+	   delay_table[nb_delay/2], delay_table[(nb_delay*9)/10],
+	   delay_table[(nb_delay*99)/100], delay_table[nb_delay-1]);
+  else printf(" no delay\n");
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t i, j;
+  uint8_t l;
+  if (argc > 1)
+    seed = strtoull(argv[1], NULL, 0);
+  if (argc > 2)
+    nb_source = atoi(argv[2]);
+  if (argc > 3)
+    burst_length = atof(argv[3]);
+  if (nb_source == 0 || nb_source > MAX_SOURCE || burst_length < 1) {
+    fprintf(stderr, "NB_SOURCE must be between 1 and %u,"
+	    " BURST_LENGTH at least 1\n", MAX_SOURCE);
+    exit(EXIT_FAILURE);
+  }
+  received_table = malloc(sizeof(coded_packet_t) 
+			  * nb_source * MAX_SENT_PER_SOURCE);
+  received_slot = malloc(sizeof(uint32_t) * nb_source * MAX_SENT_PER_SOURCE);
+  if (received_table == NULL || received_slot == NULL) {
+    fprintf(stderr, "ERROR: cannot allocate the coded packets\n");
+    exit(EXIT_FAILURE);
+  }
+
+  coef_generator_t generator;
+  coef_generator_init_stream(&generator, seed, STREAM_SOURCE);
+  for (i=0; i<nb_source; i++) {
+    for (j=0; j<MAX_DATA_SIZE; j++)
+      source_table[i][j] = coef_generator_next(&generator) & 0xff;
+  }
+
+  printf("seed %llu, %u source packets, bursts of %.1f losses,"
+	 " redundancy margin %.2f\n", (unsigned long long)seed, nb_source,
+	 burst_length, REDUNDANCY_MARGIN);
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++)
+    for (i=0; i<NB_WINDOW; i++) {
+      uint16_t window = window_table[i];
+      if (window > (1<<log2_window_size(l)) || window >= MAX_CODED_PACKET
+	  || window > ENCODER_MAX_WINDOW)
+	continue;
+      for (j=0; j<NB_DATA_SIZE; j++) {
+	uint16_t c;
+	if (data_size_table[j] > MAX_DATA_SIZE)
+	  continue;
+	for (c=0; c<NB_CHANNEL; c++)
+	  bench_packet_set(l, window, data_size_table[j], 
+			   (channel_config_t*)&channel_table[c]);
+      }
+    }
+
+  free(received_table);
+  free(received_slot);
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,191 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Latency of packet_set_add for jumbo payloads, with the payload
+ *          operations executed immediately, or on stripes by a pool of
+ *          threads.
+ *
+ * Usage: bench-stripe-pool [MAX_THREAD [STRIPE_SIZE]]
+ *
+ * Built with CONF_CODED_PACKET_SIZE=9216; coded packets of a sliding window
+ * of WINDOW sources in GF(256) are added to a packet set (without loss).
+ * With threads, the programs are executed with the default 
+ * STRIPE_POOL_MIN_PARALLEL_SIZE, then with all programs given to the 
+ * threads ("forced"). The cost of giving one small program to the threads
+ * (starting them, and waiting for them) is measured separately: the 
+ * threads only pay off when the work saved by the other cores is larger.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "stripe-pool.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define L 3
+#define NB_SOURCE 300
+#define DATA_SIZE CODED_PACKET_SIZE
+#define WINDOW 15 /* < header window of GF(256) */
+#define NB_HANDOFF 10000
+
+packet_set_t set;
+payload_program_t program;
+stripe_pool_t pool;
+coded_packet_t source_pkt[WINDOW];
+
+static double get_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void make_source(coded_packet_t* pkt, uint16_t coef_pos)
+{
+  uint16_t j;
+  coded_packet_init(pkt, L);
+  coded_packet_set_coef(pkt, coef_pos, 1);
+  for (j=0; j<DATA_SIZE; j++)
+    coded_packet_data(pkt)[j] = rand() & 0xff;
+  pkt->data_size = DATA_SIZE;
+}
+
+/* nb_thread < 0: payload operations executed immediately */
+static void bench_add(int nb_thread, uint16_t stripe_size, bool is_forced)
+{
+  coded_packet_t pkt;
+  reduction_stat_t stat;
+  double add_time = 0;
+  uint32_t nb_elimination = 0, nb_decoded = 0;
+  uint16_t i, j;
+
+  srand(1);
+  packet_set_init(&set, L, NULL, packet_set_free_decoded, NULL, NULL);
+  if (nb_thread >= 0) {
+    if (!stripe_pool_start(&pool, nb_thread, stripe_size)) {
+      fprintf(stderr, "ERROR: cannot start the pool\n");
+      exit(EXIT_FAILURE);
+    }
+    if (is_forced)
+      pool.min_parallel_size = 0;
+    packet_set_set_payload_executor(&set, &program, stripe_pool_execute, 
+				    &pool);
+  }
+  for (i=0; i<NB_SOURCE; i++) {
+    make_source(&source_pkt[i % WINDOW], i);
+    coded_packet_init(&pkt, L);
+    for (j=0; j<WINDOW && j<=i; j++)
+      coded_packet_add_mult(&pkt, 1 + rand()%255, &source_pkt[(i-j) % WINDOW]);
+    double t = get_time();
+    packet_set_add(&set, &pkt, &stat, true);
+    add_time += get_time() - t;
+    nb_elimination += stat.elimination + stat.reduction_success;
+    nb_decoded += stat.decoded;
+  }
+  if (nb_thread >= 0)
+    stripe_pool_stop(&pool);
+
+  if (nb_thread < 0)
+    printf("immediate:                       ");
+  else printf("%u threads + caller, %5u%s: ", nb_thread, stripe_size,
+	      is_forced ? " forced" : "       ");
+  printf(" %7.1f us/packet, %5.1f row operations/packet, %u/%u decoded",
+	 add_time / NB_SOURCE * 1e6, (double)nb_elimination / NB_SOURCE,
+	 nb_decoded, NB_SOURCE);
+  if (nb_thread >= 0)
+    printf(", %u/%u programs on the threads", pool.stat.nb_parallel, 
+	   pool.stat.nb_program);
+  printf("\n");
+}
+
+/* time of a program of one operation on two stripes, executed by the 
+   calling thread, or given to the threads */
+static void bench_handoff(int nb_thread, uint16_t stripe_size)
+{
+  uint16_t size = MIN(2*stripe_size, DATA_SIZE);
+  double inline_time, thread_time, t;
+  uint32_t i;
+
+  make_source(&source_pkt[0], 0);
+  make_source(&source_pkt[1], 1);
+  payload_program_init(&program, L);
+  coded_packet_deferred_add_mult(&source_pkt[0], 1, &source_pkt[1], &program);
+  program.max_size = size;
+  if (!stripe_pool_start(&pool, nb_thread, stripe_size)) {
+    fprintf(stderr, "ERROR: cannot start the pool\n");
+    exit(EXIT_FAILURE);
+  }
+  t = get_time();
+  for (i=0; i<NB_HANDOFF; i++)
+    stripe_pool_execute(&pool, &program);
+  inline_time = get_time() - t;
+  pool.min_parallel_size = 0;
+  t = get_time();
+  for (i=0; i<NB_HANDOFF; i++)
+    stripe_pool_execute(&pool, &program);
+  thread_time = get_time() - t;
+  stripe_pool_stop(&pool);
+  printf("%u threads + caller, %5u bytes: %7.2f us/program in the caller,"
+	 " %7.2f us/program with the threads\n", nb_thread, size,
+	 inline_time / NB_HANDOFF * 1e6, thread_time / NB_HANDOFF * 1e6);
+}
+
+int main(int argc, char** argv)
+{
+  int max_thread = (argc > 1) ? atoi(argv[1]) : 3;
+  uint16_t stripe_size = (argc > 2) ? atoi(argv[2]) : STRIPE_POOL_STRIPE_SIZE;
+  int nb_thread;
+  if (max_thread < 0 || max_thread > STRIPE_POOL_MAX_THREAD
+      || stripe_size == 0) {
+    fprintf(stderr, "MAX_THREAD must be between 0 and %u\n",
+	    STRIPE_POOL_MAX_THREAD);
+    exit(EXIT_FAILURE);
+  }
+  printf("payload %u bytes, window %u, %ld cores\n", DATA_SIZE, WINDOW,
+	 sysconf(_SC_NPROCESSORS_ONLN));
+  bench_add(-1, stripe_size, false);
+  for (nb_thread=0; nb_thread<=max_thread; nb_thread++) {
+    bench_add(nb_thread, stripe_size, false);
+    if (nb_thread > 0)
+      bench_add(nb_thread, stripe_size, true);
+  }
+  for (nb_thread=1; nb_thread<=max_thread; nb_thread++)
+    bench_handoff(nb_thread, stripe_size);
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
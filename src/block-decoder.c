@@ -0,0 +1,227 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Block decoder of fixed generations (matrix inversion)
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "block-decoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+size_t block_decoder_get_memory_size(uint16_t k, uint16_t data_size)
+{
+  return 2*k*sizeof(uint8_t*) + 2*k*sizeof(uint16_t) 
+    + 2*(size_t)k*k + (size_t)k*data_size;
+}
+
+bool block_decoder_init(block_decoder_t* decoder, uint8_t log2_nb_bit_coef,
+			uint16_t k, uint16_t data_size,
+			void* memory, size_t memory_size)
+{
+  if (log2_nb_bit_coef > MAX_LOG2_NB_BIT_COEF 
+      || k == 0 || k > BLOCK_DECODER_MAX_K
+      || memory_size < block_decoder_get_memory_size(k, data_size))
+    return false;
+  REQUIRE( ((uintptr_t)memory) % sizeof(uint8_t*) == 0 );
+
+  decoder->log2_nb_bit_coef = log2_nb_bit_coef;
+  decoder->k = k;
+  decoder->data_size = data_size;
+  decoder->nb_row = 0;
+
+  /* pointers first, then uint16_t, then bytes: all are aligned */
+  uint8_t* current = memory;
+  decoder->data_table = (uint8_t**)current;
+  current += k*sizeof(uint8_t*);
+  decoder->result_table = (uint8_t**)current;
+  current += k*sizeof(uint8_t*);
+  decoder->col_to_row = (uint16_t*)current;
+  current += k*sizeof(uint16_t);
+  decoder->row_to_col = (uint16_t*)current;
+  current += k*sizeof(uint16_t);
+  decoder->coef_matrix = current;
+  current += (size_t)k*k;
+  decoder->inverse_matrix = current;
+  current += (size_t)k*k;
+  decoder->data = current;
+
+  uint16_t i;
+  for (i=0; i<k; i++) {
+    decoder->data_table[i] = decoder->data + (size_t)i*data_size;
+    decoder->col_to_row[i] = BLOCK_DECODER_NONE;
+  }
+  memset(&decoder->stat, 0, sizeof(decoder->stat));
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* The coefficients of the new packet are in the row `nb_row` of coef_matrix.
+   Invariant: the rows `0..nb_row-1` are in reduced echelon form (each one 
+   has a pivot 1 in a column where all the other rows have 0), and 
+   coef_matrix[r] = sum_j inverse_matrix[r][j] x (coefficients of the
+   received packet j); only the first `nb_row` columns of inverse_matrix 
+   can be non-zero. */
+static bool block_decoder_add_row(block_decoder_t* decoder,
+				  uint8_t* data, uint16_t data_size)
+{
+  uint8_t l = decoder->log2_nb_bit_coef;
+  uint16_t k = decoder->k;
+  uint16_t r = decoder->nb_row;
+  uint8_t* row = decoder->coef_matrix + (size_t)r*k;
+  uint8_t* inverse_row = decoder->inverse_matrix + (size_t)r*k;
+  uint16_t i, col;
+
+  REQUIRE( data_size <= decoder->data_size );
+  decoder->stat.nb_added ++;
+  memset(inverse_row, 0, k);
+  inverse_row[r] = 1;
+
+  /* reduce the new row with the existing ones (in characteristic 2, 
+     subtraction is addition) */
+  for (i=0; i<r; i++) {
+    uint8_t coef = row[decoder->row_to_col[i]];
+    if (coef == 0)
+      continue;
+    lc_vector_mul_add(coef, decoder->coef_matrix + (size_t)i*k, k, l, row);
+    lc_vector_mul_add(coef, decoder->inverse_matrix + (size_t)i*k, r, l,
+		      inverse_row);
+    decoder->stat.nb_header_op ++;
+  }
+
+  for (col=0; col<k; col++)
+    if (row[col] != 0)
+      break;
+  if (col == k) {
+    decoder->stat.nb_redundant ++;
+    return false;
+  }
+  ASSERT( decoder->col_to_row[col] == BLOCK_DECODER_NONE );
+
+  /* normalize, then eliminate the new pivot column from the other rows */
+  uint8_t inv = lc_inv(row[col], l);
+  lc_vector_mul(inv, row, k, l, row);
+  lc_vector_mul(inv, inverse_row, r+1, l, inverse_row);
+  for (i=0; i<r; i++) {
+    uint8_t* other_row = decoder->coef_matrix + (size_t)i*k;
+    uint8_t coef = other_row[col];
+    if (coef == 0)
+      continue;
+    lc_vector_mul_add(coef, row, k, l, other_row);
+    lc_vector_mul_add(coef, inverse_row, r+1, l,
+		      decoder->inverse_matrix + (size_t)i*k);
+    decoder->stat.nb_header_op ++;
+  }
+
+  decoder->col_to_row[col] = r;
+  decoder->row_to_col[r] = col;
+  memcpy(decoder->data_table[r], data, data_size);
+  memset(decoder->data_table[r] + data_size, 0, 
+	 decoder->data_size - data_size);
+  decoder->nb_row ++;
+  return true;
+}
+
+bool block_decoder_add(block_decoder_t* decoder, uint8_t* coef_vector,
+		       uint8_t* data, uint16_t data_size)
+{
+  if (block_decoder_is_complete(decoder))
+    return false;
+  uint8_t l = decoder->log2_nb_bit_coef;
+  uint16_t k = decoder->k;
+  uint16_t vector_size = ((k << l) + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+  uint8_t* row = decoder->coef_matrix + (size_t)decoder->nb_row*k;
+  uint16_t j;
+  for (j=0; j<k; j++)
+    row[j] = lc_vector_get(coef_vector, vector_size, l, j);
+  return block_decoder_add_row(decoder, data, data_size);
+}
+
+bool block_decoder_add_coded_packet(block_decoder_t* decoder,
+				    uint16_t coef_pos_base,
+				    coded_packet_t* pkt)
+{
+  REQUIRE( pkt->log2_nb_bit_coef == decoder->log2_nb_bit_coef );
+  if (block_decoder_is_complete(decoder) || coded_packet_is_empty(pkt))
+    return false;
+  uint16_t k = decoder->k;
+  REQUIRE( (uint16_t)(pkt->coef_pos_min - coef_pos_base) < k
+	   && (uint16_t)(pkt->coef_pos_max - coef_pos_base) < k );
+  uint8_t* row = decoder->coef_matrix + (size_t)decoder->nb_row*k;
+  uint16_t pos;
+  memset(row, 0, k);
+  for (pos=pkt->coef_pos_min; pos != (uint16_t)(pkt->coef_pos_max+1); pos++)
+    row[(uint16_t)(pos - coef_pos_base)] = coded_packet_get_coef(pkt, pos);
+  return block_decoder_add_row(decoder, coded_packet_data(pkt), 
+			       pkt->data_size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void block_decoder_decode(block_decoder_t* decoder, uint8_t** result_table)
+{
+  uint16_t r;
+  REQUIRE( block_decoder_is_complete(decoder) );
+  /* the coefficients are now the identity (up to a permutation of the 
+     rows): the row `r` of inverse_matrix gives the source packet of its
+     pivot column */
+  for (r=0; r<decoder->k; r++)
+    decoder->result_table[r] = result_table[decoder->row_to_col[r]];
+  lc_matrix_mul(decoder->inverse_matrix, decoder->k, decoder->k,
+		decoder->data_table, decoder->data_size,
+		decoder->log2_nb_bit_coef, decoder->result_table);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void block_decoder_pywrite(FILE* out, block_decoder_t* decoder)
+{
+  fprintf(out, "{ 'type':'block-decoder'");
+  fprintf(out, ", 'l':%u", decoder->log2_nb_bit_coef);
+  fprintf(out, ", 'k':%u", decoder->k);
+  fprintf(out, ", 'dataSize':%u", decoder->data_size);
+  fprintf(out, ", 'nbRow':%u", decoder->nb_row);
+  fprintf(out, ", 'stat':{ 'nbAdded':%u", decoder->stat.nb_added);
+  fprintf(out, ", 'nbRedundant':%u", decoder->stat.nb_redundant);
+  fprintf(out, ", 'nbHeaderOp':%u }", decoder->stat.nb_header_op);
+  fprintf(out, " }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
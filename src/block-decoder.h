@@ -0,0 +1,182 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Block decoder of fixed generations (matrix inversion)
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __BLOCK_DECODER_H__
+#define __BLOCK_DECODER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include <stddef.h>
+
+#include "coded-packet.h"
+
+/*---------------------------------------------------------------------------*/
+
+/* Maximum number of source packets of one generation */
+#ifdef CONF_BLOCK_DECODER_MAX_K
+#define BLOCK_DECODER_MAX_K CONF_BLOCK_DECODER_MAX_K
+#else /* CONF_BLOCK_DECODER_MAX_K */
+#define BLOCK_DECODER_MAX_K 1024
+#endif /* CONF_BLOCK_DECODER_MAX_K */
+
+#define BLOCK_DECODER_NONE 0xffffu
+
+/**
+ * @brief block_decoder_stat_t gives statistics about a block decoder.
+ */
+typedef struct {
+  uint32_t nb_added;     /**< rows given to block_decoder_add */
+  uint32_t nb_redundant; /**< rows that were not innovative */
+  uint32_t nb_header_op; /**< row operations on the coefficients */
+} block_decoder_stat_t;
+
+/**
+ * @brief block_decoder_t decodes one generation of `K` source packets, 
+ *        from any `K` linearly independent coded packets.
+ *        Only the coefficients are eliminated when a packet is received
+ *        (incremental Gauss-Jordan, one coefficient per byte): the 
+ *        payloads are kept as received, with the combination of them
+ *        that gives each source packet (the inverse of the coefficient 
+ *        matrix). When the generation is complete, all the source packets 
+ *        are reconstructed with one matrix product over the payloads
+ *        (lc_matrix_mul), instead of the `K^2` row operations on the
+ *        payloads that a packet_set_t would do.
+ * @details The memory (about `2 K^2 + K data_size` bytes) is provided
+ *          by the caller, see block_decoder_get_memory_size.
+ */
+typedef struct {
+  uint8_t log2_nb_bit_coef;
+  uint16_t k;          /**< number of source packets of the generation */
+  uint16_t data_size;  /**< maximum size of the payloads */
+  uint16_t nb_row;     /**< number of innovative packets (rank) */
+
+  uint8_t** data_table;   /**< `k` received payloads, one per row */
+  uint8_t** result_table; /**< used by block_decoder_decode */
+  uint16_t* col_to_row;   /**< row of each pivot column, or BLOCK_DECODER_NONE */
+  uint16_t* row_to_col;   /**< pivot column of each row */
+  uint8_t* coef_matrix;   /**< `k` rows of `k` coefficients, reduced */
+  uint8_t* inverse_matrix;/**< `k` rows of `k` coefficients: row `r` is
+			     a combination of the received payloads */
+  uint8_t* data;          /**< `k` payloads of `data_size` bytes */
+
+  block_decoder_stat_t stat;
+} block_decoder_t;
+
+/**
+ * @brief     Returns the size of the memory needed by a block decoder.
+ * @param[in] k is the number of source packets of the generation
+ * @param[in] data_size is the maximum size of the payloads
+ */
+size_t block_decoder_get_memory_size(uint16_t k, uint16_t data_size);
+
+/**
+ * @brief     Initializes one block decoder for a new generation.
+ * @param[in] decoder is the block decoder
+ * @param[in] log2_nb_bit_coef is the field, as in packet_set_t
+ * @param[in] k is the number of source packets (at most BLOCK_DECODER_MAX_K)
+ * @param[in] data_size is the maximum size of the payloads
+ * @param[in] memory is owned by the caller (e.g. static, or allocated 
+ *            once and reused for every generation), aligned for pointers
+ * @param[in] memory_size is its size, at least 
+ *            block_decoder_get_memory_size(k, data_size)
+ * @return    true on success, false if the parameters are not supported.
+ */
+bool block_decoder_init(block_decoder_t* decoder, uint8_t log2_nb_bit_coef,
+			uint16_t k, uint16_t data_size,
+			void* memory, size_t memory_size);
+
+/**
+ * @brief     Add one coded packet of the generation.
+ * @param[in] decoder is the block decoder
+ * @param[in] coef_vector is its encoding vector: `k` coefficients, packed
+ *            as in lc_vector_get (the source packet `j` is the `j`-th one)
+ * @param[in] data is its payload
+ * @param[in] data_size is the size of the payload (at most the one of the
+ *            decoder; shorter payloads are padded with zeros)
+ * @return    true if the packet was innovative (and kept), false otherwise.
+ */
+bool block_decoder_add(block_decoder_t* decoder, uint8_t* coef_vector,
+		       uint8_t* data, uint16_t data_size);
+
+/**
+ * @brief     Add one coded packet of the generation, e.g. generated by a 
+ *            block_encoder_t, as block_decoder_add.
+ * @param[in] decoder is the block decoder
+ * @param[in] coef_pos_base is the source index of the first source packet
+ *            of the generation
+ * @param[in] pkt is the coded packet (with the same field as the decoder);
+ *            its coefficients must be in the generation
+ * @return    true if the packet was innovative (and kept), false otherwise.
+ */
+bool block_decoder_add_coded_packet(block_decoder_t* decoder,
+				    uint16_t coef_pos_base,
+				    coded_packet_t* pkt);
+
+/**
+ * @brief     Indicates whether `k` innovative packets were received.
+ */
+static inline bool block_decoder_is_complete(block_decoder_t* decoder)
+{ return decoder->nb_row == decoder->k; }
+
+/**
+ * @brief     Reconstruct all the source packets of a complete generation.
+ * @param[in]  decoder is the block decoder
+ * @param[out] result_table is the array of `k` source packets 
+ *             (`data_size` bytes each; disjoint from the memory of the
+ *             decoder)
+ */
+void block_decoder_decode(block_decoder_t* decoder, uint8_t** result_table);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void block_decoder_pywrite(FILE* out, block_decoder_t* decoder);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCK_DECODER_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,100 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Systematic MDS block encoder (Cauchy matrix)
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "block-encoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+bool block_encoder_init(block_encoder_t* encoder, uint8_t log2_nb_bit_coef,
+			uint16_t k, uint16_t m)
+{
+  encoder->log2_nb_bit_coef = 0; /* no matrix yet */
+  encoder->k = 0;
+  encoder->m = 0;
+  return block_encoder_set_params(encoder, log2_nb_bit_coef, k, m);
+}
+
+bool block_encoder_set_params(block_encoder_t* encoder,
+			      uint8_t log2_nb_bit_coef, uint16_t k, uint16_t m)
+{
+  if (log2_nb_bit_coef < 2 || log2_nb_bit_coef > MAX_LOG2_NB_BIT_COEF
+      || k == 0 || k > BLOCK_MAX_K || m > BLOCK_MAX_M
+      || k > (1<<log2_window_size(log2_nb_bit_coef))
+      || k + m > (1<<(1<<log2_nb_bit_coef)))
+    return false;
+  if (encoder->k == k && encoder->m == m
+      && encoder->log2_nb_bit_coef == log2_nb_bit_coef)
+    return true; /* same Cauchy matrix */
+
+  encoder->log2_nb_bit_coef = log2_nb_bit_coef;
+  encoder->k = k;
+  encoder->m = m;
+  /* c[i][j] = 1/(x_i - y_j) with x_i = i and y_j = m + j, all distinct;
+     the subtraction is a XOR (characteristic 2) */
+  uint16_t i, j;
+  for (i=0; i<m; i++)
+    for (j=0; j<k; j++) {
+      uint8_t x = i, y = m + j;
+      encoder->matrix[i*k + j] = lc_inv(x ^ y, log2_nb_bit_coef);
+    }
+  return true;
+}
+
+void block_encoder_generate(block_encoder_t* encoder, uint16_t coef_pos_base,
+			    uint8_t** source_table, uint16_t data_size,
+			    coded_packet_t* repair_table)
+{
+  uint8_t* result_table[BLOCK_MAX_M];
+  uint16_t i, j;
+
+  REQUIRE( data_size <= CODED_PACKET_SIZE );
+  for (i=0; i<encoder->m; i++) {
+    coded_packet_t* pkt = &repair_table[i];
+    coded_packet_init(pkt, encoder->log2_nb_bit_coef);
+    for (j=0; j<encoder->k; j++)
+      coded_packet_set_coef(pkt, coef_pos_base+j,
+			    block_encoder_get_coef(encoder, i, j));
+    pkt->data_size = data_size;
+    result_table[i] = coded_packet_data(pkt);
+  }
+  lc_matrix_mul(encoder->matrix, encoder->m, encoder->k, source_table, 
+		data_size, encoder->log2_nb_bit_coef, result_table);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,131 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Systematic MDS block encoder (Cauchy matrix)
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __BLOCK_ENCODER_H__
+#define __BLOCK_ENCODER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "coded-packet.h"
+
+/*---------------------------------------------------------------------------*/
+
+/* Maximum number of source packets of one block (it is also limited by
+   the window of the encoding vector: 32 for GF(16), 16 for GF(256)) */
+#ifdef CONF_BLOCK_MAX_K
+#define BLOCK_MAX_K CONF_BLOCK_MAX_K
+#else /* CONF_BLOCK_MAX_K */
+#define BLOCK_MAX_K 32
+#endif /* CONF_BLOCK_MAX_K */
+
+/* Maximum number of repair packets of one block */
+#ifdef CONF_BLOCK_MAX_M
+#define BLOCK_MAX_M CONF_BLOCK_MAX_M
+#else /* CONF_BLOCK_MAX_M */
+#define BLOCK_MAX_M 16
+#endif /* CONF_BLOCK_MAX_M */
+
+/**
+ * @brief block_encoder_t generates the `M` repair packets of blocks of 
+ *        `K` source packets (the source packets themselves are sent 
+ *        uncoded). The generator is a Cauchy matrix: any `K` packets 
+ *        among the `K+M` of one block are enough to decode it.
+ *        The matrix is computed once for given (K, M) and reused for
+ *        every block.
+ * @details Only GF(16) and GF(256) are supported, with `K+M` at most 16
+ *          and 256 respectively.
+ */
+typedef struct {
+  uint8_t log2_nb_bit_coef; /**< same as in packet_set_t (2 or 3) */
+  uint16_t k; /**< number of source packets per block */
+  uint16_t m; /**< number of repair packets per block */
+  uint8_t matrix[BLOCK_MAX_M*BLOCK_MAX_K]; /**< Cauchy matrix, `m` rows of `k` coefficients */
+} block_encoder_t;
+
+/**
+ * @brief     Initializes one block encoder, and computes its Cauchy matrix.
+ * @param[in] encoder is the block encoder
+ * @param[in] log2_nb_bit_coef is `2` for GF(16) or `3` for GF(256).
+ * @param[in] k is the number of source packets per block
+ * @param[in] m is the number of repair packets per block
+ * @return    true on success, false if the parameters are not supported.
+ */
+bool block_encoder_init(block_encoder_t* encoder, uint8_t log2_nb_bit_coef,
+			uint16_t k, uint16_t m);
+
+/**
+ * @brief     Changes the parameters of one block encoder, see 
+ *            `block_encoder_init`; the Cauchy matrix is only recomputed 
+ *            if they are different from the current ones.
+ */
+bool block_encoder_set_params(block_encoder_t* encoder,
+			      uint8_t log2_nb_bit_coef, uint16_t k, uint16_t m);
+
+/**
+ * @brief     Returns the coefficient of the source packet `j` in 
+ *            the repair packet `i` of a block.
+ */
+static inline uint8_t block_encoder_get_coef(block_encoder_t* encoder,
+					     uint16_t i, uint16_t j)
+{ return encoder->matrix[i*encoder->k + j]; }
+
+/**
+ * @brief     Generate all the repair packets of one block.
+ * @param[in]  encoder is the block encoder
+ * @param[in]  coef_pos_base is the source index of the first source packet
+ *             of the block (the source packet `j` has index 
+ *             `coef_pos_base+j`).
+ * @param[in]  source_table is the array of the `K` source packets
+ * @param[in]  data_size is the size of the source packets (shorter ones 
+ *             must be padded with zeros by the caller)
+ * @param[out] repair_table is the array of the `M` resulting repair packets
+ */
+void block_encoder_generate(block_encoder_t* encoder, uint16_t coef_pos_base,
+			    uint8_t** source_table, uint16_t data_size,
+			    coded_packet_t* repair_table);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLOCK_ENCODER_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
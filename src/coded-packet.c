@@ -33,12 +33,22 @@
  */
 
 #include "coded-packet.h"
+#include "instrument.h"
 
 /*---------------------------------------------------------------------------*/
 
 void coded_packet_copy_from(coded_packet_t* dst, coded_packet_t* src)
 { memcpy(dst, src, sizeof(*src)); }
 
+void coded_packet_copy_header_from(coded_packet_t* dst, coded_packet_t* src)
+{
+  dst->log2_nb_bit_coef = src->log2_nb_bit_coef;
+  dst->coef_pos_min = src->coef_pos_min;
+  dst->coef_pos_max = src->coef_pos_max;
+  dst->data_size = 0;
+  memcpy(dst->content.u8, src->content.u8, COEF_HEADER_SIZE);
+}
+
 void coded_packet_set_coef(coded_packet_t* pkt, uint16_t coef_pos,
 			   uint8_t coef_value)
 {
@@ -102,6 +112,7 @@ static bool coded_packet_adjust_min_coef(coded_packet_t* pkt)
   bool result = true;
   for (;;) {
     uint16_t i = MOD_LOG2(pkt->coef_pos_min, log2_window);
+    INSTRUMENT_COUNT(INSTRUMENT_ADJUST_STEP, 1);
     if (lc_vector_get(pkt->content.u8, COEF_HEADER_SIZE, l, i) != 0)
       break;
 
@@ -126,6 +137,7 @@ static bool coded_packet_adjust_max_coef(coded_packet_t* pkt)
   bool result = true;
   for(;;) {
     uint16_t i = MOD_LOG2(pkt->coef_pos_max, log2_window);
+    INSTRUMENT_COUNT(INSTRUMENT_ADJUST_STEP, 1);
     if (lc_vector_get(pkt->content.u8, COEF_HEADER_SIZE, l, i) != 0)
       break;
 
@@ -145,6 +157,7 @@ static bool coded_packet_adjust_max_coef(coded_packet_t* pkt)
 bool coded_packet_adjust_min_max_coef(coded_packet_t* pkt)
 {
   bool result = true;
+  INSTRUMENT_COUNT(INSTRUMENT_NB_ADJUST, 1);
   if (pkt->coef_pos_min == COEF_POS_NONE) {
     ASSERT( pkt->coef_pos_max == COEF_POS_NONE );
     result = false;
@@ -260,6 +273,55 @@ void coded_packet_add_mult
   coded_packet_destructive_linear_combination(1, p1, coef2, &p2_copy);
 }
 
+/* p1.header += coef2 x p2.header ; p1 pointer may be equal to p2 pointer */
+void coded_packet_header_add_mult
+(coded_packet_t* p1, uint8_t coef2, coded_packet_t* p2)
+{
+  ASSERT( p1->log2_nb_bit_coef == p2->log2_nb_bit_coef );
+  if (coef2 == 0 || coded_packet_was_empty(p2))
+    return;
+
+  uint8_t header[COEF_HEADER_SIZE];
+  uint16_t header_size;
+  lc_vector_mul(coef2, p2->content.u8, COEF_HEADER_SIZE,
+		p2->log2_nb_bit_coef, header);
+  lc_vector_add(p1->content.u8, COEF_HEADER_SIZE, header, COEF_HEADER_SIZE,
+		p1->content.u8, &header_size);
+
+  p1->coef_pos_min = min_except(p1->coef_pos_min, p2->coef_pos_min,
+				COEF_POS_NONE);
+  p1->coef_pos_max = max_except(p1->coef_pos_max, p2->coef_pos_max,
+				COEF_POS_NONE);
+  ASSERT( p1->coef_pos_max - p1->coef_pos_min 
+	  < (1<<coded_packet_log2_window(p1)) );
+}
+
+bool coded_packet_substitute_decoded(coded_packet_t* pkt,
+				     coded_packet_t* decoded)
+{
+  ASSERT( pkt->log2_nb_bit_coef == decoded->log2_nb_bit_coef );
+  ASSERT( coded_packet_was_decoded(decoded) );
+  uint8_t l = pkt->log2_nb_bit_coef;
+  uint16_t coef_pos = decoded->coef_pos_min;
+  if (coef_pos == COEF_POS_NONE || coef_pos < pkt->coef_pos_min
+      || coef_pos > pkt->coef_pos_max)
+    return false;
+  uint8_t coef = coded_packet_get_coef(pkt, coef_pos);
+  if (coef == 0)
+    return false;
+  ASSERT( coded_packet_get_coef(decoded, coef_pos) == 1 );
+
+  uint8_t data[CODED_PACKET_SIZE];
+  lc_vector_mul(lc_neg(coef, l), coded_packet_data(decoded),
+		decoded->data_size, l, data);
+  lc_vector_add(coded_packet_data(pkt), pkt->data_size,
+		data, decoded->data_size,
+		coded_packet_data(pkt), &pkt->data_size);
+  coded_packet_set_coef(pkt, coef_pos, 0);
+  if (coef_pos == pkt->coef_pos_min || coef_pos == pkt->coef_pos_max)
+    coded_packet_adjust_min_max_coef(pkt);
+  return true;
+}
 
 bool coded_packet_is_empty_safe(coded_packet_t* pkt)
 {
@@ -275,6 +337,126 @@ bool coded_packet_is_empty_safe(coded_packet_t* pkt)
 
 /*---------------------------------------------------------------------------*/
 
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+
+void payload_program_init(payload_program_t* program, 
+			  uint8_t log2_nb_bit_coef)
+{
+  program->nb_op = 0;
+  program->max_size = 0;
+  program->log2_nb_bit_coef = log2_nb_bit_coef;
+}
+
+static void payload_program_append(payload_program_t* program, uint8_t kind,
+				   uint8_t* dst, uint16_t dst_size,
+				   uint8_t coef, uint8_t* src, 
+				   uint16_t src_size)
+{
+  REQUIRE( !payload_program_is_full(program) );
+  payload_op_t* op = &program->op[program->nb_op];
+  op->dst = dst;
+  op->src = src;
+  op->dst_size = dst_size;
+  op->src_size = src_size;
+  op->coef = coef;
+  op->kind = kind;
+  program->nb_op ++;
+  program->max_size = MAX(program->max_size, MAX(dst_size, src_size));
+}
+
+void payload_program_execute(payload_program_t* program,
+			     uint16_t start, uint16_t end)
+{
+  uint8_t l = program->log2_nb_bit_coef;
+  uint16_t i;
+  for (i=0; i<program->nb_op; i++) {
+    payload_op_t* op = &program->op[i];
+    uint16_t common_end = MIN(end, MIN(op->dst_size, op->src_size));
+    uint16_t src_end = MIN(end, op->src_size);
+    switch (op->kind) {
+    case PAYLOAD_OP_MUL_ADD:
+      /* beyond the payload of dst, its bytes are considered to be `0` */
+      if (start < common_end)
+	lc_vector_mul_add(op->coef, op->src + start, common_end - start, l,
+			  op->dst + start);
+      if (MAX(start, common_end) < src_end)
+	lc_vector_mul(op->coef, op->src + MAX(start, common_end),
+		      src_end - MAX(start, common_end), l, 
+		      op->dst + MAX(start, common_end));
+      break;
+    case PAYLOAD_OP_MUL:
+      if (start < MIN(end, op->dst_size))
+	lc_vector_mul(op->coef, op->dst + start, 
+		      MIN(end, op->dst_size) - start, l, op->dst + start);
+      break;
+    case PAYLOAD_OP_COPY:
+      if (start < src_end)
+	memcpy(op->dst + start, op->src + start, src_end - start);
+      break;
+    default:
+      FATAL("unknown payload operation %u", op->kind);
+    }
+  }
+}
+
+void coded_packet_deferred_add_mult(coded_packet_t* p1, uint8_t coef2, 
+				    coded_packet_t* p2,
+				    payload_program_t* program)
+{
+  coded_packet_header_add_mult(p1, coef2, p2);
+  payload_program_append(program, PAYLOAD_OP_MUL_ADD, coded_packet_data(p1),
+			 p1->data_size, coef2, coded_packet_data(p2),
+			 p2->data_size);
+  p1->data_size = MAX(p1->data_size, p2->data_size);
+}
+
+void coded_packet_deferred_to_mul(coded_packet_t* pkt, uint8_t coef,
+				  payload_program_t* program)
+{
+  lc_vector_mul(coef, pkt->content.u8, COEF_HEADER_SIZE,
+		pkt->log2_nb_bit_coef, pkt->content.u8);
+  payload_program_append(program, PAYLOAD_OP_MUL, coded_packet_data(pkt),
+			 pkt->data_size, coef, NULL, 0);
+}
+
+bool coded_packet_deferred_substitute_decoded(coded_packet_t* pkt,
+					      coded_packet_t* decoded,
+					      payload_program_t* program)
+{
+  ASSERT( pkt->log2_nb_bit_coef == decoded->log2_nb_bit_coef );
+  ASSERT( coded_packet_was_decoded(decoded) );
+  uint8_t l = pkt->log2_nb_bit_coef;
+  uint16_t coef_pos = decoded->coef_pos_min;
+  if (coef_pos == COEF_POS_NONE || coef_pos < pkt->coef_pos_min
+      || coef_pos > pkt->coef_pos_max)
+    return false;
+  uint8_t coef = coded_packet_get_coef(pkt, coef_pos);
+  if (coef == 0)
+    return false;
+
+  payload_program_append(program, PAYLOAD_OP_MUL_ADD, coded_packet_data(pkt),
+			 pkt->data_size, lc_neg(coef, l),
+			 coded_packet_data(decoded), decoded->data_size);
+  pkt->data_size = MAX(pkt->data_size, decoded->data_size);
+  coded_packet_set_coef(pkt, coef_pos, 0);
+  if (coef_pos == pkt->coef_pos_min || coef_pos == pkt->coef_pos_max)
+    coded_packet_adjust_min_max_coef(pkt);
+  return true;
+}
+
+void coded_packet_deferred_copy_from(coded_packet_t* dst, coded_packet_t* src,
+				     payload_program_t* program)
+{
+  coded_packet_copy_header_from(dst, src);
+  dst->data_size = src->data_size;
+  payload_program_append(program, PAYLOAD_OP_COPY, coded_packet_data(dst),
+			 0, 0, coded_packet_data(src), src->data_size);
+}
+
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+
+/*---------------------------------------------------------------------------*/
+
 #ifdef CONF_WITH_FPRINTF
 void coded_packet_pywrite(FILE* out, coded_packet_t* p)
 { 
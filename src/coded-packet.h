@@ -136,6 +136,14 @@ void coded_packet_init_from_base_packet
  */
 void coded_packet_copy_from(coded_packet_t* dst, coded_packet_t* src);
 
+/**
+ * @brief Copy only the encoding vector of a given coded packet
+ * @param[out] dst is the place where the encoding vector is copied (its
+ *             coded payload is left empty, e.g. `data_size` is `0`)
+ * @param[in]  src is the coded packet whose encoding vector is copied
+ */
+void coded_packet_copy_header_from(coded_packet_t* dst, coded_packet_t* src);
+
 /**
  * @brief Set the value of one coefficient in the encoding header. 
  *          (XXX:constraints)
@@ -239,6 +247,31 @@ void coded_packet_to_add(coded_packet_t* result,
 void coded_packet_add_mult
 (coded_packet_t* p1, uint8_t coef2, coded_packet_t* p2);
 
+/**
+ * @brief Same as `coded_packet_add_mult` but restricted to the encoding
+ *        vectors: p1.header += coef * p2.header (the coded payload of p1
+ *        is not read nor modified).
+ * @param[in,out] p1     First coded packet (to which coef*p2 will be added)
+ * @param[in]     coef2  Coefficient by which the second packet is multiplied
+ * @param[in]     p2     Second coded packet
+ */
+void coded_packet_header_add_mult
+(coded_packet_t* p1, uint8_t coef2, coded_packet_t* p2);
+
+/**
+ * @brief Substitute one decoded source packet in a coded packet, e.g.
+ *        performs p -= coef * decoded, where coef is the coefficient of p
+ *        for the source packet. Since the encoding vector of `decoded` is a
+ *        unit vector, only the payload is combined, and one coefficient
+ *        of `pkt` is cleared.
+ * @param[in,out] pkt     The coded packet
+ * @param[in]     decoded A decoded packet (with coefficient `1`)
+ * @return        true if `pkt` was modified (it had a non-zero coefficient
+ *                for the decoded source packet), false otherwise
+ */
+bool coded_packet_substitute_decoded(coded_packet_t* pkt,
+				     coded_packet_t* decoded);
+
 bool coded_packet_is_empty_safe(coded_packet_t* pkt);
 
 #ifdef CONF_WITH_FPRINTF
@@ -254,6 +287,95 @@ bool coded_packet_is_similar(coded_packet_t* p1, coded_packet_t* p2);
 
 /*---------------------------------------------------------------------------*/
 
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+
+/* Maximum number of operations of a payload program */
+#ifdef CONF_PAYLOAD_PROGRAM_MAX_OP
+#define PAYLOAD_PROGRAM_MAX_OP CONF_PAYLOAD_PROGRAM_MAX_OP
+#else /* CONF_PAYLOAD_PROGRAM_MAX_OP */
+#define PAYLOAD_PROGRAM_MAX_OP 64
+#endif /* CONF_PAYLOAD_PROGRAM_MAX_OP */
+
+#define PAYLOAD_OP_MUL_ADD 0 /**< dst += coef x src */
+#define PAYLOAD_OP_MUL     1 /**< dst = coef x dst */
+#define PAYLOAD_OP_COPY    2 /**< dst = src */
+
+/**
+ * @brief payload_op_t is one operation on the coded payloads (without 
+ *        the encoding vectors) of coded packets.
+ */
+typedef struct {
+  uint8_t* dst;
+  uint8_t* src;       /**< NULL for PAYLOAD_OP_MUL */
+  uint16_t dst_size;  /**< data_size of the destination before the operation */
+  uint16_t src_size;  /**< */
+  uint8_t coef;
+  uint8_t kind;       /**< PAYLOAD_OP_... */
+} payload_op_t;
+
+/**
+ * @brief payload_program_t is a sequence of operations on coded payloads,
+ *        recorded while the operations on the encoding vectors are done.
+ *        Each byte of the payloads only depends on the bytes at the same
+ *        offset, so the program can be executed on separate ranges of 
+ *        offsets (stripes) independently, e.g. by several threads.
+ */
+typedef struct {
+  payload_op_t op[PAYLOAD_PROGRAM_MAX_OP];
+  uint16_t nb_op;
+  uint16_t max_size;  /**< end of the highest range of offsets written */
+  uint8_t log2_nb_bit_coef;
+} payload_program_t;
+
+/**
+ * @brief Initialize an empty payload program.
+ */
+void payload_program_init(payload_program_t* program, 
+			  uint8_t log2_nb_bit_coef);
+
+static inline bool payload_program_is_full(payload_program_t* program)
+{ return program->nb_op == PAYLOAD_PROGRAM_MAX_OP; }
+
+/**
+ * @brief Execute all the operations of a program, restricted to the offsets
+ *        in [start, end) of the payloads.
+ */
+void payload_program_execute(payload_program_t* program,
+			     uint16_t start, uint16_t end);
+
+/**
+ * @brief Same as `coded_packet_add_mult` for the encoding vector and 
+ *        data_size of p1; the operation on its payload is appended to 
+ *        `program` (which must not be full).
+ */
+void coded_packet_deferred_add_mult(coded_packet_t* p1, uint8_t coef2, 
+				    coded_packet_t* p2,
+				    payload_program_t* program);
+
+/**
+ * @brief Same as `coded_packet_to_mul`, with a deferred payload operation.
+ */
+void coded_packet_deferred_to_mul(coded_packet_t* pkt, uint8_t coef,
+				  payload_program_t* program);
+
+/**
+ * @brief Same as `coded_packet_substitute_decoded`, with a deferred payload
+ *        operation.
+ */
+bool coded_packet_deferred_substitute_decoded(coded_packet_t* pkt,
+					      coded_packet_t* decoded,
+					      payload_program_t* program);
+
+/**
+ * @brief Same as `coded_packet_copy_from`, with a deferred payload copy.
+ */
+void coded_packet_deferred_copy_from(coded_packet_t* dst, coded_packet_t* src,
+				     payload_program_t* program);
+
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+
+/*---------------------------------------------------------------------------*/
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,210 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Deterministic generator of random coefficients
+ */
+
+#include <stdint.h>
+
+#include "general.h"
+#include "linear-code.h"
+#include "coef-generator.h"
+
+/*---------------------------------------------------------------------------*/
+
+/* splitmix64, used for seeding and for counter-based generation */
+static uint64_t splitmix64(uint64_t* x)
+{
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+void coef_generator_init(coef_generator_t* generator, uint64_t seed)
+{
+  uint64_t x = seed;
+  uint64_t z = splitmix64(&x);
+  generator->state[0] = (uint32_t)z;
+  generator->state[1] = (uint32_t)(z >> 32);
+  z = splitmix64(&x);
+  generator->state[2] = (uint32_t)z;
+  generator->state[3] = (uint32_t)(z >> 32);
+  /* (the state is never all zero, since splitmix64 is a bijection 
+     of successive distinct values) */
+}
+
+void coef_generator_init_stream(coef_generator_t* generator, uint64_t seed,
+				uint32_t stream_id)
+{
+  uint64_t x = seed ^ ((uint64_t)stream_id << 32 | stream_id);
+  coef_generator_init(generator, splitmix64(&x));
+}
+
+static inline uint32_t rotl32(uint32_t x, int k)
+{ return (x << k) | (x >> (32 - k)); }
+
+/* xoshiro128** */
+uint32_t coef_generator_next(coef_generator_t* generator)
+{
+  uint32_t* s = generator->state;
+  uint32_t result = rotl32(s[1] * 5, 7) * 9;
+  uint32_t t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl32(s[3], 11);
+  return result;
+}
+
+void coef_generator_fill(coef_generator_t* generator, uint8_t log2_nb_bit_coef,
+			 uint8_t* coef_table, uint16_t nb_coef, uint8_t flags)
+{
+  ASSERT( log2_nb_bit_coef <= MAX_LOG2_NB_BIT_COEF );
+  uint8_t nb_bit = 1<<log2_nb_bit_coef;
+  uint8_t mask = MASK(nb_bit);
+  uint32_t bits = 0;
+  uint8_t nb_available = 0; /* coefficients left in `bits` */
+  uint16_t i;
+
+  if (nb_bit == 1 && (flags & COEF_GENERATOR_NONZERO) != 0) {
+    for (i=0; i<nb_coef; i++)
+      coef_table[i] = 1;
+    return;
+  }
+
+  for (i=0; i<nb_coef; i++) {
+    bool is_nonzero = ((flags & COEF_GENERATOR_NONZERO) != 0)
+      || (i == nb_coef-1 && (flags & COEF_GENERATOR_LEADING_NONZERO) != 0);
+    uint8_t coef;
+    do {
+      if (nb_available == 0) {
+	bits = coef_generator_next(generator);
+	nb_available = 32 >> log2_nb_bit_coef;
+      }
+      coef = bits & mask;
+      bits >>= nb_bit;
+      nb_available --;
+    } while (is_nonzero && coef == 0);
+    coef_table[i] = coef;
+  }
+}
+
+void coef_generator_fill_packet(coef_generator_t* generator,
+				coded_packet_t* pkt, uint16_t coef_pos_min,
+				uint16_t nb_coef, uint8_t flags)
+{
+  uint8_t l = pkt->log2_nb_bit_coef;
+  ASSERT( l <= MAX_LOG2_NB_BIT_COEF );
+  REQUIRE( coded_packet_was_empty(pkt) );
+  uint16_t log2_window = coded_packet_log2_window(pkt);
+  REQUIRE( nb_coef <= (1<<log2_window) );
+  if (nb_coef == 0)
+    return;
+  uint8_t nb_bit = 1<<l;
+  uint8_t mask = MASK(nb_bit);
+  uint8_t log2_coef_per_byte = LOG2_BITS_PER_BYTE - l;
+  uint8_t coef_per_draw = 32 >> l;
+  uint8_t* header = pkt->content.u8;
+  uint32_t bits = 0;
+  uint8_t nb_available = 0; /* coefficients left in `bits` */
+  uint16_t i = 0;
+
+  if (nb_bit == 1 && (flags & COEF_GENERATOR_NONZERO) != 0) {
+    for (i=0; i<nb_coef; i++)
+      coded_packet_set_coef(pkt, coef_pos_min + i, 1);
+    return;
+  }
+
+  while (i < nb_coef) {
+    uint16_t slot = MOD_LOG2(coef_pos_min + i, log2_window);
+    /* a whole draw, if it is used as it is (in the same order as in
+       coef_generator_fill): the next 32 bits of the header */
+    if (nb_available == 0 && (flags & COEF_GENERATOR_NONZERO) == 0
+	&& MOD_LOG2(slot, log2_coef_per_byte) == 0
+	&& slot + coef_per_draw <= (1<<log2_window)
+	&& (i + coef_per_draw < nb_coef
+	    || (i + coef_per_draw == nb_coef
+		&& (flags & COEF_GENERATOR_LEADING_NONZERO) == 0))) {
+      uint32_t draw = coef_generator_next(generator);
+      uint8_t* dst = header + DIV_LOG2(slot, log2_coef_per_byte);
+      dst[0] = draw & 0xff;
+      dst[1] = (draw >> 8) & 0xff;
+      dst[2] = (draw >> 16) & 0xff;
+      dst[3] = draw >> 24;
+      i += coef_per_draw;
+      continue;
+    }
+
+    bool is_nonzero = ((flags & COEF_GENERATOR_NONZERO) != 0)
+      || (i == nb_coef-1 && (flags & COEF_GENERATOR_LEADING_NONZERO) != 0);
+    uint8_t coef;
+    do {
+      if (nb_available == 0) {
+	bits = coef_generator_next(generator);
+	nb_available = coef_per_draw;
+      }
+      coef = bits & mask;
+      bits >>= nb_bit;
+      nb_available --;
+    } while (is_nonzero && coef == 0);
+    header[DIV_LOG2(slot, log2_coef_per_byte)] |=
+      coef << MUL_LOG2(MOD_LOG2(slot, log2_coef_per_byte), l);
+    i ++;
+  }
+
+  pkt->coef_pos_min = coef_pos_min;
+  pkt->coef_pos_max = coef_pos_min + nb_coef - 1;
+  coded_packet_adjust_min_max_coef(pkt);
+}
+
+uint8_t coef_generator_get_coef(uint64_t seed, uint32_t index,
+				uint8_t log2_nb_bit_coef, uint8_t flags)
+{
+  ASSERT( log2_nb_bit_coef <= MAX_LOG2_NB_BIT_COEF );
+  uint8_t nb_bit = 1<<log2_nb_bit_coef;
+  uint8_t mask = MASK(nb_bit);
+  uint64_t x = seed ^ ((uint64_t)index * 0xd1b54a32d192ed03ull);
+  for (;;) {
+    uint64_t bits = splitmix64(&x);
+    uint8_t i;
+    for (i=0; i<64; i+=nb_bit) {
+      uint8_t coef = (bits >> i) & mask;
+      if (coef != 0 || (flags & COEF_GENERATOR_NONZERO) == 0)
+	return coef;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,137 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Deterministic generator of random coefficients
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __COEF_GENERATOR_H__
+#define __COEF_GENERATOR_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "coded-packet.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define COEF_GENERATOR_NONZERO         0x1 /**< no coefficient is `0` */
+#define COEF_GENERATOR_LEADING_NONZERO 0x2 /**< the last coefficient (for the highest source index) is not `0` */
+
+/**
+ * @brief coef_generator_t is a pseudo-random generator (xoshiro128**),
+ *        entirely determined by its seed, which produces coefficients 
+ *        of GF(2), GF(4), GF(16) or GF(256).
+ */
+typedef struct {
+  uint32_t state[4];
+} coef_generator_t;
+
+/**
+ * @brief     Initializes one generator from a seed.
+ * @param[in] generator is the generator
+ * @param[in] seed is the seed: the same seed yields the same sequence.
+ */
+void coef_generator_init(coef_generator_t* generator, uint64_t seed);
+
+/**
+ * @brief     Initializes one generator for one stream of a given seed, 
+ *            e.g. for one packet (`stream_id` being its sequence number)
+ *            so that its coefficients can be regenerated from 
+ *            (`seed`, `stream_id`) only.
+ */
+void coef_generator_init_stream(coef_generator_t* generator, uint64_t seed,
+				uint32_t stream_id);
+
+/**
+ * @brief     Returns the next 32 random bits.
+ */
+uint32_t coef_generator_next(coef_generator_t* generator);
+
+/**
+ * @brief      Fill an array with random coefficients (one per byte)
+ *             of GF(\f$2^{(2^L)}\f$) where `L = log2_nb_bit_coef`.
+ *             Each draw of 32 bits gives several coefficients 
+ *             (e.g. 32 coefficients of GF(2), 4 of GF(256)).
+ * @param[in]  generator is the generator
+ * @param[in]  log2_nb_bit_coef specifies the finite field
+ * @param[out] coef_table is the array of coefficients
+ * @param[in]  nb_coef is the number of coefficients
+ * @param[in]  flags is a combination of COEF_GENERATOR_NONZERO and 
+ *             COEF_GENERATOR_LEADING_NONZERO (or `0`)
+ */
+void coef_generator_fill(coef_generator_t* generator, uint8_t log2_nb_bit_coef,
+			 uint8_t* coef_table, uint16_t nb_coef, uint8_t flags);
+
+/**
+ * @brief      Fill the encoding vector of a coded packet with random 
+ *             coefficients for the source indices `coef_pos_min` to 
+ *             `coef_pos_min+nb_coef-1`: they are the ones that 
+ *             coef_generator_fill would give, but they are written 
+ *             directly in the header, a whole draw of 32 bits at once 
+ *             when it starts on a byte and has no coefficient to redraw.
+ * @param[in]  generator is the generator
+ * @param[in,out] pkt is the coded packet, its encoding vector must be
+ *             empty (e.g. after coded_packet_init); its finite field is used
+ * @param[in]  coef_pos_min is the first source index
+ * @param[in]  nb_coef is the number of coefficients, at most the window of
+ *             the encoding vector
+ * @param[in]  flags as for coef_generator_fill
+ */
+void coef_generator_fill_packet(coef_generator_t* generator,
+				coded_packet_t* pkt, uint16_t coef_pos_min,
+				uint16_t nb_coef, uint8_t flags);
+
+/**
+ * @brief     Counter-based generation: returns the coefficient `index` for 
+ *            a given seed, without any state (random access).
+ * @param[in] seed is the seed
+ * @param[in] index is the index of the coefficient
+ * @param[in] log2_nb_bit_coef specifies the finite field
+ * @param[in] flags is `0` or COEF_GENERATOR_NONZERO
+ */
+uint8_t coef_generator_get_coef(uint64_t seed, uint32_t index,
+				uint8_t log2_nb_bit_coef, uint8_t flags);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COEF_GENERATOR_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,136 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Decoding in a separate thread, fed by a lock-free ring
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "decode-pipeline.h"
+
+#ifdef CONF_WITH_PTHREAD
+
+/*---------------------------------------------------------------------------*/
+
+/* decoder thread: the decoded packet is copied to the ring of decoded 
+   packets (waiting for the receiving thread if it is full) */
+static void decode_pipeline_notify(packet_set_t* set, uint16_t packet_id)
+{
+  decode_pipeline_t* pipeline = set->notif_data;
+  decode_pipeline_entry_t* entry 
+    = spsc_ring_reserve_wait(&pipeline->decoded_ring);
+  entry->flow_id = decoder_manager_get_flow_id(set);
+  entry->now = ((decoder_flow_t*)set)->last_time;
+  coded_packet_copy_from(&entry->pkt, &set->coded_packet[packet_id]);
+  spsc_ring_commit(&pipeline->decoded_ring);
+}
+
+/* decoder thread: sleeps while there is no coded packet, and closes the
+   ring of decoded packets once the ring of coded packets is closed */
+static void* decode_pipeline_run(void* arg)
+{
+  decode_pipeline_t* pipeline = arg;
+  decode_pipeline_entry_t* entry;
+  while ((entry = spsc_ring_peek_wait(&pipeline->packet_ring)) != NULL) {
+    decoder_manager_add(&pipeline->manager, entry->flow_id, entry->now,
+			&entry->pkt, NULL);
+    decoder_manager_evict_idle(&pipeline->manager, entry->now);
+    spsc_ring_release(&pipeline->packet_ring);
+  }
+  spsc_ring_close(&pipeline->decoded_ring);
+  return NULL;
+}
+
+bool decode_pipeline_start(decode_pipeline_t* pipeline,
+			   uint8_t log2_nb_bit_coef, uint32_t idle_timeout)
+{
+  spsc_ring_init(&pipeline->packet_ring, pipeline->packet_entry,
+		 sizeof(decode_pipeline_entry_t), DECODE_PIPELINE_RING_SIZE);
+  spsc_ring_init(&pipeline->decoded_ring, pipeline->decoded_entry,
+		 sizeof(decode_pipeline_entry_t), 
+		 DECODE_PIPELINE_DECODED_RING_SIZE);
+  decoder_manager_init(&pipeline->manager, pipeline->flow_table,
+		       DECODE_PIPELINE_NB_FLOW, idle_timeout, log2_nb_bit_coef,
+		       decode_pipeline_notify, packet_set_free_decoded, NULL,
+		       pipeline);
+  if (pthread_create(&pipeline->thread, NULL, 
+		     decode_pipeline_run, pipeline) != 0) {
+    WARN("cannot start the decoder thread");
+    return false;
+  }
+  return true;
+}
+
+/* reads the decoded packets while the decoder thread finishes, so that it
+   never waits forever for room in the ring of decoded packets */
+void decode_pipeline_stop(decode_pipeline_t* pipeline,
+			  decode_pipeline_decoded_func_t decoded_func,
+			  void* data)
+{
+  spsc_ring_close(&pipeline->packet_ring);
+  decode_pipeline_entry_t* entry;
+  while ((entry = spsc_ring_peek_wait(&pipeline->decoded_ring)) != NULL) {
+    if (decoded_func != NULL)
+      decoded_func(data, entry);
+    decode_pipeline_release_decoded(pipeline);
+  }
+  pthread_join(pipeline->thread, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void decode_pipeline_pywrite(FILE* out, decode_pipeline_t* pipeline)
+{
+  spsc_ring_stat_t stat;
+  fprintf(out, "{ 'type':'decode-pipeline'");
+  fprintf(out, ", 'packetRing':");
+  spsc_ring_get_stat(&pipeline->packet_ring, &stat);
+  spsc_ring_stat_pywrite(out, &stat);
+  fprintf(out, ", 'decodedRing':");
+  spsc_ring_get_stat(&pipeline->decoded_ring, &stat);
+  spsc_ring_stat_pywrite(out, &stat);
+  fprintf(out, ", 'manager':");
+  decoder_manager_stat_pywrite(out, &pipeline->manager.stat);
+  fprintf(out, " }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
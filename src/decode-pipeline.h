@@ -0,0 +1,193 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Decoding in a separate thread, fed by a lock-free ring
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __DECODE_PIPELINE_H__
+#define __DECODE_PIPELINE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "decoder-manager.h"
+#include "spsc-ring.h"
+
+#ifdef CONF_WITH_PTHREAD
+
+#include <pthread.h>
+
+/*---------------------------------------------------------------------------*/
+
+/* Number of coded packets in the ring to the decoder thread (a power of 2) */
+#ifdef CONF_DECODE_PIPELINE_RING_SIZE
+#define DECODE_PIPELINE_RING_SIZE CONF_DECODE_PIPELINE_RING_SIZE
+#else /* CONF_DECODE_PIPELINE_RING_SIZE */
+#define DECODE_PIPELINE_RING_SIZE 256
+#endif /* CONF_DECODE_PIPELINE_RING_SIZE */
+
+/* Number of decoded packets in the ring from the decoder thread 
+   (a power of 2) */
+#ifdef CONF_DECODE_PIPELINE_DECODED_RING_SIZE
+#define DECODE_PIPELINE_DECODED_RING_SIZE CONF_DECODE_PIPELINE_DECODED_RING_SIZE
+#else /* CONF_DECODE_PIPELINE_DECODED_RING_SIZE */
+#define DECODE_PIPELINE_DECODED_RING_SIZE 256
+#endif /* CONF_DECODE_PIPELINE_DECODED_RING_SIZE */
+
+/* Size of the pool of flows of the decoder thread */
+#ifdef CONF_DECODE_PIPELINE_NB_FLOW
+#define DECODE_PIPELINE_NB_FLOW CONF_DECODE_PIPELINE_NB_FLOW
+#else /* CONF_DECODE_PIPELINE_NB_FLOW */
+#define DECODE_PIPELINE_NB_FLOW 16
+#endif /* CONF_DECODE_PIPELINE_NB_FLOW */
+
+/**
+ * @brief decode_pipeline_entry_t is one entry of the rings of a pipeline:
+ *        a coded packet of a flow, or a decoded packet of a flow.
+ */
+typedef struct {
+  uint32_t flow_id;
+  uint32_t now;       /**< time of reception, see decoder_manager_get_set */
+  coded_packet_t pkt;
+} decode_pipeline_entry_t;
+
+/**
+ * @brief Function called for the decoded packets left when the pipeline
+ *        is stopped.
+ */
+typedef void (*decode_pipeline_decoded_func_t)(void* data,
+					       decode_pipeline_entry_t* entry);
+
+/**
+ * @brief decode_pipeline_t decouples the reception of coded packets from
+ *        their decoding: the receiving thread puts the coded packets in a
+ *        lock-free ring, and a decoder thread adds them to the packet set 
+ *        of their flow (with a decoder manager); the decoded packets are
+ *        put back in a second ring, read by the receiving thread.
+ *
+ *        The entries of the rings are used in place: the receiving thread
+ *        can build the coded packet directly in the ring, and the decoder
+ *        adds it to the packet set from there.
+ *
+ *        The decoder thread sleeps while there is no coded packet (after 
+ *        SPSC_RING_NB_POLL polls), and is woken by decode_pipeline_commit.
+ */
+typedef struct {
+  spsc_ring_t packet_ring;  /**< from the receiving thread to the decoder */
+  decode_pipeline_entry_t packet_entry[DECODE_PIPELINE_RING_SIZE];
+  spsc_ring_t decoded_ring; /**< from the decoder to the receiving thread */
+  decode_pipeline_entry_t decoded_entry[DECODE_PIPELINE_DECODED_RING_SIZE];
+
+  /* only used by the decoder thread */
+  decoder_manager_t manager;
+  decoder_flow_t flow_table[DECODE_PIPELINE_NB_FLOW];
+
+  pthread_t thread;
+} decode_pipeline_t;
+
+/**
+ * @brief     Initialize a pipeline and start its decoder thread.
+ * @param[in] pipeline is the pipeline (large: e.g. static, or allocated once)
+ * @param[in] log2_nb_bit_coef is the field of the coded packets
+ * @param[in] idle_timeout is given to the decoder manager
+ * @return    true on success, false if the thread could not be started.
+ */
+bool decode_pipeline_start(decode_pipeline_t* pipeline,
+			   uint8_t log2_nb_bit_coef, uint32_t idle_timeout);
+
+/**
+ * @brief     Receiving thread: returns a free entry, where the flow id and 
+ *            coded packet are written before decode_pipeline_commit; or 
+ *            NULL if the ring is full (the decoder is late).
+ */
+static inline decode_pipeline_entry_t* decode_pipeline_reserve
+(decode_pipeline_t* pipeline)
+{ return spsc_ring_reserve(&pipeline->packet_ring); }
+
+/**
+ * @brief     Receiving thread: passes the entry of the last
+ *            decode_pipeline_reserve to the decoder thread.
+ */
+static inline void decode_pipeline_commit(decode_pipeline_t* pipeline)
+{ spsc_ring_commit(&pipeline->packet_ring); }
+
+/**
+ * @brief     Receiving thread: returns the oldest decoded packet (and its
+ *            flow id), or NULL if there is none. It stays valid until 
+ *            decode_pipeline_release_decoded.
+ *
+ *            The decoder thread waits when the ring of decoded packets 
+ *            is full, so they should be read regularly.
+ */
+static inline decode_pipeline_entry_t* decode_pipeline_peek_decoded
+(decode_pipeline_t* pipeline)
+{ return spsc_ring_peek(&pipeline->decoded_ring); }
+
+static inline void decode_pipeline_release_decoded
+(decode_pipeline_t* pipeline)
+{ spsc_ring_release(&pipeline->decoded_ring); }
+
+/**
+ * @brief     Receiving thread: wait until the decoder thread has processed
+ *            all the coded packets, and stop it.
+ * @param[in] pipeline is the pipeline
+ * @param[in] decoded_func is called for each decoded packet that was not
+ *            read yet (can be NULL)
+ * @param[in] data is given to decoded_func
+ */
+void decode_pipeline_stop(decode_pipeline_t* pipeline,
+			  decode_pipeline_decoded_func_t decoded_func,
+			  void* data);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void decode_pipeline_pywrite(FILE* out, decode_pipeline_t* pipeline);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DECODE_PIPELINE_H__ */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,265 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Decoding of many flows, with a pool of packet sets
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "decoder-manager.h"
+
+/*---------------------------------------------------------------------------*/
+
+static inline uint16_t decoder_manager_hash(uint32_t flow_id)
+{ return (flow_id * 2654435761u) >> 16 & (DECODER_MANAGER_NB_BUCKET-1); }
+
+void decoder_manager_init(decoder_manager_t* manager,
+			  decoder_flow_t* flow_table, uint16_t nb_flow,
+			  uint32_t idle_timeout, uint8_t log2_nb_bit_coef,
+			  notify_packet_decoded_func_t notify_packet_decoded_func,
+			  notify_set_full_func_t notify_set_full_func,
+			  get_decoded_packet_func_t get_decoded_packet_func,
+			  void* notif_data)
+{
+  uint16_t i;
+  REQUIRE( nb_flow > 0 && nb_flow < FLOW_INDEX_NONE );
+  REQUIRE( (DECODER_MANAGER_NB_BUCKET & (DECODER_MANAGER_NB_BUCKET-1)) == 0 );
+  manager->flow_table = flow_table;
+  manager->nb_flow = nb_flow;
+  for (i=0; i<DECODER_MANAGER_NB_BUCKET; i++)
+    manager->bucket[i] = FLOW_INDEX_NONE;
+  for (i=0; i<nb_flow; i++) {
+    flow_table[i].is_used = false;
+    flow_table[i].next_index = (i+1 < nb_flow) ? i+1 : FLOW_INDEX_NONE;
+  }
+  manager->free_index = 0;
+  manager->lru_first = FLOW_INDEX_NONE;
+  manager->lru_last = FLOW_INDEX_NONE;
+  manager->idle_timeout = idle_timeout;
+
+  manager->log2_nb_bit_coef = log2_nb_bit_coef;
+  manager->notify_packet_decoded_func = notify_packet_decoded_func;
+  manager->notify_set_full_func = notify_set_full_func;
+  manager->get_decoded_packet_func = get_decoded_packet_func;
+  manager->notif_data = notif_data;
+  memset(&manager->stat, 0, sizeof(manager->stat));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void decoder_manager_lru_unlink(decoder_manager_t* manager,
+				       uint16_t index)
+{
+  decoder_flow_t* flow = &manager->flow_table[index];
+  if (flow->lru_prev != FLOW_INDEX_NONE)
+    manager->flow_table[flow->lru_prev].lru_next = flow->lru_next;
+  else manager->lru_first = flow->lru_next;
+  if (flow->lru_next != FLOW_INDEX_NONE)
+    manager->flow_table[flow->lru_next].lru_prev = flow->lru_prev;
+  else manager->lru_last = flow->lru_prev;
+}
+
+static void decoder_manager_lru_push_first(decoder_manager_t* manager,
+					   uint16_t index)
+{
+  decoder_flow_t* flow = &manager->flow_table[index];
+  flow->lru_prev = FLOW_INDEX_NONE;
+  flow->lru_next = manager->lru_first;
+  if (manager->lru_first != FLOW_INDEX_NONE)
+    manager->flow_table[manager->lru_first].lru_prev = index;
+  else manager->lru_last = index;
+  manager->lru_first = index;
+}
+
+/* returns the index of the flow, and the index of the previous one in its
+   hash bucket (or FLOW_INDEX_NONE) in `prev_index` */
+static uint16_t decoder_manager_find(decoder_manager_t* manager,
+				     uint32_t flow_id, uint16_t* prev_index)
+{
+  uint16_t index = manager->bucket[decoder_manager_hash(flow_id)];
+  *prev_index = FLOW_INDEX_NONE;
+  while (index != FLOW_INDEX_NONE 
+	 && manager->flow_table[index].flow_id != flow_id) {
+    *prev_index = index;
+    index = manager->flow_table[index].next_index;
+  }
+  return index;
+}
+
+/* removes a used entry from its hash bucket and the LRU list, and puts it
+   in the free list */
+static void decoder_manager_free(decoder_manager_t* manager, uint16_t index)
+{
+  decoder_flow_t* flow = &manager->flow_table[index];
+  uint16_t prev_index;
+  ASSERT( flow->is_used );
+  uint16_t found_index = decoder_manager_find(manager, flow->flow_id,
+					      &prev_index);
+  ASSERT( found_index == index );
+  (void)found_index;
+  if (prev_index != FLOW_INDEX_NONE)
+    manager->flow_table[prev_index].next_index = flow->next_index;
+  else manager->bucket[decoder_manager_hash(flow->flow_id)]
+	 = flow->next_index;
+  decoder_manager_lru_unlink(manager, index);
+
+  flow->is_used = false;
+  flow->next_index = manager->free_index;
+  manager->free_index = index;
+  manager->stat.nb_active --;
+}
+
+packet_set_t* decoder_manager_get_set(decoder_manager_t* manager,
+				      uint32_t flow_id, uint32_t now,
+				      bool can_create)
+{
+  uint16_t prev_index;
+  manager->stat.nb_lookup ++;
+  uint16_t index = decoder_manager_find(manager, flow_id, &prev_index);
+  if (index != FLOW_INDEX_NONE) {
+    manager->stat.nb_hit ++;
+    if (manager->lru_first != index) {
+      decoder_manager_lru_unlink(manager, index);
+      decoder_manager_lru_push_first(manager, index);
+    }
+    manager->flow_table[index].last_time = now;
+    return &manager->flow_table[index].set;
+  }
+  if (!can_create)
+    return NULL;
+
+  if (manager->free_index == FLOW_INDEX_NONE) {
+    ASSERT( manager->lru_last != FLOW_INDEX_NONE );
+    decoder_manager_free(manager, manager->lru_last);
+    manager->stat.nb_evicted_lru ++;
+  }
+  index = manager->free_index;
+  decoder_flow_t* flow = &manager->flow_table[index];
+  manager->free_index = flow->next_index;
+
+  uint16_t bucket_index = decoder_manager_hash(flow_id);
+  flow->flow_id = flow_id;
+  flow->last_time = now;
+  flow->is_used = true;
+  flow->next_index = manager->bucket[bucket_index];
+  manager->bucket[bucket_index] = index;
+  decoder_manager_lru_push_first(manager, index);
+  packet_set_init(&flow->set, manager->log2_nb_bit_coef,
+		  manager->notify_packet_decoded_func,
+		  manager->notify_set_full_func,
+		  manager->get_decoded_packet_func, manager->notif_data);
+
+  manager->stat.nb_created ++;
+  manager->stat.nb_active ++;
+  manager->stat.nb_active_max = MAX(manager->stat.nb_active_max,
+				    manager->stat.nb_active);
+  return &flow->set;
+}
+
+uint16_t decoder_manager_add(decoder_manager_t* manager, uint32_t flow_id,
+			     uint32_t now, coded_packet_t* pkt,
+			     reduction_stat_t* stat)
+{
+  packet_set_t* set = decoder_manager_get_set(manager, flow_id, now, true);
+  return packet_set_add(set, pkt, stat, true);
+}
+
+bool decoder_manager_remove(decoder_manager_t* manager, uint32_t flow_id)
+{
+  uint16_t prev_index;
+  uint16_t index = decoder_manager_find(manager, flow_id, &prev_index);
+  if (index == FLOW_INDEX_NONE)
+    return false;
+  decoder_manager_free(manager, index);
+  manager->stat.nb_removed ++;
+  return true;
+}
+
+uint16_t decoder_manager_evict_idle(decoder_manager_t* manager, uint32_t now)
+{
+  uint16_t nb_evicted = 0;
+  while (manager->lru_last != FLOW_INDEX_NONE) {
+    decoder_flow_t* flow = &manager->flow_table[manager->lru_last];
+    if ((uint32_t)(now - flow->last_time) <= manager->idle_timeout)
+      break;
+    decoder_manager_free(manager, manager->lru_last);
+    nb_evicted ++;
+  }
+  manager->stat.nb_evicted_idle += nb_evicted;
+  return nb_evicted;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void decoder_manager_stat_pywrite(FILE* out, decoder_manager_stat_t* stat)
+{
+  fprintf(out, "{ 'type':'decoder-manager-stat'");
+  fprintf(out, ", 'nbLookup':%u", stat->nb_lookup);
+  fprintf(out, ", 'nbHit':%u", stat->nb_hit);
+  fprintf(out, ", 'nbCreated':%u", stat->nb_created);
+  fprintf(out, ", 'nbRemoved':%u", stat->nb_removed);
+  fprintf(out, ", 'nbEvictedLru':%u", stat->nb_evicted_lru);
+  fprintf(out, ", 'nbEvictedIdle':%u", stat->nb_evicted_idle);
+  fprintf(out, ", 'nbActive':%u", stat->nb_active);
+  fprintf(out, ", 'nbActiveMax':%u", stat->nb_active_max);
+  fprintf(out, " }");
+}
+
+void decoder_manager_pywrite(FILE* out, decoder_manager_t* manager)
+{
+  fprintf(out, "{ 'type':'decoder-manager'");
+  fprintf(out, ", 'l':%u", manager->log2_nb_bit_coef);
+  fprintf(out, ", 'nbFlow':%u", manager->nb_flow);
+  fprintf(out, ", 'idleTimeout':%u", manager->idle_timeout);
+  fprintf(out, ", 'memorySize':%lu", 
+	  (unsigned long)decoder_manager_get_memory_size(manager));
+  fprintf(out, ", 'flowIdLru':[");
+  uint16_t index = manager->lru_first;
+  bool is_first = true;
+  while (index != FLOW_INDEX_NONE) {
+    if (is_first) is_first = false;
+    else fprintf(out, ",");
+    fprintf(out, "%u", manager->flow_table[index].flow_id);
+    index = manager->flow_table[index].lru_next;
+  }
+  fprintf(out, "], 'stat':");
+  decoder_manager_stat_pywrite(out, &manager->stat);
+  fprintf(out, " }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,206 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Decoding of many flows, with a pool of packet sets
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __DECODER_MANAGER_H__
+#define __DECODER_MANAGER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "packet-set.h"
+
+/*---------------------------------------------------------------------------*/
+
+/* Number of buckets of the hash table of flow ids (a power of 2) */
+#ifdef CONF_DECODER_MANAGER_NB_BUCKET
+#define DECODER_MANAGER_NB_BUCKET CONF_DECODER_MANAGER_NB_BUCKET
+#else /* CONF_DECODER_MANAGER_NB_BUCKET */
+#define DECODER_MANAGER_NB_BUCKET 256
+#endif /* CONF_DECODER_MANAGER_NB_BUCKET */
+
+#define FLOW_INDEX_NONE 0xffffu
+
+/**
+ * @brief decoder_flow_t is one entry of the pool of a decoder manager:
+ *        the packet set of one flow, and its bookkeeping.
+ */
+typedef struct {
+  packet_set_t set;   /**< first, so that a packet set is its flow entry */
+  uint32_t flow_id;
+  uint32_t last_time; /**< time of the last access */
+  uint16_t next_index; /**< next entry in the same hash bucket (or in the free list) */
+  uint16_t lru_prev;  /**< previous entry, more recently used */
+  uint16_t lru_next;  /**< next entry, less recently used */
+  bool is_used;
+} decoder_flow_t;
+
+/**
+ * @brief decoder_manager_stat_t gives statistics about a decoder manager.
+ */
+typedef struct {
+  uint32_t nb_lookup;   /**< */
+  uint32_t nb_hit;      /**< lookups of an existing flow */
+  uint32_t nb_created;  /**< */
+  uint32_t nb_removed;  /**< by decoder_manager_remove */
+  uint32_t nb_evicted_lru;  /**< least recently used flows, evicted for a new one */
+  uint32_t nb_evicted_idle; /**< by decoder_manager_evict_idle */
+  uint16_t nb_active;     /**< flows currently in the pool */
+  uint16_t nb_active_max; /**< highest number of flows in the pool */
+} decoder_manager_stat_t;
+
+/**
+ * @brief decoder_manager_t keeps the packet sets of many flows, identified
+ *        by a flow id, in a pool of fixed size (provided at initialization,
+ *        so that no memory is allocated afterwards). A flow is found by
+ *        hashing in constant time; when the pool is full, the least 
+ *        recently used flow is evicted, and flows that are idle for too
+ *        long can be evicted with decoder_manager_evict_idle.
+ */
+typedef struct {
+  decoder_flow_t* flow_table; /**< the pool */
+  uint16_t nb_flow;         /**< size of the pool */
+  uint16_t bucket[DECODER_MANAGER_NB_BUCKET]; /**< first entry of each hash bucket */
+  uint16_t free_index;      /**< first entry of the free list */
+  uint16_t lru_first;       /**< most recently used entry */
+  uint16_t lru_last;        /**< least recently used entry */
+  uint32_t idle_timeout;    /**< see decoder_manager_evict_idle */
+
+  /* given to packet_set_init for every flow */
+  uint8_t log2_nb_bit_coef;
+  notify_packet_decoded_func_t notify_packet_decoded_func;
+  notify_set_full_func_t notify_set_full_func;
+  get_decoded_packet_func_t get_decoded_packet_func;
+  void* notif_data;
+
+  decoder_manager_stat_t stat;
+} decoder_manager_t;
+
+/**
+ * @brief     Initializes one decoder manager.
+ * @param[in] manager is the decoder manager
+ * @param[in] flow_table is the pool, an array of `nb_flow` entries (owned by
+ *            the caller: e.g. static, or allocated once)
+ * @param[in] nb_flow is the size of the pool (at most FLOW_INDEX_NONE-1)
+ * @param[in] idle_timeout is the time after which a flow is idle, see
+ *            decoder_manager_evict_idle.
+ * @param[in] log2_nb_bit_coef, notify_packet_decoded_func,
+ *            notify_set_full_func, get_decoded_packet_func, notif_data are
+ *            given to packet_set_init for the packet set of every flow 
+ *            (the callbacks can find the flow id of a packet set with 
+ *            decoder_manager_get_flow_id).
+ */
+void decoder_manager_init(decoder_manager_t* manager,
+			  decoder_flow_t* flow_table, uint16_t nb_flow,
+			  uint32_t idle_timeout, uint8_t log2_nb_bit_coef,
+			  notify_packet_decoded_func_t notify_packet_decoded_func,
+			  notify_set_full_func_t notify_set_full_func,
+			  get_decoded_packet_func_t get_decoded_packet_func,
+			  void* notif_data);
+
+/**
+ * @brief     Get the packet set of one flow, and mark it as used now.
+ * @param[in] manager is the decoder manager
+ * @param[in] flow_id is the flow id
+ * @param[in] now is the current time (in any unit, the same as 
+ *            idle_timeout; it may wrap around)
+ * @param[in] can_create indicates whether a new flow is created (evicting
+ *            the least recently used one if the pool is full) when there 
+ *            is none with this flow id.
+ * @return    the packet set of the flow, or NULL if there is none.
+ */
+packet_set_t* decoder_manager_get_set(decoder_manager_t* manager,
+				      uint32_t flow_id, uint32_t now,
+				      bool can_create);
+
+/**
+ * @brief     Add one coded packet to the packet set of one flow (created if
+ *            needed), as with packet_set_add.
+ * @return    the result of packet_set_add.
+ */
+uint16_t decoder_manager_add(decoder_manager_t* manager, uint32_t flow_id,
+			     uint32_t now, coded_packet_t* pkt,
+			     reduction_stat_t* stat);
+
+/**
+ * @brief     Remove one flow, and free its entry of the pool.
+ * @return    true if the flow existed.
+ */
+bool decoder_manager_remove(decoder_manager_t* manager, uint32_t flow_id);
+
+/**
+ * @brief     Evict the flows that were not used during more than 
+ *            `idle_timeout`, from the least recently used one.
+ * @param[in] manager is the decoder manager
+ * @param[in] now is the current time
+ * @return    the number of evicted flows.
+ */
+uint16_t decoder_manager_evict_idle(decoder_manager_t* manager, uint32_t now);
+
+/**
+ * @brief     Returns the flow id of one packet set of the manager (e.g. in 
+ *            the callbacks).
+ */
+static inline uint32_t decoder_manager_get_flow_id(packet_set_t* set)
+{ return ((decoder_flow_t*)set)->flow_id; }
+
+/**
+ * @brief     Returns the memory used by the manager and its pool, in bytes.
+ */
+static inline size_t decoder_manager_get_memory_size
+(decoder_manager_t* manager)
+{ return sizeof(decoder_manager_t) + manager->nb_flow*sizeof(decoder_flow_t); }
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void decoder_manager_stat_pywrite(FILE* out, decoder_manager_stat_t* stat);
+
+void decoder_manager_pywrite(FILE* out, decoder_manager_t* manager);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DECODER_MANAGER_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,358 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Decoding of independent flows by several threads
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "decoder-runtime.h"
+
+#ifdef CONF_WITH_PTHREAD
+
+/*---------------------------------------------------------------------------*/
+
+#define DECODER_MESSAGE_PACKET    1
+#define DECODER_MESSAGE_HAND_OVER 2 /**< give the flows of a shard */
+#define DECODER_MESSAGE_ADOPT     3 /**< take the flows of a shard */
+#define DECODER_MESSAGE_STOP      4
+
+#define HANDOVER_IDLE    0
+#define HANDOVER_PENDING 1 /**< the previous owner did not give the flows */
+#define HANDOVER_READY   2 /**< the flows are in handover_flow */
+
+/*---------------------------------------------------------------------------*/
+
+static void decoder_worker_notify(packet_set_t* set, uint16_t packet_id)
+{
+  decoder_worker_t* worker = set->notif_data;
+  decoder_runtime_t* runtime = worker->runtime;
+  worker->stat.nb_decoded ++;
+  if (runtime->notify_func != NULL)
+    runtime->notify_func(runtime->notif_data, worker->index,
+			 decoder_manager_get_flow_id(set),
+			 &set->coded_packet[packet_id]);
+}
+
+/* moves the flows of one shard from the worker to handover_flow */
+static void decoder_worker_hand_over(decoder_worker_t* worker, uint16_t shard)
+{
+  decoder_runtime_t* runtime = worker->runtime;
+  decoder_manager_t* manager = &worker->manager;
+  uint16_t nb_flow = 0;
+  uint16_t index = manager->lru_first;
+  while (index != FLOW_INDEX_NONE) {
+    decoder_flow_t* flow = &manager->flow_table[index];
+    uint16_t next_index = flow->lru_next;
+    if (decoder_runtime_get_shard(flow->flow_id) == shard) {
+      ASSERT( nb_flow < DECODER_RUNTIME_FLOW_PER_WORKER );
+      memcpy(&runtime->handover_flow[nb_flow], flow, sizeof(*flow));
+      nb_flow ++;
+      decoder_manager_remove(manager, flow->flow_id);
+    }
+    index = next_index;
+  }
+  runtime->handover_nb_flow = nb_flow;
+  worker->stat.nb_flow_out += nb_flow;
+  pthread_mutex_lock(&runtime->handover_lock);
+  atomic_store_explicit(&runtime->handover_state, HANDOVER_READY,
+			memory_order_release);
+  pthread_cond_signal(&runtime->handover_ready);
+  pthread_mutex_unlock(&runtime->handover_lock);
+}
+
+/* waits for the previous owner of a shard (polling, then sleeping until 
+   decoder_worker_hand_over), then takes its flows; the least recently 
+   used ones are first, so they are evicted first */
+static void decoder_worker_adopt(decoder_worker_t* worker)
+{
+  decoder_runtime_t* runtime = worker->runtime;
+  uint32_t nb_poll = 0;
+  while (atomic_load_explicit(&runtime->handover_state, memory_order_acquire)
+	 != HANDOVER_READY) {
+    if (nb_poll == 0)
+      worker->stat.nb_handover_wait ++;
+    if (nb_poll < SPSC_RING_NB_POLL) {
+      nb_poll ++;
+      sched_yield();
+      continue;
+    }
+    pthread_mutex_lock(&runtime->handover_lock);
+    while (atomic_load_explicit(&runtime->handover_state, 
+				memory_order_acquire) != HANDOVER_READY)
+      pthread_cond_wait(&runtime->handover_ready, &runtime->handover_lock);
+    pthread_mutex_unlock(&runtime->handover_lock);
+  }
+  uint16_t i;
+  for (i=runtime->handover_nb_flow; i>0; i--) {
+    decoder_flow_t* flow = &runtime->handover_flow[i-1];
+    packet_set_t* set = decoder_manager_get_set
+      (&worker->manager, flow->flow_id, flow->last_time, true);
+    memcpy(set, &flow->set, sizeof(*set));
+    set->notif_data = worker;
+  }
+  worker->stat.nb_flow_in += runtime->handover_nb_flow;
+  atomic_store_explicit(&runtime->handover_state, HANDOVER_IDLE,
+			memory_order_release);
+}
+
+/* the queue is never closed: the worker sleeps on it while it is empty,
+   until the message DECODER_MESSAGE_STOP */
+static void* decoder_worker_run(void* arg)
+{
+  decoder_worker_t* worker = arg;
+  for (;;) {
+    decoder_runtime_message_t* message = spsc_ring_peek_wait(&worker->queue);
+    ASSERT( message != NULL );
+    switch (message->type) {
+    case DECODER_MESSAGE_PACKET:
+      decoder_manager_add(&worker->manager, message->flow_id, message->now,
+			  &message->pkt, NULL);
+      decoder_manager_evict_idle(&worker->manager, message->now);
+      worker->stat.nb_packet ++;
+      break;
+    case DECODER_MESSAGE_HAND_OVER:
+      decoder_worker_hand_over(worker, message->shard);
+      break;
+    case DECODER_MESSAGE_ADOPT:
+      decoder_worker_adopt(worker);
+      break;
+    case DECODER_MESSAGE_STOP:
+      spsc_ring_release(&worker->queue);
+      return NULL;
+    default:
+      FATAL("unknown message type %u", message->type);
+    }
+    spsc_ring_release(&worker->queue);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* returns the next entry of the queue of a worker, waiting if it is full */
+static decoder_runtime_message_t* decoder_runtime_reserve
+(decoder_runtime_t* runtime, uint16_t worker_index, uint8_t type)
+{
+  decoder_runtime_message_t* message 
+    = spsc_ring_reserve_wait(&runtime->worker[worker_index].queue);
+  message->type = type;
+  return message;
+}
+
+static void decoder_runtime_stop_workers(decoder_runtime_t* runtime,
+					 uint16_t nb_worker)
+{
+  uint16_t i;
+  for (i=0; i<nb_worker; i++) {
+    decoder_runtime_reserve(runtime, i, DECODER_MESSAGE_STOP);
+    spsc_ring_commit(&runtime->worker[i].queue);
+  }
+  for (i=0; i<nb_worker; i++)
+    pthread_join(runtime->worker[i].thread, NULL);
+}
+
+bool decoder_runtime_start(decoder_runtime_t* runtime, uint16_t nb_worker,
+			   uint8_t log2_nb_bit_coef, uint32_t idle_timeout,
+			   decoder_runtime_notify_func_t notify_func,
+			   void* notif_data)
+{
+  uint16_t i;
+  REQUIRE( nb_worker > 0 && nb_worker <= DECODER_RUNTIME_MAX_WORKER );
+  REQUIRE( (DECODER_RUNTIME_NB_SHARD & (DECODER_RUNTIME_NB_SHARD-1)) == 0 );
+  runtime->nb_worker = nb_worker;
+  for (i=0; i<DECODER_RUNTIME_NB_SHARD; i++) {
+    runtime->shard_owner[i] = i % nb_worker;
+    runtime->shard_load[i] = 0;
+  }
+  runtime->nb_since_rebalance = 0;
+  atomic_init(&runtime->handover_state, HANDOVER_IDLE);
+  pthread_mutex_init(&runtime->handover_lock, NULL);
+  pthread_cond_init(&runtime->handover_ready, NULL);
+  runtime->handover_nb_flow = 0;
+  runtime->notify_func = notify_func;
+  runtime->notif_data = notif_data;
+  memset(&runtime->stat, 0, sizeof(runtime->stat));
+
+  for (i=0; i<nb_worker; i++) {
+    decoder_worker_t* worker = &runtime->worker[i];
+    spsc_ring_init(&worker->queue, worker->message, 
+		   sizeof(decoder_runtime_message_t), 
+		   DECODER_RUNTIME_QUEUE_SIZE);
+    worker->runtime = runtime;
+    worker->index = i;
+    memset(&worker->stat, 0, sizeof(worker->stat));
+    decoder_manager_init(&worker->manager, worker->flow_table,
+			 DECODER_RUNTIME_FLOW_PER_WORKER, idle_timeout,
+			 log2_nb_bit_coef, decoder_worker_notify,
+			 packet_set_free_decoded, NULL, worker);
+  }
+  for (i=0; i<nb_worker; i++) {
+    decoder_worker_t* worker = &runtime->worker[i];
+    if (pthread_create(&worker->thread, NULL, 
+		       decoder_worker_run, worker) != 0) {
+      WARN("cannot start decoder worker %u", i);
+      decoder_runtime_stop_workers(runtime, i);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool decoder_runtime_migrate(decoder_runtime_t* runtime, uint16_t shard,
+			     uint16_t worker_index)
+{
+  ASSERT( shard < DECODER_RUNTIME_NB_SHARD );
+  ASSERT( worker_index < runtime->nb_worker );
+  if (atomic_load_explicit(&runtime->handover_state, memory_order_acquire)
+      != HANDOVER_IDLE)
+    return false;
+  uint16_t old_index = runtime->shard_owner[shard];
+  if (old_index == worker_index)
+    return true;
+
+  /* the previous owner processes the packets of the shard already in its
+     queue before handing over, the new owner waits for the hand over 
+     before the packets of the shard that will be in its queue */
+  atomic_store_explicit(&runtime->handover_state, HANDOVER_PENDING,
+			memory_order_relaxed);
+  decoder_runtime_message_t* message = decoder_runtime_reserve
+    (runtime, old_index, DECODER_MESSAGE_HAND_OVER);
+  message->shard = shard;
+  spsc_ring_commit(&runtime->worker[old_index].queue);
+  message = decoder_runtime_reserve(runtime, worker_index, 
+				    DECODER_MESSAGE_ADOPT);
+  message->shard = shard;
+  spsc_ring_commit(&runtime->worker[worker_index].queue);
+
+  runtime->shard_owner[shard] = worker_index;
+  runtime->stat.nb_migration ++;
+  return true;
+}
+
+/* migrates one shard from the most loaded worker (during the last period)
+   to the least loaded one, if it reduces the imbalance */
+static void decoder_runtime_rebalance(decoder_runtime_t* runtime)
+{
+  uint32_t load[DECODER_RUNTIME_MAX_WORKER];
+  uint16_t i;
+  memset(load, 0, sizeof(load));
+  for (i=0; i<DECODER_RUNTIME_NB_SHARD; i++)
+    load[runtime->shard_owner[i]] += runtime->shard_load[i];
+
+  uint16_t max_index = 0, min_index = 0;
+  for (i=1; i<runtime->nb_worker; i++) {
+    if (load[i] > load[max_index])
+      max_index = i;
+    if (load[i] < load[min_index])
+      min_index = i;
+  }
+
+  /* the largest shard with a load less than half of the difference */
+  uint32_t max_load = (load[max_index] - load[min_index]) / 2;
+  uint16_t best_shard = DECODER_RUNTIME_NB_SHARD;
+  for (i=0; i<DECODER_RUNTIME_NB_SHARD; i++)
+    if (runtime->shard_owner[i] == max_index
+	&& runtime->shard_load[i] > 0 && runtime->shard_load[i] <= max_load
+	&& (best_shard == DECODER_RUNTIME_NB_SHARD 
+	    || runtime->shard_load[i] > runtime->shard_load[best_shard]))
+      best_shard = i;
+  if (best_shard != DECODER_RUNTIME_NB_SHARD)
+    decoder_runtime_migrate(runtime, best_shard, min_index);
+
+  memset(runtime->shard_load, 0, sizeof(runtime->shard_load));
+}
+
+void decoder_runtime_dispatch(decoder_runtime_t* runtime, uint32_t flow_id,
+			      uint32_t now, coded_packet_t* pkt)
+{
+  uint16_t shard = decoder_runtime_get_shard(flow_id);
+  uint16_t worker_index = runtime->shard_owner[shard];
+  decoder_runtime_message_t* message = decoder_runtime_reserve
+    (runtime, worker_index, DECODER_MESSAGE_PACKET);
+  message->shard = shard;
+  message->flow_id = flow_id;
+  message->now = now;
+  coded_packet_copy_from(&message->pkt, pkt);
+  spsc_ring_commit(&runtime->worker[worker_index].queue);
+  runtime->stat.nb_dispatched ++;
+
+  runtime->shard_load[shard] ++;
+  runtime->nb_since_rebalance ++;
+  if (DECODER_RUNTIME_REBALANCE_PERIOD > 0 && runtime->nb_worker > 1
+      && runtime->nb_since_rebalance >= DECODER_RUNTIME_REBALANCE_PERIOD) {
+    decoder_runtime_rebalance(runtime);
+    runtime->nb_since_rebalance = 0;
+  }
+}
+
+void decoder_runtime_stop(decoder_runtime_t* runtime)
+{ decoder_runtime_stop_workers(runtime, runtime->nb_worker); }
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void decoder_runtime_pywrite(FILE* out, decoder_runtime_t* runtime)
+{
+  uint16_t i;
+  fprintf(out, "{ 'type':'decoder-runtime'");
+  fprintf(out, ", 'nbWorker':%u", runtime->nb_worker);
+  fprintf(out, ", 'nbDispatched':%u", runtime->stat.nb_dispatched);
+  fprintf(out, ", 'nbMigration':%u", runtime->stat.nb_migration);
+  fprintf(out, ", 'worker':[");
+  for (i=0; i<runtime->nb_worker; i++) {
+    decoder_worker_stat_t* stat = &runtime->worker[i].stat;
+    spsc_ring_stat_t queue_stat;
+    spsc_ring_get_stat(&runtime->worker[i].queue, &queue_stat);
+    if (i > 0)
+      fprintf(out, ",");
+    fprintf(out, "{'nbPacket':%u, 'nbDecoded':%u, 'nbFlowIn':%u"
+	    ", 'nbFlowOut':%u, 'nbHandoverWait':%u, 'manager':",
+	    stat->nb_packet, stat->nb_decoded, stat->nb_flow_in,
+	    stat->nb_flow_out, stat->nb_handover_wait);
+    decoder_manager_stat_pywrite(out, &runtime->worker[i].manager.stat);
+    fprintf(out, ", 'queue':");
+    spsc_ring_stat_pywrite(out, &queue_stat);
+    fprintf(out, "}");
+  }
+  fprintf(out, "] }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
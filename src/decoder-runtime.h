@@ -0,0 +1,253 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Decoding of independent flows by several threads
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __DECODER_RUNTIME_H__
+#define __DECODER_RUNTIME_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "decoder-manager.h"
+#include "spsc-ring.h"
+
+#ifdef CONF_WITH_PTHREAD
+
+#include <pthread.h>
+
+/*---------------------------------------------------------------------------*/
+
+/* Maximum number of worker threads */
+#ifdef CONF_DECODER_RUNTIME_MAX_WORKER
+#define DECODER_RUNTIME_MAX_WORKER CONF_DECODER_RUNTIME_MAX_WORKER
+#else /* CONF_DECODER_RUNTIME_MAX_WORKER */
+#define DECODER_RUNTIME_MAX_WORKER 8
+#endif /* CONF_DECODER_RUNTIME_MAX_WORKER */
+
+/* Number of messages in the queue of each worker (a power of 2) */
+#ifdef CONF_DECODER_RUNTIME_QUEUE_SIZE
+#define DECODER_RUNTIME_QUEUE_SIZE CONF_DECODER_RUNTIME_QUEUE_SIZE
+#else /* CONF_DECODER_RUNTIME_QUEUE_SIZE */
+#define DECODER_RUNTIME_QUEUE_SIZE 256
+#endif /* CONF_DECODER_RUNTIME_QUEUE_SIZE */
+
+/* Size of the pool of flows of each worker */
+#ifdef CONF_DECODER_RUNTIME_FLOW_PER_WORKER
+#define DECODER_RUNTIME_FLOW_PER_WORKER CONF_DECODER_RUNTIME_FLOW_PER_WORKER
+#else /* CONF_DECODER_RUNTIME_FLOW_PER_WORKER */
+#define DECODER_RUNTIME_FLOW_PER_WORKER 64
+#endif /* CONF_DECODER_RUNTIME_FLOW_PER_WORKER */
+
+/* Number of shards: flows are hashed to a shard, and each shard is owned 
+   by one worker (a power of 2) */
+#ifdef CONF_DECODER_RUNTIME_NB_SHARD
+#define DECODER_RUNTIME_NB_SHARD CONF_DECODER_RUNTIME_NB_SHARD
+#else /* CONF_DECODER_RUNTIME_NB_SHARD */
+#define DECODER_RUNTIME_NB_SHARD 256
+#endif /* CONF_DECODER_RUNTIME_NB_SHARD */
+
+/* Number of dispatched packets between two checks of the load of the 
+   workers (0 disables the rebalancing) */
+#ifdef CONF_DECODER_RUNTIME_REBALANCE_PERIOD
+#define DECODER_RUNTIME_REBALANCE_PERIOD CONF_DECODER_RUNTIME_REBALANCE_PERIOD
+#else /* CONF_DECODER_RUNTIME_REBALANCE_PERIOD */
+#define DECODER_RUNTIME_REBALANCE_PERIOD 1024
+#endif /* CONF_DECODER_RUNTIME_REBALANCE_PERIOD */
+
+/**
+ * @brief Function called by a worker thread for each decoded packet 
+ *        of a flow.
+ */
+typedef void (*decoder_runtime_notify_func_t)(void* notif_data, 
+					      uint16_t worker_index,
+					      uint32_t flow_id,
+					      coded_packet_t* pkt);
+
+/**
+ * @brief decoder_runtime_message_t is one entry of the queue of a worker.
+ */
+typedef struct {
+  uint8_t type;
+  uint16_t shard;
+  uint32_t flow_id;
+  uint32_t now;
+  coded_packet_t pkt;
+} decoder_runtime_message_t;
+
+/**
+ * @brief decoder_worker_stat_t gives statistics about one worker.
+ */
+typedef struct {
+  uint32_t nb_packet;       /**< coded packets added to a packet set */
+  uint32_t nb_decoded;      /**< source packets decoded (notified) */
+  uint32_t nb_flow_in;      /**< flows received from another worker */
+  uint32_t nb_flow_out;     /**< flows given to another worker */
+  uint32_t nb_handover_wait; /**< adoptions that waited for the flows */
+} decoder_worker_stat_t;
+
+struct s_decoder_runtime_t;
+
+/**
+ * @brief decoder_worker_t is one worker thread; it owns the flows of its 
+ *        shards: only this thread accesses their packet sets.
+ */
+typedef struct {
+  spsc_ring_t queue; /**< of decoder_runtime_message_t, from the dispatcher */
+  decoder_runtime_message_t message[DECODER_RUNTIME_QUEUE_SIZE];
+  struct s_decoder_runtime_t* runtime;
+  uint16_t index;
+  pthread_t thread;
+  decoder_manager_t manager;
+  decoder_flow_t flow_table[DECODER_RUNTIME_FLOW_PER_WORKER];
+  decoder_worker_stat_t stat; /**< written by the worker only */
+} decoder_worker_t;
+
+/**
+ * @brief decoder_runtime_stat_t gives statistics about the dispatching.
+ */
+typedef struct {
+  uint32_t nb_dispatched;  /**< coded packets passed to the workers */
+  uint32_t nb_migration;   /**< migrations of a shard to another worker */
+} decoder_runtime_stat_t;
+
+/**
+ * @brief decoder_runtime_t decodes independent flows with several worker
+ *        threads. Each flow is hashed to a shard, and each shard is owned
+ *        by one worker: the coded packets of its flows are passed by the 
+ *        dispatching thread to that worker through its lock-free queue 
+ *        (a spsc_ring_t, where the waits of the dispatcher for a full 
+ *        queue are counted), so that packet sets are never shared and no
+ *        lock is needed. An idle worker sleeps on its queue (after 
+ *        SPSC_RING_NB_POLL polls) until the dispatcher commits a message.
+ *
+ *        When some workers are loaded more than others, the dispatcher 
+ *        migrates a shard to a less loaded worker: the previous owner 
+ *        hands over the packet sets of its flows to the new one, which 
+ *        waits for them (polling, then sleeping on handover_ready) before 
+ *        processing the packets of the shard.
+ *
+ *        All the functions, except the callback, are called from one 
+ *        dispatching thread.
+ */
+typedef struct s_decoder_runtime_t {
+  decoder_worker_t worker[DECODER_RUNTIME_MAX_WORKER];
+  uint16_t nb_worker;
+  uint16_t shard_owner[DECODER_RUNTIME_NB_SHARD]; /**< used by the dispatcher */
+  uint32_t shard_load[DECODER_RUNTIME_NB_SHARD]; /**< packets since the last rebalancing */
+  uint32_t nb_since_rebalance;
+
+  /* the flows of a migrating shard (one migration at a time) */
+  _Atomic uint8_t handover_state;
+  pthread_mutex_t handover_lock; /**< only used to sleep and wake */
+  pthread_cond_t handover_ready;
+  uint16_t handover_nb_flow;
+  decoder_flow_t handover_flow[DECODER_RUNTIME_FLOW_PER_WORKER];
+
+  decoder_runtime_notify_func_t notify_func;
+  void* notif_data;
+  decoder_runtime_stat_t stat;
+} decoder_runtime_t;
+
+/**
+ * @brief     Initialize a runtime and start its worker threads.
+ * @param[in] runtime is the runtime (large: e.g. static, or allocated once)
+ * @param[in] nb_worker is the number of worker threads
+ * @param[in] log2_nb_bit_coef is the field of the coded packets of all flows
+ * @param[in] idle_timeout is given to the decoder manager of each worker
+ * @param[in] notify_func is called by the owning worker thread for each 
+ *            decoded packet
+ * @param[in] notif_data is given to notify_func
+ * @return    true on success, false if the threads could not be started.
+ */
+bool decoder_runtime_start(decoder_runtime_t* runtime, uint16_t nb_worker,
+			   uint8_t log2_nb_bit_coef, uint32_t idle_timeout,
+			   decoder_runtime_notify_func_t notify_func,
+			   void* notif_data);
+
+/**
+ * @brief     Pass one coded packet of a flow to the worker owning the flow.
+ *            Waits if the queue of the worker is full.
+ * @param[in] runtime is the runtime
+ * @param[in] flow_id is the flow of the packet
+ * @param[in] now is the current time, see decoder_manager_get_set
+ * @param[in] pkt is the coded packet (copied)
+ */
+void decoder_runtime_dispatch(decoder_runtime_t* runtime, uint32_t flow_id,
+			      uint32_t now, coded_packet_t* pkt);
+
+/**
+ * @brief     Migrate one shard (and its flows) to another worker; this is
+ *            done automatically every DECODER_RUNTIME_REBALANCE_PERIOD 
+ *            packets from the most loaded worker to the least loaded one.
+ * @return    false if another migration is still in progress.
+ */
+bool decoder_runtime_migrate(decoder_runtime_t* runtime, uint16_t shard,
+			     uint16_t worker_index);
+
+/**
+ * @brief     Process all the dispatched packets, then stop the worker 
+ *            threads.
+ */
+void decoder_runtime_stop(decoder_runtime_t* runtime);
+
+/**
+ * @brief     Returns the shard of one flow (with a hash independent from
+ *            the one of the decoder manager).
+ */
+static inline uint16_t decoder_runtime_get_shard(uint32_t flow_id)
+{ return (flow_id * 0x85ebca6bu) >> 16 & (DECODER_RUNTIME_NB_SHARD-1); }
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void decoder_runtime_pywrite(FILE* out, decoder_runtime_t* runtime);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DECODER_RUNTIME_H__ */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
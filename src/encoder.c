@@ -0,0 +1,453 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Sliding window encoder
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "encoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+void encoder_init(encoder_t* encoder, uint8_t log2_nb_bit_coef,
+		  uint16_t window_size, uint64_t seed)
+{
+  ASSERT( log2_nb_bit_coef <= MAX_LOG2_NB_BIT_COEF );
+  uint16_t max_window_size = MIN(ENCODER_MAX_WINDOW,
+				 1<<log2_window_size(log2_nb_bit_coef));
+  if (window_size == 0 || window_size > max_window_size)
+    window_size = max_window_size;
+
+  encoder->coef_pos_min = 0;
+  encoder->nb_source = 0;
+  encoder->window_size = window_size;
+  encoder->log2_nb_bit_coef = log2_nb_bit_coef;
+  coef_generator_init(&encoder->generator, seed);
+  encoder->density = ENCODER_DENSITY_FULL;
+  encoder->band_width = 0;
+
+  encoder->next_systematic = 0;
+  encoder->repair_interval = 0;
+  encoder->nb_since_repair = 0;
+  encoder->repair_credit = 0;
+  encoder->nb_systematic_sent = 0;
+  encoder->nb_repair_sent = 0;
+
+#if ENCODER_NB_ACCUMULATOR > 0
+  uint16_t i;
+  for (i=0; i<ENCODER_NB_ACCUMULATOR; i++) {
+    coded_packet_init(&encoder->accumulator[i], log2_nb_bit_coef);
+    memset(coded_packet_data(&encoder->accumulator[i]), 0, CODED_PACKET_SIZE);
+  }
+  encoder->accumulator_seed = coef_generator_next(&encoder->generator);
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+}
+
+#if ENCODER_NB_ACCUMULATOR > 0
+/* the source packet `coef_pos` enters (or leaves) the window: it is added
+   to (or subtracted from) every accumulator, with its coefficient there */
+static void encoder_accumulate(encoder_t* encoder, uint16_t coef_pos,
+			       bool is_entering)
+{
+  uint8_t l = encoder->log2_nb_bit_coef;
+  uint16_t index = coef_pos % ENCODER_MAX_WINDOW;
+  uint16_t i;
+  for (i=0; i<ENCODER_NB_ACCUMULATOR; i++) {
+    coded_packet_t* pkt = &encoder->accumulator[i];
+    uint8_t coef = encoder_get_accumulator_coef(encoder, i, coef_pos);
+    if (coef == 0)
+      continue;
+    lc_vector_mul_add(is_entering ? coef : lc_neg(coef, l),
+		      encoder->source[index], encoder->source_size[index], l,
+		      coded_packet_data(pkt));
+    pkt->data_size = MAX(pkt->data_size, encoder->source_size[index]);
+    coded_packet_set_coef(pkt, coef_pos, is_entering ? coef : 0);
+    if (!is_entering && pkt->coef_pos_min == coef_pos) {
+      /* the leaving source packet was the first one of the accumulator */
+      if (pkt->coef_pos_max == coef_pos)
+	coded_packet_init(pkt, l);
+      else {
+	pkt->coef_pos_min ++;
+	coded_packet_adjust_min_max_coef(pkt);
+      }
+    }
+  }
+}
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+
+uint8_t* encoder_get_source(encoder_t* encoder, uint16_t coef_pos)
+{
+  if (coef_pos < encoder->coef_pos_min
+      || coef_pos >= encoder_get_next_coef_pos(encoder))
+    return NULL;
+  return encoder->source[coef_pos % ENCODER_MAX_WINDOW];
+}
+
+uint16_t encoder_add_source(encoder_t* encoder, uint8_t* data,
+			    uint16_t data_size)
+{
+  REQUIRE( data_size <= CODED_PACKET_SIZE );
+  if (encoder->nb_source == encoder->window_size) {
+    encoder->coef_pos_min ++;
+    encoder->nb_source --;
+#if ENCODER_NB_ACCUMULATOR > 0
+    encoder_accumulate(encoder, encoder->coef_pos_min-1, false);
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+    /* the source packet is dropped even if it has not been sent */
+    encoder->next_systematic = MAX(encoder->next_systematic,
+				   encoder->coef_pos_min);
+  }
+  uint16_t coef_pos = encoder_get_next_coef_pos(encoder);
+  ASSERT( coef_pos != COEF_POS_NONE );
+  uint16_t index = coef_pos % ENCODER_MAX_WINDOW;
+  memcpy(encoder->source[index], data, data_size);
+  memset(encoder->source[index] + data_size, 0, 
+	 CODED_PACKET_SIZE - data_size);
+  encoder->source_size[index] = data_size;
+  encoder->nb_source ++;
+#if ENCODER_NB_ACCUMULATOR > 0
+  encoder_accumulate(encoder, coef_pos, true);
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+  return coef_pos;
+}
+
+void encoder_ack(encoder_t* encoder, uint16_t coef_pos)
+{
+  if (coef_pos < encoder->coef_pos_min)
+    return;
+  uint16_t nb_acked = MIN(coef_pos - encoder->coef_pos_min + 1, 
+			  encoder->nb_source);
+#if ENCODER_NB_ACCUMULATOR > 0
+  uint16_t i;
+  for (i=0; i<nb_acked; i++) {
+    encoder->coef_pos_min ++;
+    encoder->nb_source --;
+    encoder_accumulate(encoder, encoder->coef_pos_min-1, false);
+  }
+#else /* ENCODER_NB_ACCUMULATOR > 0 */
+  encoder->coef_pos_min += nb_acked;
+  encoder->nb_source -= nb_acked;
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+  encoder->next_systematic = MAX(encoder->next_systematic,
+				 encoder->coef_pos_min);
+}
+
+/* the payload of `pkt` is the combination of the source packets with the
+   coefficients of `coef_table` (its header is not modified) */
+static void encoder_combine_sources(encoder_t* encoder, uint16_t coef_pos_min,
+				    uint8_t* coef_table, uint16_t nb_coef,
+				    coded_packet_t* pkt)
+{
+  uint8_t* data_table[ENCODER_MAX_WINDOW];
+  uint16_t data_size = 0;
+  uint16_t i;
+
+  REQUIRE( nb_coef <= encoder->window_size );
+  for (i=0; i<nb_coef; i++) {
+    uint16_t coef_pos = coef_pos_min + i;
+    REQUIRE( encoder_get_source(encoder, coef_pos) != NULL );
+    uint16_t index = coef_pos % ENCODER_MAX_WINDOW;
+    data_table[i] = encoder->source[index];
+    if (coef_table[i] != 0)
+      data_size = MAX(data_size, encoder->source_size[index]);
+  }
+  lc_vector_linear_combination(coef_table, data_table, nb_coef, data_size,
+			       encoder->log2_nb_bit_coef,
+			       coded_packet_data(pkt));
+  pkt->data_size = data_size;
+}
+
+void encoder_generate_with_coefs(encoder_t* encoder, uint16_t coef_pos_min,
+				 uint8_t* coef_table, uint16_t nb_coef,
+				 coded_packet_t* pkt)
+{
+  uint16_t i;
+  coded_packet_init(pkt, encoder->log2_nb_bit_coef);
+  for (i=0; i<nb_coef; i++)
+    if (coef_table[i] != 0)
+      coded_packet_set_coef(pkt, coef_pos_min + i, coef_table[i]);
+  encoder_combine_sources(encoder, coef_pos_min, coef_table, nb_coef, pkt);
+}
+
+/* random combination of the `nb_coef` source packets from `coef_pos_min` */
+static void encoder_generate_random(encoder_t* encoder, uint16_t coef_pos_min,
+				    uint16_t nb_coef, coded_packet_t* pkt)
+{
+  uint8_t coef_table[ENCODER_MAX_WINDOW];
+  uint16_t i;
+  ASSERT( nb_coef > 0 );
+  if (encoder->band_width > 0 && encoder->band_width < nb_coef) {
+    /* the band may overlap the ends of the window (and is then shorter), 
+       so that every source packet is in the same number of bands */
+    uint16_t width = encoder->band_width;
+    uint16_t start = coef_generator_next(&encoder->generator) 
+      % (nb_coef + width - 1);
+    uint16_t first = (start >= width-1) ? start - (width-1) : 0;
+    uint16_t last = MIN(start, nb_coef-1);
+    coef_pos_min += first;
+    nb_coef = last - first + 1;
+  }
+  if (encoder->density >= ENCODER_DENSITY_FULL) {
+    /* the coefficients are drawn directly in the header */
+    coded_packet_init(pkt, encoder->log2_nb_bit_coef);
+    coef_generator_fill_packet(&encoder->generator, pkt, coef_pos_min,
+			       nb_coef, COEF_GENERATOR_LEADING_NONZERO);
+    for (i=0; i<nb_coef; i++)
+      coef_table[i] = coded_packet_get_coef(pkt, coef_pos_min + i);
+    encoder_combine_sources(encoder, coef_pos_min, coef_table, nb_coef, pkt);
+    return;
+  }
+  coef_generator_fill(&encoder->generator, encoder->log2_nb_bit_coef,
+		      coef_table, nb_coef, COEF_GENERATOR_LEADING_NONZERO);
+  for (i=0; i+1<nb_coef; i++)
+    if ((coef_generator_next(&encoder->generator) % ENCODER_DENSITY_FULL)
+	>= encoder->density)
+      coef_table[i] = 0;
+  encoder_generate_with_coefs(encoder, coef_pos_min, coef_table, nb_coef, pkt);
+}
+
+bool encoder_generate(encoder_t* encoder, coded_packet_t* pkt)
+{
+  if (encoder_is_empty(encoder))
+    return false;
+  encoder_generate_random(encoder, encoder->coef_pos_min, encoder->nb_source,
+			  pkt);
+  return true;
+}
+
+void encoder_generate_source(encoder_t* encoder, uint16_t coef_pos,
+			     coded_packet_t* pkt)
+{
+  uint8_t* data = encoder_get_source(encoder, coef_pos);
+  REQUIRE( data != NULL );
+  uint16_t data_size = encoder->source_size[coef_pos % ENCODER_MAX_WINDOW];
+  coded_packet_init(pkt, encoder->log2_nb_bit_coef);
+  coded_packet_set_coef(pkt, coef_pos, 1);
+  memcpy(coded_packet_data(pkt), data, data_size);
+  pkt->data_size = data_size;
+}
+
+/* status of each receiver in encoder_generate_innovative */
+#define RECEIVER_PENDING    0 /* decoded all the selected source packets */
+#define RECEIVER_INNOVATIVE 1
+#define RECEIVER_UNKNOWN    2
+
+bool encoder_generate_innovative(encoder_t* encoder,
+				 receiver_state_t* state_table,
+				 uint16_t nb_state, coded_packet_t* pkt,
+				 bool* innovative_table)
+{
+  uint8_t coef_table[ENCODER_MAX_WINDOW];
+  uint8_t status[ENCODER_MAX_RECEIVER];
+  bool has_coef = false;
+  uint16_t i, r;
+
+  REQUIRE( nb_state <= ENCODER_MAX_RECEIVER );
+  coded_packet_init(pkt, encoder->log2_nb_bit_coef);
+  if (encoder_is_empty(encoder))
+    return false;
+  memset(status, RECEIVER_PENDING, nb_state);
+  coef_generator_fill(&encoder->generator, encoder->log2_nb_bit_coef,
+		      coef_table, encoder->nb_source, COEF_GENERATOR_NONZERO);
+
+  /* the packet ends at the lowest source index that can still make it 
+     innovative for every receiver: the highest one, among the receivers,
+     of their lowest source index that is neither decoded nor seen; and it
+     always covers the lowest source index that a receiver has not decoded.
+     Higher indices would only make it harder to fit in the packet sets of
+     the receivers that are late */
+  uint16_t nb_coef = (nb_state == 0) ? encoder->nb_source : 0;
+  uint16_t lowest_missing = COEF_POS_NONE;
+  for (r=0; r<nb_state; r++)
+    for (i=0; i<encoder->nb_source; i++) {
+      uint16_t coef_pos = encoder->coef_pos_min + i;
+      if (receiver_state_is_decoded(&state_table[r], coef_pos))
+	continue;
+      lowest_missing = MIN(lowest_missing, coef_pos);
+      if (!receiver_state_is_seen(&state_table[r], coef_pos)) {
+	nb_coef = MAX(nb_coef, i+1);
+	break;
+      }
+    }
+  if (nb_coef == 0 && lowest_missing != COEF_POS_NONE)
+    nb_coef = encoder->nb_source; /* every missing index is seen */
+
+  /* then down from there: a source index is selected when it makes the
+     packet innovative for one pending receiver at least (for the pending
+     receivers that have seen it, the packet is then only innovative with
+     high probability), or when it is needed only by receivers that are
+     not pending anymore, or when it is the lowest missing one */
+  for (i=nb_coef; i>0; i--) {
+    uint16_t coef_pos = encoder->coef_pos_min + i-1;
+    uint16_t nb_innovative = 0, nb_unknown = 0, nb_needed = 0;
+    for (r=0; r<nb_state; r++) {
+      if (receiver_state_is_decoded(&state_table[r], coef_pos))
+	continue;
+      nb_needed ++;
+      if (status[r] != RECEIVER_PENDING)
+	continue;
+      if (receiver_state_is_seen(&state_table[r], coef_pos))
+	nb_unknown ++;
+      else nb_innovative ++;
+    }
+
+    bool is_selected = (nb_innovative > 0)
+      || (nb_unknown == 0
+	  && (nb_state == 0 || nb_needed > 0))
+      || coef_pos == lowest_missing;
+    if (!is_selected) {
+      coef_table[i-1] = 0;
+      continue;
+    }
+    has_coef = true;
+    for (r=0; r<nb_state; r++)
+      if (status[r] == RECEIVER_PENDING
+	  && !receiver_state_is_decoded(&state_table[r], coef_pos))
+	status[r] = receiver_state_is_seen(&state_table[r], coef_pos) ?
+	  RECEIVER_UNKNOWN : RECEIVER_INNOVATIVE;
+  }
+
+  if (innovative_table != NULL)
+    for (r=0; r<nb_state; r++)
+      innovative_table[r] = (status[r] == RECEIVER_INNOVATIVE);
+  if (!has_coef)
+    return false;
+  encoder_generate_with_coefs(encoder, encoder->coef_pos_min, coef_table,
+			      nb_coef, pkt);
+  return true;
+}
+
+#if ENCODER_NB_ACCUMULATOR > 0
+bool encoder_generate_accumulated(encoder_t* encoder, coded_packet_t* pkt)
+{
+  uint8_t coef_table[ENCODER_NB_ACCUMULATOR];
+  uint8_t* data_table[ENCODER_NB_ACCUMULATOR];
+  uint8_t l = encoder->log2_nb_bit_coef;
+  uint16_t i, data_size = 0;
+
+  if (encoder_is_empty(encoder))
+    return false;
+  for (i=0; i<ENCODER_NB_ACCUMULATOR; i++) {
+    coded_packet_t* acc = &encoder->accumulator[i];
+    data_size = MAX(data_size, acc->data_size);
+    data_table[i] = acc->content.u8;
+  }
+  coef_generator_fill(&encoder->generator, l, coef_table, 
+		      ENCODER_NB_ACCUMULATOR, COEF_GENERATOR_LEADING_NONZERO);
+  /* the newest source packet has a non-zero coefficient in the accumulator
+     `0`: when the others cancel it, adding 1 to the first coefficient 
+     makes its coefficient non-zero */
+  uint16_t newest = encoder_get_next_coef_pos(encoder) - 1;
+  uint8_t newest_coef = 0;
+  for (i=0; i<ENCODER_NB_ACCUMULATOR; i++)
+    newest_coef ^= lc_mul(coef_table[i], 
+			  encoder_get_accumulator_coef(encoder, i, newest), l);
+  if (newest_coef == 0)
+    coef_table[0] ^= 1;
+  /* encoding vectors and payloads in one pass */
+  coded_packet_init(pkt, encoder->log2_nb_bit_coef);
+  lc_vector_linear_combination(coef_table, data_table, ENCODER_NB_ACCUMULATOR,
+			       COEF_HEADER_SIZE + data_size,
+			       encoder->log2_nb_bit_coef, pkt->content.u8);
+  pkt->data_size = data_size;
+  pkt->coef_pos_min = encoder->coef_pos_min;
+  pkt->coef_pos_max = encoder_get_next_coef_pos(encoder) - 1;
+  coded_packet_adjust_min_max_coef(pkt);
+  return true;
+}
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+
+/*---------------------------------------------------------------------------*/
+
+void encoder_notify_loss(encoder_t* encoder, uint16_t nb_lost)
+{
+  uint32_t repair_credit = encoder->repair_credit + nb_lost;
+  encoder->repair_credit = MIN(repair_credit, 0xffffu);
+}
+
+bool encoder_next_packet(encoder_t* encoder, coded_packet_t* pkt)
+{
+  /* source packets that were sent, and not acknowledged */
+  uint16_t nb_sent = encoder->next_systematic - encoder->coef_pos_min;
+  bool has_source = encoder->next_systematic 
+    < encoder_get_next_coef_pos(encoder);
+  bool repair_due = encoder->repair_interval > 0
+    && encoder->nb_since_repair >= encoder->repair_interval;
+
+  if (nb_sent > 0 && (encoder->repair_credit > 0 || repair_due
+		      || !has_source)) {
+    if (encoder->repair_credit > 0)
+      encoder->repair_credit --;
+    else if (!repair_due)
+      return false; /* nothing requested */
+    encoder->nb_since_repair = 0;
+    encoder->nb_repair_sent ++;
+    encoder_generate_random(encoder, encoder->coef_pos_min, nb_sent, pkt);
+    return true;
+  }
+
+  if (!has_source)
+    return false;
+  encoder_generate_source(encoder, encoder->next_systematic, pkt);
+  encoder->next_systematic ++;
+  encoder->nb_since_repair ++;
+  encoder->nb_systematic_sent ++;
+  return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void encoder_pywrite(FILE* out, encoder_t* encoder)
+{
+  fprintf(out, "{ 'type':'encoder'");
+  fprintf(out, ", 'l':%u", encoder->log2_nb_bit_coef);
+  fprintf(out, ", 'coefPosMin':%u", encoder->coef_pos_min);
+  fprintf(out, ", 'nbSource':%u", encoder->nb_source);
+  fprintf(out, ", 'windowSize':%u", encoder->window_size);
+  fprintf(out, ", 'density':%u", encoder->density);
+  fprintf(out, ", 'bandWidth':%u", encoder->band_width);
+  fprintf(out, ", 'nextSystematic':%u", encoder->next_systematic);
+  fprintf(out, ", 'repairInterval':%u", encoder->repair_interval);
+  fprintf(out, ", 'repairCredit':%u", encoder->repair_credit);
+  fprintf(out, ", 'nbSystematicSent':%u", encoder->nb_systematic_sent);
+  fprintf(out, ", 'nbRepairSent':%u", encoder->nb_repair_sent);
+  fprintf(out, " }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
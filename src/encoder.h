@@ -0,0 +1,345 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Sliding window encoder
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __ENCODER_H__
+#define __ENCODER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "coded-packet.h"
+#include "packet-set.h"
+#include "coef-generator.h"
+
+/*---------------------------------------------------------------------------*/
+
+/* Maximum number of source packets in the window of the encoder 
+   (it is also limited by the window of the encoding vector) */
+#ifdef CONF_ENCODER_MAX_WINDOW
+#define ENCODER_MAX_WINDOW CONF_ENCODER_MAX_WINDOW
+#else /* CONF_ENCODER_MAX_WINDOW */
+#define ENCODER_MAX_WINDOW MAX_CODED_PACKET
+#endif /* CONF_ENCODER_MAX_WINDOW */
+
+/* Number of accumulators of the encoder: each one is kept equal to a fixed 
+   pseudo-random combination of all the source packets of the window (with
+   its own coefficients), and updated when a source packet enters or 
+   leaves the window (see encoder_generate_accumulated). 0 disables them. */
+#ifdef CONF_ENCODER_NB_ACCUMULATOR
+#define ENCODER_NB_ACCUMULATOR CONF_ENCODER_NB_ACCUMULATOR
+#else /* CONF_ENCODER_NB_ACCUMULATOR */
+#define ENCODER_NB_ACCUMULATOR 0
+#endif /* CONF_ENCODER_NB_ACCUMULATOR */
+
+/* Density of the coefficients of a coded packet (see encoder_set_density),
+   in 1/ENCODER_DENSITY_FULL */
+#define ENCODER_DENSITY_FULL 256
+
+/* Maximum number of receiver states given to encoder_generate_innovative */
+#ifdef CONF_ENCODER_MAX_RECEIVER
+#define ENCODER_MAX_RECEIVER CONF_ENCODER_MAX_RECEIVER
+#else /* CONF_ENCODER_MAX_RECEIVER */
+#define ENCODER_MAX_RECEIVER 16
+#endif /* CONF_ENCODER_MAX_RECEIVER */
+
+/**
+ * @brief encoder_t holds the window of source packets that are being
+ *        encoded, in a ring indexed by source index (coef_pos).
+ *        Source packets enter the window with encoder_add_source, and
+ *        leave it when they are acknowledged or when the window is full.
+ */
+typedef struct {
+  uint8_t source[ENCODER_MAX_WINDOW][CODED_PACKET_SIZE]; /**< the source packet of index `coef_pos` is at `coef_pos % ENCODER_MAX_WINDOW`, padded with zeros */
+  uint16_t source_size[ENCODER_MAX_WINDOW]; /**< size of each source packet */
+
+  uint16_t coef_pos_min;  /**< lowest source index of the window */
+  uint16_t nb_source;     /**< number of source packets in the window */
+  uint16_t window_size;   /**< maximum number of source packets in the window */
+  uint8_t log2_nb_bit_coef; /**< same as in packet_set_t */
+  coef_generator_t generator; /**< generator of the coefficients */
+  uint16_t density;       /**< probability that a coefficient is not `0`, in 1/ENCODER_DENSITY_FULL */
+  uint16_t band_width;    /**< maximum number of consecutive source packets combined in one coded packet, 0 for the whole window */
+
+  /* systematic mode (encoder_next_packet) */
+  uint16_t next_systematic; /**< index of the next source packet to send uncoded */
+  uint16_t repair_interval; /**< one repair packet every `repair_interval` source packets, 0 for none */
+  uint16_t nb_since_repair; /**< source packets sent since the last repair packet */
+  uint16_t repair_credit;   /**< repair packets requested by loss feedback */
+  uint32_t nb_systematic_sent; /**< statistics */
+  uint32_t nb_repair_sent;     /**< statistics */
+
+#if ENCODER_NB_ACCUMULATOR > 0
+  coded_packet_t accumulator[ENCODER_NB_ACCUMULATOR]; /**< running combinations of the window */
+  uint64_t accumulator_seed; /**< seed of the coefficients of the accumulators */
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+} encoder_t;
+
+/**
+ * @brief     Initializes one encoder.
+ * @param[in] encoder is the encoder
+ * @param[in] log2_nb_bit_coef specifies which of GF(2), GF(4), GF(16), 
+ *            GF(256) is used (it would be `0,1,2,3` respectively).
+ * @param[in] window_size is the maximum number of source packets in the 
+ *            window; `0` means the largest possible one (ENCODER_MAX_WINDOW,
+ *            or less for the window of the encoding vector).
+ * @param[in] seed is the seed of the coefficient generator (coef_generator_t):
+ *            the same seed gives the same sequence of coded packets.
+ */
+void encoder_init(encoder_t* encoder, uint8_t log2_nb_bit_coef,
+		  uint16_t window_size, uint64_t seed);
+
+/**
+ * @brief     Set the density of the random coded packets (encoder_generate,
+ *            and repair packets of encoder_next_packet): sparse packets are
+ *            cheaper to encode and to decode, but a few more of them are
+ *            needed to decode.
+ * @param[in] encoder is the encoder
+ * @param[in] density is the probability that a coefficient is not `0`, in
+ *            1/ENCODER_DENSITY_FULL (the default is ENCODER_DENSITY_FULL);
+ *            the coefficient of the highest source index of the combination
+ *            is never `0`.
+ * @param[in] band_width is the maximum number of consecutive source packets
+ *            that are combined (a band at a random position in the window,
+ *            shorter when it overlaps one of its ends), `0` for the whole
+ *            window (the default).
+ */
+static inline void encoder_set_density(encoder_t* encoder, uint16_t density,
+				       uint16_t band_width)
+{
+  encoder->density = MIN(density, ENCODER_DENSITY_FULL);
+  encoder->band_width = band_width;
+}
+
+/**
+ * @brief     Indicates whether the window of the encoder is empty.
+ */
+static inline bool encoder_is_empty(encoder_t* encoder)
+{ return encoder->nb_source == 0; }
+
+/**
+ * @brief     Returns the source index following the highest one of 
+ *            the window, i.e. the index of the next added source packet.
+ */
+static inline uint16_t encoder_get_next_coef_pos(encoder_t* encoder)
+{ return encoder->coef_pos_min + encoder->nb_source; }
+
+/**
+ * @brief     Add one source packet in the window of the encoder; if the 
+ *            window is full, the lowest source packet is removed.
+ * @param[in] encoder is the encoder
+ * @param[in] data is the source packet (it is copied)
+ * @param[in] data_size is the size of the source packet (at most 
+ *            CODED_PACKET_SIZE)
+ * @return    the source index (coef_pos) of the source packet.
+ */
+uint16_t encoder_add_source(encoder_t* encoder, uint8_t* data,
+			    uint16_t data_size);
+
+/**
+ * @brief     Acknowledge source packets: all the source packets up to 
+ *            `coef_pos` (included) are removed from the window.
+ * @param[in] encoder is the encoder
+ * @param[in] coef_pos is the highest acknowledged source index.
+ */
+void encoder_ack(encoder_t* encoder, uint16_t coef_pos);
+
+/**
+ * @brief     Get one source packet of the window.
+ * @param[in] encoder is the encoder
+ * @param[in] coef_pos is the source index
+ * @return    the source packet (owned by the encoder), or NULL if it is
+ *            not in the window.
+ */
+uint8_t* encoder_get_source(encoder_t* encoder, uint16_t coef_pos);
+
+/**
+ * @brief     Generate one coded packet with given coefficients, over the
+ *            source packets `coef_pos_min` to `coef_pos_min+nb_coef-1`,
+ *            which must be in the window.
+ * @param[in]  encoder is the encoder
+ * @param[in]  coef_pos_min is the lowest source index of the combination
+ * @param[in]  coef_table is the array of `nb_coef` coefficients
+ * @param[in]  nb_coef is the number of coefficients
+ * @param[out] pkt is the resulting coded packet
+ */
+void encoder_generate_with_coefs(encoder_t* encoder, uint16_t coef_pos_min,
+				 uint8_t* coef_table, uint16_t nb_coef,
+				 coded_packet_t* pkt);
+
+/**
+ * @brief     Generate one coded packet, a random linear combination of all
+ *            the source packets of the window (the coefficient of the 
+ *            highest one is never `0`), or of a part of them, depending on
+ *            the density (see encoder_set_density).
+ * @param[in]  encoder is the encoder
+ * @param[out] pkt is the resulting coded packet
+ * @return     true if a packet was generated, false if the window is empty.
+ */
+bool encoder_generate(encoder_t* encoder, coded_packet_t* pkt);
+
+/**
+ * @brief     Generate the coded packet holding only one source packet
+ *            (with a coefficient `1`).
+ * @param[in]  encoder is the encoder
+ * @param[in]  coef_pos is the source index, it must be in the window
+ * @param[out] pkt is the resulting coded packet
+ */
+void encoder_generate_source(encoder_t* encoder, uint16_t coef_pos,
+			     coded_packet_t* pkt);
+
+/**
+ * @brief     Generate one coded packet that is innovative for as many
+ *            receivers as possible, given their decoding state (see
+ *            packet_set_get_receiver_state).
+ * @param[in]  encoder is the encoder
+ * @param[in]  state_table is an array of `nb_state` receiver states
+ * @param[in]  nb_state is the number of receivers (at most 
+ *             ENCODER_MAX_RECEIVER)
+ * @param[out] pkt is the resulting coded packet
+ * @param[out] innovative_table (optional, can be NULL) is an array of
+ *             `nb_state` booleans, set to true for the receivers for which
+ *             the coded packet is guaranteed to be innovative.
+ * @return     true if a packet was generated, false if the window is empty
+ *             or if every receiver has decoded all of it.
+ * @details    A coded packet is innovative for a receiver when its highest
+ *             source index that the receiver has not decoded is not seen by
+ *             it. The packet ends at the lowest source index that can
+ *             make it innovative for every receiver, and always covers the
+ *             lowest source index that a receiver has not decoded, so that
+ *             late receivers can still add it. The source indices are 
+ *             selected greedily down from there, with a cost in
+ *             O(window size * nb_state), and are combined with random 
+ *             non-zero coefficients. The guarantee
+ *             assumes that the receiver can still eliminate its decoded 
+ *             source packets (store of decoded packets or callback).
+ */
+bool encoder_generate_innovative(encoder_t* encoder,
+				 receiver_state_t* state_table,
+				 uint16_t nb_state, coded_packet_t* pkt,
+				 bool* innovative_table);
+
+#if ENCODER_NB_ACCUMULATOR > 0
+/**
+ * @brief     Returns the coefficient of the source packet 
+ *            `coef_pos` in the accumulator `index`: it is the same for as
+ *            long as the source packet is in the window. Each accumulator
+ *            has its own coefficients, all non-zero; except in GF(2), where
+ *            only the ones of the accumulator `0` are (all `1`), and the
+ *            others are random bits.
+ */
+static inline uint8_t encoder_get_accumulator_coef(encoder_t* encoder,
+						   uint16_t index,
+						   uint16_t coef_pos)
+{ 
+  uint8_t l = encoder->log2_nb_bit_coef;
+  return coef_generator_get_coef
+    (encoder->accumulator_seed, 
+     (uint32_t)coef_pos * ENCODER_NB_ACCUMULATOR + index, l,
+     (index == 0 || l > 0) ? COEF_GENERATOR_NONZERO : 0);
+}
+
+/**
+ * @brief     Generate one coded packet, as a random linear combination 
+ *            of the accumulators: its cost is ENCODER_NB_ACCUMULATOR row 
+ *            operations, whatever the size of the window (and each source
+ *            packet costs ENCODER_NB_ACCUMULATOR row operations when it 
+ *            enters the window, and again when it leaves it).
+ * @param[in]  encoder is the encoder
+ * @param[out] pkt is the resulting coded packet
+ * @return     true if a packet was generated, false if the window is empty.
+ * @details    The accumulators span at most ENCODER_NB_ACCUMULATOR
+ *             dimensions: for the same window, no more packets should be
+ *             generated (that is, no more than ENCODER_NB_ACCUMULATOR
+ *             coded packets between two source packets). The newest
+ *             source packet is always combined with a non-zero 
+ *             coefficient.
+ */
+bool encoder_generate_accumulated(encoder_t* encoder, coded_packet_t* pkt);
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+
+/*--------------------------------------------------*/
+
+/**
+ * @brief     Set the rate of repair packets in systematic mode: one repair
+ *            packet is sent after every `repair_interval` source packets
+ *            (`0` for none: only repair packets requested by 
+ *            `encoder_notify_loss` are sent).
+ */
+static inline void encoder_set_repair_interval(encoder_t* encoder,
+					       uint16_t repair_interval)
+{ encoder->repair_interval = repair_interval; }
+
+/**
+ * @brief     Request repair packets in systematic mode, in response to 
+ *            loss feedback from the receiver(s).
+ * @param[in] encoder is the encoder
+ * @param[in] nb_lost is the number of packets reported lost; one repair
+ *            packet will be sent for each of them.
+ */
+void encoder_notify_loss(encoder_t* encoder, uint16_t nb_lost);
+
+/**
+ * @brief     Get the next packet to send in systematic mode: each source 
+ *            packet is sent once uncoded (as with encoder_generate_source),
+ *            interleaved with repair packets (random linear combinations 
+ *            of the source packets that were sent and not acknowledged),
+ *            according to the repair interval and the repair credit.
+ * @param[in]  encoder is the encoder
+ * @param[out] pkt is the resulting coded packet
+ * @return     true if a packet was generated, false if there is nothing 
+ *             to send.
+ */
+bool encoder_next_packet(encoder_t* encoder, coded_packet_t* pkt);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void encoder_pywrite(FILE* out, encoder_t* encoder);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ENCODER_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
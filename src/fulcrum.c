@@ -0,0 +1,130 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Fulcrum coding: outer GF(256) code, inner GF(2) code
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "fulcrum.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define OUTER_LOG2_NB_BIT_COEF 3 /* GF(256) */
+#define INNER_LOG2_NB_BIT_COEF 0 /* GF(2) */
+
+bool fulcrum_encoder_init(fulcrum_encoder_t* encoder, uint16_t k, uint16_t r,
+			  uint64_t seed)
+{
+  if (r == 0 || k + r > (1<<log2_window_size(INNER_LOG2_NB_BIT_COEF)))
+    return false;
+  if (!block_encoder_init(&encoder->outer, OUTER_LOG2_NB_BIT_COEF, k, r))
+    return false;
+  coef_generator_init(&encoder->generator, seed);
+  encoder->coef_pos_base = 0;
+  encoder->data_size = 0;
+  return true;
+}
+
+void fulcrum_encoder_set_block(fulcrum_encoder_t* encoder,
+			       uint16_t coef_pos_base, uint8_t** source_table,
+			       uint16_t data_size)
+{
+  uint16_t j;
+  REQUIRE( data_size <= CODED_PACKET_SIZE );
+  encoder->coef_pos_base = coef_pos_base;
+  encoder->data_size = data_size;
+  for (j=0; j<encoder->outer.k; j++)
+    encoder->source_table[j] = source_table[j];
+  block_encoder_generate(&encoder->outer, coef_pos_base, source_table,
+			 data_size, encoder->expansion);
+}
+
+void fulcrum_encoder_generate(fulcrum_encoder_t* encoder, coded_packet_t* pkt)
+{
+  uint8_t coef_table[BLOCK_MAX_K+BLOCK_MAX_M];
+  uint8_t* data_table[BLOCK_MAX_K+BLOCK_MAX_M];
+  uint16_t k = encoder->outer.k;
+  uint16_t n = k + encoder->outer.m;
+  uint16_t i;
+
+  for (i=0; i<k; i++)
+    data_table[i] = encoder->source_table[i];
+  for (i=k; i<n; i++)
+    data_table[i] = coded_packet_data(&encoder->expansion[i-k]);
+  coef_generator_fill(&encoder->generator, INNER_LOG2_NB_BIT_COEF,
+		      coef_table, n, COEF_GENERATOR_LEADING_NONZERO);
+
+  coded_packet_init(pkt, INNER_LOG2_NB_BIT_COEF);
+  for (i=0; i<n; i++)
+    if (coef_table[i] != 0)
+      coded_packet_set_coef(pkt, encoder->coef_pos_base+i, 1);
+  lc_vector_linear_combination(coef_table, data_table, n, encoder->data_size,
+			       INNER_LOG2_NB_BIT_COEF, coded_packet_data(pkt));
+  pkt->data_size = encoder->data_size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void fulcrum_map_to_outer(block_encoder_t* outer, uint16_t coef_pos_base,
+			  coded_packet_t* pkt, coded_packet_t* result)
+{
+  uint8_t coef_table[BLOCK_MAX_K];
+  uint16_t k = outer->k;
+  uint16_t i, j;
+
+  REQUIRE( pkt->log2_nb_bit_coef == INNER_LOG2_NB_BIT_COEF );
+  REQUIRE( outer->log2_nb_bit_coef == OUTER_LOG2_NB_BIT_COEF );
+  memset(coef_table, 0, k);
+  if (pkt->coef_pos_min != COEF_POS_NONE)
+    for (i=pkt->coef_pos_min; i<=pkt->coef_pos_max; i++) {
+      if (coded_packet_get_coef(pkt, i) == 0)
+	continue;
+      ASSERT( i >= coef_pos_base && i < coef_pos_base + k + outer->m );
+      uint16_t index = i - coef_pos_base;
+      if (index < k)
+	coef_table[index] ^= 1;
+      else for (j=0; j<k; j++) /* addition in GF(256) */
+	coef_table[j] ^= block_encoder_get_coef(outer, index-k, j);
+    }
+
+  coded_packet_init(result, OUTER_LOG2_NB_BIT_COEF);
+  for (j=0; j<k; j++)
+    if (coef_table[j] != 0)
+      coded_packet_set_coef(result, coef_pos_base+j, coef_table[j]);
+  memcpy(coded_packet_data(result), coded_packet_data(pkt), pkt->data_size);
+  result->data_size = pkt->data_size;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
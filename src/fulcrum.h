@@ -0,0 +1,137 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Fulcrum coding: outer GF(256) code, inner GF(2) code
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __FULCRUM_H__
+#define __FULCRUM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "coded-packet.h"
+#include "block-encoder.h"
+#include "coef-generator.h"
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * @brief fulcrum_encoder_t encodes blocks of `K` source packets in two
+ *        steps: the outer code (a block_encoder_t in GF(256)) expands them
+ *        with `R` expansion packets, then the inner code sends random 
+ *        GF(2) combinations of the `N = K+R` packets.
+ *
+ * @details A block uses the source indices `coef_pos_base` to 
+ *        `coef_pos_base+N-1`: the source packets first, then the expansion
+ *        packets. A receiver can decode the coded packets in two ways:
+ *        - inner decoding: the packets are added as they are to a packet 
+ *          set in GF(2) (XOR only), which decodes the `N` packets after 
+ *          about `N` coded packets.
+ *        - outer decoding: each packet is mapped to a combination of the 
+ *          `K` source packets in GF(256) with fulcrum_map_to_outer, and 
+ *          added to a packet set in GF(256), which decodes the block after
+ *          about `K` coded packets.
+ *        `K` is at most 16 (window of the encoding vector in GF(256)), 
+ *        `R` at most BLOCK_MAX_M.
+ */
+typedef struct {
+  block_encoder_t outer;  /**< the outer code, GF(256) */
+  coef_generator_t generator; /**< generator of the inner coefficients */
+  uint16_t coef_pos_base; /**< source index of the first source packet */
+  uint16_t data_size;     /**< size of the packets of the block */
+  uint8_t* source_table[BLOCK_MAX_K]; /**< the source packets (not copied) */
+  coded_packet_t expansion[BLOCK_MAX_M]; /**< the expansion packets */
+} fulcrum_encoder_t;
+
+/**
+ * @brief     Initializes one Fulcrum encoder.
+ * @param[in] encoder is the Fulcrum encoder
+ * @param[in] k is the number of source packets per block
+ * @param[in] r is the number of expansion packets per block
+ * @param[in] seed is the seed of the generator of inner coefficients
+ * @return    true on success, false if the parameters are not supported.
+ */
+bool fulcrum_encoder_init(fulcrum_encoder_t* encoder, uint16_t k, uint16_t r,
+			  uint64_t seed);
+
+/**
+ * @brief     Set the current block of source packets, and compute its 
+ *            expansion packets (outer code).
+ * @param[in] encoder is the Fulcrum encoder
+ * @param[in] coef_pos_base is the source index of the first source packet
+ * @param[in] source_table is the array of the `K` source packets; they are
+ *            not copied, and must remain unchanged while the block is
+ *            encoded.
+ * @param[in] data_size is the size of the source packets (shorter ones 
+ *            must be padded with zeros by the caller)
+ */
+void fulcrum_encoder_set_block(fulcrum_encoder_t* encoder,
+			       uint16_t coef_pos_base, uint8_t** source_table,
+			       uint16_t data_size);
+
+/**
+ * @brief     Generate one coded packet of the current block: a random
+ *            GF(2) combination of its source and expansion packets.
+ * @param[in]  encoder is the Fulcrum encoder
+ * @param[out] pkt is the resulting coded packet, in GF(2)
+ */
+void fulcrum_encoder_generate(fulcrum_encoder_t* encoder, coded_packet_t* pkt);
+
+/**
+ * @brief     Map one coded packet of the inner code (GF(2)) to the 
+ *            equivalent combination of the source packets of the block, in 
+ *            GF(256), for outer decoding.
+ * @param[in]  outer is the outer code, with the same `K` and `R` as the
+ *             encoder (block_encoder_init with GF(256))
+ * @param[in]  coef_pos_base is the source index of the first source packet
+ *             of the block
+ * @param[in]  pkt is the coded packet of the inner code
+ * @param[out] result is the resulting coded packet, in GF(256)
+ * @details    The payload is copied as it is: only the encoding vector is
+ *             mapped, with `R*K` additions at most.
+ */
+void fulcrum_map_to_outer(block_encoder_t* outer, uint16_t coef_pos_base,
+			  coded_packet_t* pkt, coded_packet_t* result);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FULCRUM_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
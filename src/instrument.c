@@ -0,0 +1,237 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Optional instrumentation: cumulative counters of the field
+ *          kernels and of the coded packets, and timing
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "instrument.h"
+
+#ifdef CONF_WITH_INSTRUMENT
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_PTHREAD
+
+#include <pthread.h>
+
+_Thread_local instrument_thread_t instrument_thread;
+
+static pthread_mutex_t instrument_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t instrument_once = PTHREAD_ONCE_INIT;
+static pthread_key_t instrument_key; /* to be notified of exiting threads */
+static instrument_thread_t* instrument_thread_list = NULL;
+static uint64_t instrument_exited[INSTRUMENT_NB_COUNTER]; /* counters of the threads that have exited */
+
+/* called when a registered thread exits: its counters are moved to
+   instrument_exited (and reset, in case it is registered again by a later
+   destructor) */
+static void instrument_unregister_thread(void* data)
+{
+  instrument_thread_t* thread = data;
+  instrument_thread_t** ptr;
+  uint16_t i;
+  pthread_mutex_lock(&instrument_mutex);
+  for (i=0; i<INSTRUMENT_NB_COUNTER; i++) {
+    instrument_exited[i] += INSTRUMENT_LOAD(thread->counter[i]);
+    INSTRUMENT_STORE(thread->counter[i], 0);
+  }
+  for (ptr = &instrument_thread_list; *ptr != NULL; ptr = &(*ptr)->next)
+    if (*ptr == thread) {
+      *ptr = thread->next;
+      break;
+    }
+  thread->is_registered = false;
+  pthread_mutex_unlock(&instrument_mutex);
+}
+
+static void instrument_init_key(void)
+{
+  if (pthread_key_create(&instrument_key, instrument_unregister_thread) != 0)
+    FATAL("pthread_key_create failed");
+}
+
+void instrument_register_thread(void)
+{
+  instrument_thread_t* thread = &instrument_thread;
+  pthread_once(&instrument_once, instrument_init_key);
+  pthread_mutex_lock(&instrument_mutex);
+  thread->next = instrument_thread_list;
+  instrument_thread_list = thread;
+  thread->is_registered = true;
+  pthread_mutex_unlock(&instrument_mutex);
+  pthread_setspecific(instrument_key, thread);
+}
+
+void instrument_get_snapshot(instrument_snapshot_t* snapshot)
+{
+  instrument_thread_t* thread;
+  uint16_t i;
+  pthread_mutex_lock(&instrument_mutex);
+  memcpy(snapshot->counter, instrument_exited, sizeof(snapshot->counter));
+  for (thread = instrument_thread_list; thread != NULL; thread = thread->next)
+    for (i=0; i<INSTRUMENT_NB_COUNTER; i++)
+      snapshot->counter[i] += INSTRUMENT_LOAD(thread->counter[i]);
+  pthread_mutex_unlock(&instrument_mutex);
+}
+
+#else /* CONF_WITH_PTHREAD */
+
+instrument_thread_t instrument_thread;
+
+void instrument_register_thread(void)
+{ instrument_thread.is_registered = true; }
+
+void instrument_get_snapshot(instrument_snapshot_t* snapshot)
+{
+  uint16_t i;
+  for (i=0; i<INSTRUMENT_NB_COUNTER; i++)
+    snapshot->counter[i] = instrument_thread.counter[i];
+}
+
+#endif /* CONF_WITH_PTHREAD */
+
+void instrument_snapshot_diff(instrument_snapshot_t* result,
+			      instrument_snapshot_t* after,
+			      instrument_snapshot_t* before)
+{
+  uint16_t i;
+  for (i=0; i<INSTRUMENT_NB_COUNTER; i++)
+    result->counter[i] = after->counter[i] - before->counter[i];
+}
+
+void instrument_time_stat_accumulate(instrument_time_stat_t* total,
+				     instrument_time_stat_t* stat)
+{
+  uint16_t i;
+  total->count += stat->count;
+  total->total += stat->total;
+  total->max = MAX(total->max, stat->max);
+  for (i=0; i<INSTRUMENT_NB_BUCKET; i++)
+    total->histogram[i] += stat->histogram[i];
+}
+
+uint64_t instrument_time_stat_get_percentile(instrument_time_stat_t* stat,
+					     uint8_t percent)
+{
+  REQUIRE( percent <= 100 );
+  if (stat->count == 0)
+    return 0;
+  /* rank (from 1) of the time of the percentile */
+  uint64_t rank = ((uint64_t)stat->count * percent + 99) / 100;
+  uint32_t nb_below = 0;
+  uint16_t i;
+  if (rank == 0)
+    rank = 1;
+  for (i=0; i<INSTRUMENT_NB_BUCKET; i++) {
+    if (nb_below + stat->histogram[i] >= rank)
+      break;
+    nb_below += stat->histogram[i];
+  }
+  if (i == 0)
+    return 0;
+  if (i == INSTRUMENT_NB_BUCKET) /* (not possible if consistent) */
+    return stat->max;
+  uint64_t low = 1ull << (i-1);
+  uint64_t high = (i == INSTRUMENT_NB_BUCKET-1) ? stat->max : (1ull << i);
+  if (high < low)
+    high = low;
+  uint64_t result = low + (high - low) * (rank - nb_below) 
+    / stat->histogram[i];
+  return MIN(result, stat->max);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+static void instrument_field_pywrite(FILE* out, const char* name,
+				     uint64_t* counter)
+{
+  uint16_t l;
+  fprintf(out, ", '%s':[", name);
+  for (l=0; l<INSTRUMENT_NB_FIELD; l++)
+    fprintf(out, "%s%llu", (l == 0) ? "" : ",", 
+	    (unsigned long long)counter[l]);
+  fprintf(out, "]");
+}
+
+void instrument_snapshot_pywrite(FILE* out, instrument_snapshot_t* snapshot)
+{
+  uint64_t* counter = snapshot->counter;
+  fprintf(out, "{ 'type':'instrument-snapshot'");
+  instrument_field_pywrite(out, "nbMulAdd", counter + INSTRUMENT_NB_MUL_ADD);
+  instrument_field_pywrite(out, "byteMulAdd", 
+			   counter + INSTRUMENT_BYTE_MUL_ADD);
+  instrument_field_pywrite(out, "nbMul", counter + INSTRUMENT_NB_MUL);
+  instrument_field_pywrite(out, "byteMul", counter + INSTRUMENT_BYTE_MUL);
+  fprintf(out, ", 'nbAdd':%llu", 
+	  (unsigned long long)counter[INSTRUMENT_NB_ADD]);
+  fprintf(out, ", 'byteAdd':%llu", 
+	  (unsigned long long)counter[INSTRUMENT_BYTE_ADD]);
+  fprintf(out, ", 'nbAdjust':%llu", 
+	  (unsigned long long)counter[INSTRUMENT_NB_ADJUST]);
+  fprintf(out, ", 'adjustStep':%llu", 
+	  (unsigned long long)counter[INSTRUMENT_ADJUST_STEP]);
+  fprintf(out, " }");
+}
+
+void instrument_time_stat_pywrite(FILE* out, instrument_time_stat_t* stat)
+{
+  uint16_t i;
+  fprintf(out, "{ 'type':'time-stat', 'unit':'%s'", INSTRUMENT_TIME_UNIT);
+  fprintf(out, ", 'count':%u", stat->count);
+  fprintf(out, ", 'total':%llu", (unsigned long long)stat->total);
+  fprintf(out, ", 'max':%llu", (unsigned long long)stat->max);
+  fprintf(out, ", 'p50':%llu", (unsigned long long)
+	  instrument_time_stat_get_percentile(stat, 50));
+  fprintf(out, ", 'p90':%llu", (unsigned long long)
+	  instrument_time_stat_get_percentile(stat, 90));
+  fprintf(out, ", 'p99':%llu", (unsigned long long)
+	  instrument_time_stat_get_percentile(stat, 99));
+  fprintf(out, ", 'histogram':[");
+  for (i=0; i<INSTRUMENT_NB_BUCKET; i++)
+    fprintf(out, "%s%u", (i == 0) ? "" : ",", stat->histogram[i]);
+  fprintf(out, "] }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_INSTRUMENT */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,245 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Optional instrumentation: cumulative counters of the field
+ *          kernels and of the coded packets, and timing
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __INSTRUMENT_H__
+#define __INSTRUMENT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "general.h"
+#include "linear-code.h"
+
+/* The instrumentation is compiled in only with CONF_WITH_INSTRUMENT: 
+   otherwise INSTRUMENT_COUNT does nothing. */
+#ifdef CONF_WITH_INSTRUMENT
+
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif /* defined(__x86_64__) || defined(__i386__) */
+#ifdef CONF_WITH_PTHREAD
+#include <stdatomic.h>
+#endif /* CONF_WITH_PTHREAD */
+
+/*---------------------------------------------------------------------------*/
+
+/* Global counters: the ones of kernels are indexed by the field 
+   (log2_nb_bit_coef, from 0 to MAX_LOG2_NB_BIT_COEF) */
+#define INSTRUMENT_NB_FIELD (MAX_LOG2_NB_BIT_COEF+1)
+
+#define INSTRUMENT_NB_MUL_ADD   0 /* calls of lc_vector_mul_add (+ field) */
+#define INSTRUMENT_BYTE_MUL_ADD (INSTRUMENT_NB_MUL_ADD+INSTRUMENT_NB_FIELD) /* bytes multiplied and added (+ field) */
+#define INSTRUMENT_NB_MUL       (INSTRUMENT_BYTE_MUL_ADD+INSTRUMENT_NB_FIELD) /* calls of lc_vector_mul (+ field) */
+#define INSTRUMENT_BYTE_MUL     (INSTRUMENT_NB_MUL+INSTRUMENT_NB_FIELD) /* bytes multiplied (+ field) */
+#define INSTRUMENT_NB_ADD       (INSTRUMENT_BYTE_MUL+INSTRUMENT_NB_FIELD) /* calls of lc_vector_add */
+#define INSTRUMENT_BYTE_ADD     (INSTRUMENT_NB_ADD+1) /* bytes XORed by lc_vector_add */
+#define INSTRUMENT_NB_ADJUST    (INSTRUMENT_BYTE_ADD+1) /* calls of coded_packet_adjust_min_max_coef */
+#define INSTRUMENT_ADJUST_STEP  (INSTRUMENT_NB_ADJUST+1) /* coefficients it scanned */
+#define INSTRUMENT_NB_COUNTER   (INSTRUMENT_ADJUST_STEP+1)
+
+/* Number of buckets of the histograms of times (instrument_time_stat_t) */
+#define INSTRUMENT_NB_BUCKET 32
+
+#if defined(__x86_64__) || defined(__i386__)
+#define INSTRUMENT_TIME_UNIT "cycles"
+#else /* defined(__x86_64__) || defined(__i386__) */
+#define INSTRUMENT_TIME_UNIT "ns"
+#endif /* defined(__x86_64__) || defined(__i386__) */
+
+#ifdef CONF_WITH_PTHREAD
+typedef _Atomic uint64_t instrument_counter_t;
+#define INSTRUMENT_LOAD(counter) \
+  atomic_load_explicit(&(counter), memory_order_relaxed)
+#define INSTRUMENT_STORE(counter, value) \
+  atomic_store_explicit(&(counter), (value), memory_order_relaxed)
+#else /* CONF_WITH_PTHREAD */
+typedef uint64_t instrument_counter_t;
+#define INSTRUMENT_LOAD(counter) (counter)
+#define INSTRUMENT_STORE(counter, value) ((counter) = (value))
+#endif /* CONF_WITH_PTHREAD */
+
+/**
+ * @brief instrument_thread_t holds the global counters updated by one 
+ *        thread: it is their only writer, hence no atomic read-modify-write
+ *        is needed. They are summed by instrument_get_snapshot.
+ */
+typedef struct s_instrument_thread_t {
+  instrument_counter_t counter[INSTRUMENT_NB_COUNTER];
+  struct s_instrument_thread_t* next; /**< in the list of threads */
+  bool is_registered;
+} instrument_thread_t;
+
+/**
+ * @brief instrument_snapshot_t is a copy of the global counters, summed
+ *        over all the threads (including the ones that have exited).
+ */
+typedef struct {
+  uint64_t counter[INSTRUMENT_NB_COUNTER];
+} instrument_snapshot_t;
+
+#ifdef CONF_WITH_PTHREAD
+extern _Thread_local instrument_thread_t instrument_thread;
+#else /* CONF_WITH_PTHREAD */
+extern instrument_thread_t instrument_thread;
+#endif /* CONF_WITH_PTHREAD */
+
+/**
+ * @brief     (Internal) Registers the counters of the calling thread, so 
+ *            that they are included in the snapshots.
+ */
+void instrument_register_thread(void);
+
+/**
+ * @brief     Increments one global counter of the calling thread.
+ */
+static inline void instrument_count(uint16_t index, uint64_t value)
+{
+  instrument_thread_t* thread = &instrument_thread;
+  if (!thread->is_registered)
+    instrument_register_thread();
+  INSTRUMENT_STORE(thread->counter[index], 
+		   INSTRUMENT_LOAD(thread->counter[index]) + value);
+}
+
+#define INSTRUMENT_COUNT(index, value) instrument_count((index), (value))
+
+/**
+ * @brief     Returns the current time, in INSTRUMENT_TIME_UNIT (the time
+ *            stamp counter on x86, otherwise the monotonic clock).
+ */
+static inline uint64_t instrument_get_time(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else /* defined(__x86_64__) || defined(__i386__) */
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif /* defined(__x86_64__) || defined(__i386__) */
+}
+
+/**
+ * @brief instrument_time_stat_t summarizes a series of times (or delays):
+ *        their number, sum, maximum and histogram. Bucket `i` of the 
+ *        histogram counts the times in [2^(i-1), 2^i) (bucket 0 is for 0),
+ *        the last one also counts all the higher times.
+ */
+typedef struct {
+  uint32_t count; /**< */
+  uint64_t total; /**< */
+  uint64_t max;   /**< */
+  uint32_t histogram[INSTRUMENT_NB_BUCKET]; /**< */
+} instrument_time_stat_t;
+
+static inline void instrument_time_stat_init(instrument_time_stat_t* stat)
+{ memset(stat, 0, sizeof(instrument_time_stat_t)); }
+
+/**
+ * @brief     Adds one time to `stat`.
+ */
+static inline void instrument_time_stat_add(instrument_time_stat_t* stat,
+					    uint64_t time)
+{
+  uint16_t bucket = (time == 0) ? 0 : 64 - __builtin_clzll(time);
+  stat->histogram[MIN(bucket, INSTRUMENT_NB_BUCKET-1)] ++;
+  stat->count ++;
+  stat->total += time;
+  stat->max = MAX(stat->max, time);
+}
+
+/**
+ * @brief     Adds all the times of `stat` to `total` (e.g. to aggregate the
+ *            ones of several packet sets).
+ */
+void instrument_time_stat_accumulate(instrument_time_stat_t* total,
+				     instrument_time_stat_t* stat);
+
+/**
+ * @brief     Estimates a percentile of the times of `stat`, from its 
+ *            histogram (by linear interpolation inside the bucket, hence
+ *            within a factor 2).
+ * @param[in] percent is the percentile, from 0 to 100
+ * @return    the estimated time, at most `stat->max` (0 if there is none)
+ */
+uint64_t instrument_time_stat_get_percentile(instrument_time_stat_t* stat,
+					     uint8_t percent);
+
+/**
+ * @brief     Gets the global counters, summed over all the threads. The
+ *            counters are never reset: the activity during one period is
+ *            the difference of two snapshots (instrument_snapshot_diff).
+ * @param[out] snapshot is the result
+ */
+void instrument_get_snapshot(instrument_snapshot_t* snapshot);
+
+/**
+ * @brief     Computes `result = after - before`.
+ */
+void instrument_snapshot_diff(instrument_snapshot_t* result,
+			      instrument_snapshot_t* after,
+			      instrument_snapshot_t* before);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void instrument_snapshot_pywrite(FILE* out, instrument_snapshot_t* snapshot);
+
+void instrument_time_stat_pywrite(FILE* out, instrument_time_stat_t* stat);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#else /* CONF_WITH_INSTRUMENT */
+
+#define INSTRUMENT_COUNT(index, value) BEGIN_MACRO END_MACRO
+
+#endif /* CONF_WITH_INSTRUMENT */
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INSTRUMENT_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
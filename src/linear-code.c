@@ -36,6 +36,7 @@
 
 #include "general.h"
 #include "linear-code.h"
+#include "instrument.h"
 
 /*--------------------------------------------------*/
 
@@ -93,6 +94,8 @@ void lc_vector_add(uint8_t* data1, uint16_t size1,
   uint16_t i;
   uint16_t common_size = 0;
 
+  INSTRUMENT_COUNT(INSTRUMENT_NB_ADD, 1);
+  INSTRUMENT_COUNT(INSTRUMENT_BYTE_ADD, MIN(size1, size2));
   if (size1 <= size2) {
     common_size = size1;
     *result_size = size2;
@@ -167,6 +170,8 @@ void lc_vector_mul(uint8_t coef, uint8_t* data, uint16_t size,
 		   uint8_t log2_nb_bit_coef, uint8_t* result)
 {
   ASSERT( log2_nb_bit_coef <= MAX_LOG2_NB_BIT_COEF );
+  INSTRUMENT_COUNT(INSTRUMENT_NB_MUL + log2_nb_bit_coef, 1);
+  INSTRUMENT_COUNT(INSTRUMENT_BYTE_MUL + log2_nb_bit_coef, size);
   switch(log2_nb_bit_coef) {
   case 0: lc_vector_mul_gf2(coef, data, size, result); break;
   case 1: lc_vector_mul_gf4(coef, data, size, result); break;
@@ -182,6 +187,94 @@ void lc_vector_mul(uint8_t coef, uint8_t* data, uint16_t size,
 
 /*---------------------------------------------------------------------------*/
 
+#ifdef WITH_GF256
+static void lc_vector_mul_add_gf256(uint8_t coef, uint8_t* data, uint16_t size,
+				    uint8_t* result)
+{
+  uint16_t i;
+#ifdef WITH_GF256_MUL_TABLE
+  const uint8_t* mul_row = gf256_mul_table[coef];
+  for (i=0; i<size; i++)
+    result[i] ^= mul_row[data[i]];
+#else /* WITH_GF256_MUL_TABLE */
+  uint16_t log_coef = gf256_log_table[coef];
+  for (i=0; i<size; i++)
+    if (data[i] != 0) {
+      uint16_t log_res = log_coef + ((uint16_t)gf256_log_table[data[i]]);
+      log_res = (log_res + (log_res >> 8)) & 0xff; /* mod 255 */
+      result[i] ^= gf256_exp_table[log_res];
+    }
+#endif /* WITH_GF256_MUL_TABLE */
+}
+#endif /* WITH_GF256 */
+
+/* this function also operates correctly if data is exactly equal to result
+   (with coef = 1, the result is then 0) */
+void lc_vector_mul_add(uint8_t coef, uint8_t* data, uint16_t size,
+		       uint8_t log2_nb_bit_coef, uint8_t* result)
+{
+  ASSERT( log2_nb_bit_coef <= MAX_LOG2_NB_BIT_COEF );
+  if (coef == 0)
+    return;
+  INSTRUMENT_COUNT(INSTRUMENT_NB_MUL_ADD + log2_nb_bit_coef, 1);
+  INSTRUMENT_COUNT(INSTRUMENT_BYTE_MUL_ADD + log2_nb_bit_coef, size);
+  uint16_t i;
+  const uint8_t* mul_row = NULL;
+  switch(log2_nb_bit_coef) {
+  case 0: 
+    ASSERT( coef == 1 );
+    for (i=0; i<size; i++)
+      result[i] ^= data[i];
+    return;
+  case 1: ASSERT( coef < 4 ); mul_row = gf4_mul_table[coef]; break;
+#ifdef WITH_GF16
+  case 2: ASSERT( coef < 16 ); mul_row = gf16_mul_table[coef]; break;
+#endif /* WITH_GF16 */
+#ifdef WITH_GF256
+  case 3: lc_vector_mul_add_gf256(coef, data, size, result); return;
+#endif /* WITH_GF256 */
+  default: FATAL("invalid log2_nb_bit_coef");
+  }
+  for (i=0; i<size; i++)
+    result[i] ^= mul_row[data[i]];
+}
+
+void lc_vector_linear_combination(uint8_t* coef_table, uint8_t** data_table,
+				  uint16_t nb_data, uint16_t size,
+				  uint8_t log2_nb_bit_coef, uint8_t* result)
+{
+  memset(result, 0, size);
+  /* block by block: one block of the result stays in cache while all 
+     the vectors are accumulated into it */
+  uint16_t start, k;
+  for (start=0; start<size; start += LC_BLOCK_SIZE) {
+    uint16_t block_size = MIN(LC_BLOCK_SIZE, size-start);
+    for (k=0; k<nb_data; k++)
+      lc_vector_mul_add(coef_table[k], data_table[k]+start, block_size,
+			log2_nb_bit_coef, result+start);
+  }
+}
+
+void lc_matrix_mul(uint8_t* coef_matrix, uint16_t nb_row, uint16_t nb_col,
+		   uint8_t** data_table, uint16_t size,
+		   uint8_t log2_nb_bit_coef, uint8_t** result_table)
+{
+  uint16_t start, r, c;
+  for (start=0; start<size; start += LC_BLOCK_SIZE) {
+    uint16_t block_size = MIN(LC_BLOCK_SIZE, size-start);
+    for (r=0; r<nb_row; r++) {
+      uint8_t* coef_row = coef_matrix + r*nb_col;
+      uint8_t* result = result_table[r] + start;
+      memset(result, 0, block_size);
+      for (c=0; c<nb_col; c++)
+	lc_vector_mul_add(coef_row[c], data_table[c]+start, block_size,
+			  log2_nb_bit_coef, result);
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
 typedef uint_fast16_t uf16;
 typedef uint_fast8_t uf8;
 
@@ -172,6 +172,73 @@ void lc_vector_add(uint8_t* data1, uint16_t size1,
 void lc_vector_mul(uint8_t coef, uint8_t* data, uint16_t size,
 		   uint8_t log2_nb_bit_coef, uint8_t* result);
 
+/**
+ * @brief Add to one vector another vector multiplied by one element,
+ *        e.g. `result[i] += coef x data[i]` in the finite field.
+ * @param[in]     coef       Coefficient of the finite field
+ * @param[in]     data       Vector of elements
+ * @param[in]     size       Number of bytes (not elements) in the vectors
+ * @param[in]     log2_nb_bit_coef Defines the finite field, e.g.
+ *                           GF(\f$2^{(2^L)}\f$) where `L = log2_nb_bit_coef`
+ * @param[in,out] result     Vector to which `coef x data` is added
+ * @details `result` should point to a memory area disjoint from `data`
+ *          (or strictly equal).
+ */
+void lc_vector_mul_add(uint8_t coef, uint8_t* data, uint16_t size,
+		       uint8_t log2_nb_bit_coef, uint8_t* result);
+
+/**
+ * Number of bytes of the result computed at once by 
+ * `lc_vector_linear_combination`.
+ */
+#ifdef CONF_LC_BLOCK_SIZE
+#define LC_BLOCK_SIZE CONF_LC_BLOCK_SIZE
+#else /* CONF_LC_BLOCK_SIZE */
+#define LC_BLOCK_SIZE 64
+#endif /* CONF_LC_BLOCK_SIZE */
+
+/**
+ * @brief Compute the linear combination of several vectors, e.g.
+ *        `result[i] = sum_k coef_table[k] x data_table[k][i]`.
+ * @param[in]  coef_table Coefficients of the finite field (`nb_data` of them)
+ * @param[in]  data_table Vectors of elements (`nb_data` of them), each of 
+ *                        them with at least `size` bytes
+ * @param[in]  nb_data    Number of vectors
+ * @param[in]  size       Number of bytes (not elements) of the result
+ * @param[in]  log2_nb_bit_coef Defines the finite field, e.g.
+ *                        GF(\f$2^{(2^L)}\f$) where `L = log2_nb_bit_coef`
+ * @param[out] result     Output vector (`size` bytes), disjoint from the
+ *                        vectors of `data_table`
+ * @details The result is computed by blocks of LC_BLOCK_SIZE bytes, 
+ *          in one pass over all the vectors for each block.
+ */
+void lc_vector_linear_combination(uint8_t* coef_table, uint8_t** data_table,
+				  uint16_t nb_data, uint16_t size,
+				  uint8_t log2_nb_bit_coef, uint8_t* result);
+
+/**
+ * @brief Multiply a matrix of coefficients by a matrix of vectors, e.g.
+ *        `result_table[r][i] = sum_c coef_matrix[r*nb_col+c] x data_table[c][i]`
+ *        (each result is a linear combination of all the vectors).
+ * @param[in]  coef_matrix  Coefficients, `nb_row` rows of `nb_col` elements
+ *                          (one per byte)
+ * @param[in]  nb_row       Number of rows (of results)
+ * @param[in]  nb_col       Number of columns (of vectors in `data_table`)
+ * @param[in]  data_table   Vectors of elements (`nb_col` of them), each of
+ *                          them with at least `size` bytes
+ * @param[in]  size         Number of bytes (not elements) of each result
+ * @param[in]  log2_nb_bit_coef Defines the finite field, e.g.
+ *                          GF(\f$2^{(2^L)}\f$) where `L = log2_nb_bit_coef`
+ * @param[out] result_table Output vectors (`nb_row` of them, `size` bytes),
+ *                          disjoint from the vectors of `data_table`
+ * @details The product is computed by blocks of LC_BLOCK_SIZE bytes: 
+ *          one block of every vector of `data_table` is used for all the
+ *          rows while it is in cache.
+ */
+void lc_matrix_mul(uint8_t* coef_matrix, uint16_t nb_row, uint16_t nb_col,
+		   uint8_t** data_table, uint16_t size,
+		   uint8_t log2_nb_bit_coef, uint8_t** result_table);
+
 /**
  * @brief Set the n-th element of one vector (sequences, arrays)
  *         to one given element of one finite field.
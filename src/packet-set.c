@@ -43,6 +43,67 @@
 
 /*---------------------------------------------------------------------------*/
 
+#if PACKET_SET_QUEUE_SIZE > 0
+/* phases of the processing of the first queued packet (packet_set_step) */
+#define PACKET_SET_STEP_START     0 /* not started */
+#define PACKET_SET_STEP_REDUCE    1 /* being reduced, from step_coef_pos */
+#define PACKET_SET_STEP_ELIMINATE 2 /* stored, being eliminated from the
+				       other packets, from step_coef_pos */
+#define PACKET_SET_STEP_REPLAY    3 /* being reduced, from step_op of
+				       step_plan */
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+
+#ifdef CONF_WITH_INSTRUMENT
+/* call a callback of the application, and account for its time */
+#define PACKET_SET_CALLBACK(set, call)				\
+  BEGIN_MACRO							\
+  uint64_t callback_start_time = instrument_get_time();		\
+  call;								\
+  (set)->instrument.nb_callback ++;				\
+  (set)->instrument.callback_time += instrument_get_time()	\
+    - callback_start_time;					\
+  END_MACRO
+#else /* CONF_WITH_INSTRUMENT */
+#define PACKET_SET_CALLBACK(set, call) BEGIN_MACRO call; END_MACRO
+#endif /* CONF_WITH_INSTRUMENT */
+
+#ifdef CONF_WITH_INSTRUMENT
+/* record the arrival time of the source indices of `pkt` that were not 
+   seen yet (nor decoded) */
+static void packet_set_mark_seen(packet_set_t* set, coded_packet_t* pkt,
+				 uint64_t time)
+{
+  if (pkt->coef_pos_min == COEF_POS_NONE)
+    return;
+  uint16_t i;
+  for (i=0; i<=pkt->coef_pos_max - pkt->coef_pos_min; i++) {
+    uint16_t coef_pos = pkt->coef_pos_min + i;
+    uint16_t index = coef_pos % MAX_CODED_PACKET;
+    if (set->seen_pos[index] == coef_pos
+	|| bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, coef_pos))
+      continue;
+    /* (an older source index still there is out of the window) */
+    set->seen_pos[index] = coef_pos;
+    set->seen_time[index] = time;
+  }
+}
+
+/* record the decoding delay of the source index of a decoded packet, when
+   it is notified */
+static void packet_set_account_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  uint16_t coef_pos = set->coded_packet[packet_id].coef_pos_min;
+  uint16_t index = coef_pos % MAX_CODED_PACKET;
+  if (set->seen_pos[index] != coef_pos)
+    return;
+  instrument_time_stat_add(&set->instrument.decode_delay,
+			   instrument_get_time() - set->seen_time[index]);
+  set->seen_pos[index] = COEF_POS_NONE;
+}
+#endif /* CONF_WITH_INSTRUMENT */
+
+/*---------------------------------------------------------------------------*/
+
 void packet_set_init(packet_set_t* set, uint8_t log2_nb_bit_coef,
 		     notify_packet_decoded_func_t notify_packet_decoded_func,
 		     notify_set_full_func_t notify_set_full_func,
@@ -65,8 +126,175 @@ void packet_set_init(packet_set_t* set, uint8_t log2_nb_bit_coef,
 
   set->nb_decoded_packet = 0;
   bitmap_init(set->decoded_bitmap, DECODED_BITMAP_SIZE);
+
+#if DECODED_STORE_SIZE > 0
+  for (i=0; i<DECODED_STORE_SIZE; i++)
+    set->decoded_store_pos[i] = COEF_POS_NONE;
+#endif /* DECODED_STORE_SIZE > 0 */
+
+#ifdef CONF_WITH_INSTRUMENT
+  memset(&set->instrument, 0, sizeof(set->instrument));
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    set->seen_pos[i] = COEF_POS_NONE;
+#endif /* CONF_WITH_INSTRUMENT */
+
+#if PACKET_SET_QUEUE_SIZE > 0
+  set->queue_first = 0;
+  set->queue_count = 0;
+  set->step_phase = PACKET_SET_STEP_START;
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  set->payload_program = NULL;
+  set->execute_payload_func = NULL;
+  set->execute_payload_data = NULL;
+  set->nb_deferred_decoded = 0;
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+}
+
+void reduction_stat_accumulate(reduction_stat_t* total, 
+			       reduction_stat_t* stat)
+{
+  total->non_reduction += stat->non_reduction;
+  total->reduction_success += stat->reduction_success;
+  total->reduction_failure += stat->reduction_failure;
+  total->coef_pos_too_low += stat->coef_pos_too_low;
+  total->coef_pos_too_high += stat->coef_pos_too_high;
+  total->elimination += stat->elimination;
+  total->decoded += stat->decoded;
+  total->non_innovative += stat->non_innovative;
+  total->inactivation += stat->inactivation;
+}
+
+#ifdef CONF_WITH_INSTRUMENT
+void packet_set_instrument_accumulate(packet_set_instrument_t* total,
+				      packet_set_instrument_t* instrument)
+{
+  reduction_stat_accumulate(&total->total_stat, &instrument->total_stat);
+  total->nb_add += instrument->nb_add;
+  instrument_time_stat_accumulate(&total->add_time, &instrument->add_time);
+  total->nb_step += instrument->nb_step;
+  total->step_time += instrument->step_time;
+  total->nb_callback += instrument->nb_callback;
+  total->callback_time += instrument->callback_time;
+  instrument_time_stat_accumulate(&total->decode_delay, 
+				  &instrument->decode_delay);
+}
+#endif /* CONF_WITH_INSTRUMENT */
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+
+void packet_set_set_payload_executor(packet_set_t* set, 
+				     payload_program_t* program,
+				     execute_payload_func_t execute_payload_func,
+				     void* execute_payload_data)
+{
+  if (program != NULL)
+    payload_program_init(program, set->log2_nb_bit_coef);
+  set->payload_program = program;
+  set->execute_payload_func = execute_payload_func;
+  set->execute_payload_data = execute_payload_data;
+  set->nb_deferred_decoded = 0;
+}
+
+/* execute the recorded operations on the payloads */
+static void packet_set_execute_payload(packet_set_t* set)
+{
+  payload_program_t* program = set->payload_program;
+  if (program == NULL || program->nb_op == 0)
+    return;
+  if (set->execute_payload_func != NULL)
+    set->execute_payload_func(set->execute_payload_data, program);
+  else payload_program_execute(program, 0, program->max_size);
+  payload_program_init(program, set->log2_nb_bit_coef);
+}
+
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+
+/* complete the deferred operations on the payloads, and notify the packets
+   decoded meanwhile: required before any callback, and before returning */
+static void packet_set_flush(packet_set_t* set)
+{
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (set->payload_program == NULL)
+    return;
+  packet_set_execute_payload(set);
+  /* (the callbacks may free packets, but do not reuse their memory) */
+  uint16_t i;
+  for (i=0; i<set->nb_deferred_decoded; i++) {
+#ifdef CONF_WITH_INSTRUMENT
+    packet_set_account_decoded(set, set->deferred_decoded_id[i]);
+#endif /* CONF_WITH_INSTRUMENT */
+    if (set->notify_packet_decoded_func != NULL)
+      PACKET_SET_CALLBACK(set, set->notify_packet_decoded_func
+			  (set, set->deferred_decoded_id[i]));
+  }
+  set->nb_deferred_decoded = 0;
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
 }
 
+/* p1 += coef2 x p2 */
+static void packet_set_add_mult(packet_set_t* set, coded_packet_t* p1,
+				uint8_t coef2, coded_packet_t* p2)
+{
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (set->payload_program != NULL) {
+    if (payload_program_is_full(set->payload_program))
+      packet_set_execute_payload(set);
+    coded_packet_deferred_add_mult(p1, coef2, p2, set->payload_program);
+    return;
+  }
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  coded_packet_add_mult(p1, coef2, p2);
+}
+
+static void packet_set_to_mul(packet_set_t* set, coded_packet_t* pkt,
+			      uint8_t coef)
+{
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (set->payload_program != NULL) {
+    if (payload_program_is_full(set->payload_program))
+      packet_set_execute_payload(set);
+    coded_packet_deferred_to_mul(pkt, coef, set->payload_program);
+    return;
+  }
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  coded_packet_to_mul(pkt, coef);
+}
+
+static bool packet_set_substitute_decoded(packet_set_t* set,
+					  coded_packet_t* pkt,
+					  coded_packet_t* decoded)
+{
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (set->payload_program != NULL) {
+    if (payload_program_is_full(set->payload_program))
+      packet_set_execute_payload(set);
+    return coded_packet_deferred_substitute_decoded(pkt, decoded,
+						    set->payload_program);
+  }
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  return coded_packet_substitute_decoded(pkt, decoded);
+}
+
+static void packet_set_copy_packet(packet_set_t* set, coded_packet_t* dst,
+				   coded_packet_t* src)
+{
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (set->payload_program != NULL) {
+    if (payload_program_is_full(set->payload_program))
+      packet_set_execute_payload(set);
+    coded_packet_deferred_copy_from(dst, src, set->payload_program);
+    return;
+  }
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  coded_packet_copy_from(dst, src);
+}
+
+/*---------------------------------------------------------------------------*/
+
 /* XXX: duplicate with packet_set_get_id_of_pos ? */
 uint16_t packet_set_get_id_of_coef_pos(packet_set_t* set, uint16_t coef_pos)
 {
@@ -82,78 +310,187 @@ uint16_t packet_set_get_id_of_coef_pos(packet_set_t* set, uint16_t coef_pos)
   return set->pos_to_id[coef_pos % MAX_CODED_PACKET];
 }
 
-static uint16_t packet_set_reduce
-(packet_set_t* set, coded_packet_t* pkt, reduction_stat_t* stat)
+coded_packet_t* packet_set_get_decoded_packet(packet_set_t* set,
+					      uint16_t coef_pos)
+{
+  uint16_t packet_id = packet_set_get_id_of_coef_pos(set, coef_pos);
+  if (packet_id != PACKET_ID_NONE) {
+    coded_packet_t* pkt = &set->coded_packet[packet_id];
+    return coded_packet_was_decoded(pkt) ? pkt : NULL;
+  }
+#if DECODED_STORE_SIZE > 0
+  uint16_t i = coef_pos % DECODED_STORE_SIZE;
+  if (set->decoded_store_pos[i] == coef_pos)
+    return &set->decoded_store[i];
+#endif /* DECODED_STORE_SIZE > 0 */
+  return NULL;
+}
+
+/* returns the packet of the set that has `coef_pos` as pivot, or else the
+   decoded packet of `coef_pos` (from the store, or in `tmp_pkt` from 
+   get_decoded_packet_func), or NULL; when `header_only` is true, decoded
+   packets that are no longer in the set are known to be unit vectors,
+   hence need not be fetched */
+static coded_packet_t* packet_set_get_base_packet
+(packet_set_t* set, uint16_t coef_pos, coded_packet_t* tmp_pkt,
+ bool header_only)
+{
+  uint16_t packet_id = packet_set_get_id_of_coef_pos(set, coef_pos);
+  if (packet_id != PACKET_ID_NONE)
+    return &set->coded_packet[packet_id];
+
+  coded_packet_t* base_pkt = packet_set_get_decoded_packet(set, coef_pos);
+  if (base_pkt != NULL || set->get_decoded_packet_func == NULL 
+      || bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE,
+			coef_pos) == 0)
+    return base_pkt;
+  if (header_only) {
+    coded_packet_init(tmp_pkt, set->log2_nb_bit_coef);
+    coded_packet_set_coef(tmp_pkt, coef_pos, 1);
+    return tmp_pkt;
+  }
+  packet_set_flush(set);
+  bool_t ok = false;
+  PACKET_SET_CALLBACK(set, ok = set->get_decoded_packet_func
+		      (set, coef_pos, tmp_pkt));
+  return ok ? tmp_pkt : NULL;
+}
+
+/* reduce the coefficient `coef_pos` of `pkt` with the packet of the set 
+   that has it as pivot (or with the decoded packet), if any;
+   when `header_only` is true, only the encoding vector of `pkt` is reduced
+   (the coded payload is ignored).
+   Returns true if a row operation was done. */
+static bool packet_set_reduce_coef
+(packet_set_t* set, coded_packet_t* pkt, uint16_t coef_pos,
+ reduction_stat_t* stat, bool header_only)
 {
-  REQUIRE( set->log2_nb_bit_coef == pkt->log2_nb_bit_coef );
   uint8_t l = set->log2_nb_bit_coef;
+  uint8_t coef = coded_packet_get_coef(pkt, coef_pos);
+  if (coef == 0)
+    return false;
+  coded_packet_t tmp_base_pkt;
+  coded_packet_t* base_pkt = packet_set_get_base_packet
+    (set, coef_pos, &tmp_base_pkt, header_only);
+  if (base_pkt == NULL) {
+    stat->non_reduction ++;
+    return false;
+  }
+
+  ASSERT( coded_packet_get_coef(base_pkt, coef_pos) == 1 );
+
+  ASSERT( base_pkt->coef_pos_min != COEF_POS_NONE );
+  ASSERT( base_pkt->coef_pos_max != COEF_POS_NONE );
+  ASSERT( pkt->coef_pos_min != COEF_POS_NONE );
+  ASSERT( pkt->coef_pos_max != COEF_POS_NONE );
+  uint16_t coef_pos_min = MIN(pkt->coef_pos_min, base_pkt->coef_pos_min);
+  uint16_t coef_pos_max = MAX(pkt->coef_pos_max, base_pkt->coef_pos_max);
+  if (coef_pos_max-coef_pos_min >= (1<<coded_packet_log2_window(base_pkt))
+      || (coef_pos_max-coef_pos_min >= MAX_CODED_PACKET)) { /* XXX:check */
+    stat->reduction_failure ++;
+    return false;
+  }
+
+  /* reduce by coded_packet */
+  stat->reduction_success ++;
+  uint8_t factor = lc_neg(coef, l);
+  if (header_only)
+    coded_packet_header_add_mult(pkt, factor, base_pkt);
+  else packet_set_add_mult(set, pkt, factor, base_pkt);
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (base_pkt == &tmp_base_pkt) /* (a local copy) */
+    packet_set_execute_payload(set);
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  return true;
+}
+
+/* returns the pivot of a reduced packet: its highest coefficient that is 
+   not the pivot of a packet of the set */
+static uint16_t packet_set_get_pivot(packet_set_t* set, coded_packet_t* pkt)
+{
+  uint16_t i, coef_pos;
+  for (i = pkt->coef_pos_min; i <= pkt->coef_pos_max; i ++) {
+    coef_pos = pkt->coef_pos_max - i + pkt->coef_pos_min; /* start from high */
+    if (coded_packet_get_coef(pkt, coef_pos) != 0
+	&& packet_set_get_id_of_coef_pos(set, coef_pos) == PACKET_ID_NONE
+	&& !bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, coef_pos))
+      return coef_pos; /* (a decoded packet cannot be a pivot again) */
+  }
+  return COEF_POS_NONE;
+}
+
+/* reduce `pkt` with the packets of the set, see packet_set_reduce_coef;
+   when `plan` is not NULL, the row operations are recorded in it */
+static uint16_t packet_set_reduce_internal
+(packet_set_t* set, coded_packet_t* pkt, reduction_stat_t* stat,
+ bool header_only, reduction_plan_t* plan)
+{
+  REQUIRE( set->log2_nb_bit_coef == pkt->log2_nb_bit_coef );
 
   bool is_empty = !coded_packet_adjust_min_max_coef(pkt);
   if (is_empty)
     return COEF_POS_NONE;
 
   uint16_t coef_pos; 
-  /* note that pkt->coef_pos_min|_max may change during loop */
-  for (coef_pos = pkt->coef_pos_min; coef_pos <= pkt->coef_pos_max;
-       coef_pos ++) {
+  /* note that pkt->coef_pos_min|_max may change during loop.
+     Reduction starts from the highest coefficient: since the stored packets
+     have no coefficient above their pivot, this is also correct when they
+     have not been eliminated yet with each other (packet_set_add_batch) */
+  for (coef_pos = pkt->coef_pos_max; ; coef_pos --) {
 
     if (is_empty) {
       /* note: it is possible that stat->failure_count > 0 and still a empty
 	 packet is obtained (e.g. second arrival of the same packet) */
       return COEF_POS_NONE;
     }
+    if (coef_pos == COEF_POS_NONE || coef_pos < pkt->coef_pos_min)
+      break;
     uint8_t coef = coded_packet_get_coef(pkt, coef_pos);
-    if (coef == 0)
-      continue;
-    uint16_t packet_id = packet_set_get_id_of_coef_pos(set, coef_pos);
-    coded_packet_t* base_pkt = NULL;
-    coded_packet_t tmp_base_pkt;
-
-    if (packet_id != PACKET_ID_NONE) {
-      base_pkt = &set->coded_packet[packet_id];
-    } else {
-      if (set->get_decoded_packet_func != NULL 
-	  && (bitmap_get_bit(set->decoded_bitmap, 
-			     DECODED_BITMAP_SIZE, coef_pos) != 0)) {
-	bool_t ok = set->get_decoded_packet_func(set, coef_pos, &tmp_base_pkt);
-	if (ok)
-	  base_pkt = &tmp_base_pkt;
-      }
-      if (base_pkt == NULL) {
-	stat->non_reduction ++;
-	continue;
+    if (packet_set_reduce_coef(set, pkt, coef_pos, stat, header_only)) {
+      if (plan != NULL) {
+	ASSERT( plan->nb_op < MAX_CODED_PACKET );
+	plan->coef_pos[plan->nb_op] = coef_pos;
+	plan->factor[plan->nb_op] = lc_neg(coef, set->log2_nb_bit_coef);
+	plan->nb_op ++;
       }
+      is_empty = !coded_packet_adjust_min_max_coef(pkt);
     }
+  }
+  return packet_set_get_pivot(set, pkt);
+}
 
-    ASSERT( coded_packet_get_coef(base_pkt, coef_pos) == 1 );
-
-    ASSERT( base_pkt->coef_pos_min != COEF_POS_NONE );
-    ASSERT( base_pkt->coef_pos_max != COEF_POS_NONE );
-    ASSERT( pkt->coef_pos_min != COEF_POS_NONE );
-    ASSERT( pkt->coef_pos_max != COEF_POS_NONE );
-    uint16_t coef_pos_min = MIN(pkt->coef_pos_min, base_pkt->coef_pos_min);
-    uint16_t coef_pos_max = MAX(pkt->coef_pos_max, base_pkt->coef_pos_max);
-    if (coef_pos_max-coef_pos_min >= (1<<coded_packet_log2_window(base_pkt))
-	|| (coef_pos_max-coef_pos_min >= MAX_CODED_PACKET)) { /* XXX:check */
-      stat->reduction_failure ++;
-      continue;
-    }
+static uint16_t packet_set_reduce
+(packet_set_t* set, coded_packet_t* pkt, reduction_stat_t* stat)
+{ return packet_set_reduce_internal(set, pkt, stat, false, NULL); }
 
-    /* reduce by coded_packet */
-    stat->reduction_success ++;
-    uint8_t factor = lc_neg(coef, l);
-    coded_packet_add_mult(pkt, factor, base_pkt);
-    is_empty = !coded_packet_adjust_min_max_coef(pkt);
-  }
+/* replay the row operation `op` of `plan` on `pkt` (with its payload);
+   returns false if the decoded packet it needs could not be fetched */
+static bool packet_set_replay_op(packet_set_t* set, coded_packet_t* pkt,
+				 reduction_plan_t* plan, uint16_t op,
+				 reduction_stat_t* stat)
+{
+  coded_packet_t tmp_base_pkt;
+  coded_packet_t* base_pkt = packet_set_get_base_packet
+    (set, plan->coef_pos[op], &tmp_base_pkt, false);
+  if (base_pkt == NULL)
+    return false;
+  stat->reduction_success ++;
+  packet_set_add_mult(set, pkt, plan->factor[op], base_pkt);
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (base_pkt == &tmp_base_pkt) /* (a local copy) */
+    packet_set_execute_payload(set);
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  return true;
+}
 
-  uint16_t i;
-  for (i = pkt->coef_pos_min; i <= pkt->coef_pos_max; i ++) {
-    coef_pos = pkt->coef_pos_max - i + pkt->coef_pos_min; /* start from high */
-    if (coded_packet_get_coef(pkt, coef_pos) != 0
-	&& packet_set_get_id_of_coef_pos(set, coef_pos) == PACKET_ID_NONE)
-      return coef_pos;
-  }
-  return COEF_POS_NONE;
+bool packet_set_is_innovative(packet_set_t* set, coded_packet_t* pkt)
+{
+  REQUIRE( set->log2_nb_bit_coef == pkt->log2_nb_bit_coef );
+  coded_packet_t header;
+  reduction_stat_t header_stat;
+  coded_packet_copy_header_from(&header, pkt);
+  return packet_set_reduce_internal(set, &header, &header_stat, true, NULL)
+    != COEF_POS_NONE;
 }
 
 static uint16_t packet_set_alloc_packet_id(packet_set_t* set)
@@ -194,6 +531,14 @@ uint8_t packet_set_free_first(packet_set_t* set)
   }
 
   ASSERT (packet_id != PACKET_ID_NONE);
+#if DECODED_STORE_SIZE > 0
+  if (coded_packet_was_decoded(&set->coded_packet[packet_id])) {
+    uint16_t store_index = pos % DECODED_STORE_SIZE;
+    coded_packet_copy_from(&set->decoded_store[store_index], 
+			   &set->coded_packet[packet_id]);
+    set->decoded_store_pos[store_index] = pos;
+  }
+#endif /* DECODED_STORE_SIZE > 0 */
   set->id_to_pos[packet_id] = COEF_POS_NONE;
   set->pos_to_id[pos % MAX_CODED_PACKET] = PACKET_ID_NONE;
 
@@ -243,24 +588,132 @@ uint16_t packet_set_get_id_of_pos(packet_set_t* set, uint16_t coef_pos)
 }
 #endif
 
-uint16_t packet_set_add(packet_set_t* set, coded_packet_t* pkt,
-			reduction_stat_t* stat, 
-			bool_t can_remove)
+void packet_set_free_decoded(packet_set_t* set, uint16_t required_min_coef_pos)
+{
+  while (!packet_set_is_empty(set) && packet_set_free_first(set))
+    if (required_min_coef_pos == COEF_POS_NONE
+	|| (!packet_set_is_empty(set)
+	    && set->coef_pos_min >= required_min_coef_pos))
+      break;
+}
+
+static void packet_set_notify_full(packet_set_t* set,
+				   uint16_t required_min_coef_pos)
+{
+  packet_set_flush(set);
+  if (set->notify_set_full_func != NULL)
+    PACKET_SET_CALLBACK(set, set->notify_set_full_func
+			(set, required_min_coef_pos));
+}
+
+static void packet_set_notify_if_decoded(packet_set_t* set,
+					 uint16_t packet_id,
+					 reduction_stat_t* stat)
+{
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  if (coded_packet_was_decoded(pkt)) {
+    bitmap_set_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, 
+		   pkt->coef_pos_min);
+    stat->decoded ++;
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+    if (set->payload_program != NULL) {
+      if (set->nb_deferred_decoded == MAX_CODED_PACKET)
+	packet_set_flush(set);
+      set->deferred_decoded_id[set->nb_deferred_decoded++] = packet_id;
+      return;
+    }
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+#ifdef CONF_WITH_INSTRUMENT
+    packet_set_account_decoded(set, packet_id);
+#endif /* CONF_WITH_INSTRUMENT */
+    if (set->notify_packet_decoded_func != NULL)
+      PACKET_SET_CALLBACK(set, set->notify_packet_decoded_func
+			  (set, packet_id));
+  }
+}
+
+static uint16_t packet_set_store(packet_set_t* set, coded_packet_t* pkt,
+				 uint16_t coef_pos, reduction_stat_t* stat);
+
+/* checks done before any operation on the payload of `pkt`: returns false
+   if it is not innovative; otherwise the row operations that reduce it are
+   in `plan` (none when it can be stored as it is), and `plan->pivot` is
+   the pivot of the reduced packet */
+static bool packet_set_precheck(packet_set_t* set, coded_packet_t* pkt,
+				reduction_stat_t* stat, reduction_plan_t* plan)
 {
-  (void)can_remove;
   ASSERT (pkt->coef_pos_max - pkt->coef_pos_min < MAX_CODED_PACKET);
+  REQUIRE( set->log2_nb_bit_coef == pkt->log2_nb_bit_coef );
+  plan->nb_op = 0;
+
+  /* systematic fast path: an uncoded source packet needs no reduction
+     unless a (non-decoded) packet of the set already has it as pivot */
+  plan->pivot = pkt->coef_pos_min;
+  if (plan->pivot != COEF_POS_NONE && plan->pivot == pkt->coef_pos_max) {
+    if (bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE,
+		       plan->pivot)) {
+      stat->non_innovative ++;
+      return false;
+    }
+    if (packet_set_get_id_of_coef_pos(set, plan->pivot) == PACKET_ID_NONE)
+      return true;
+  }
 
-  uint8_t l = set->log2_nb_bit_coef;
-  REQUIRE( l == pkt->log2_nb_bit_coef );
-  reduction_stat_t local_stat;
-  if (stat == NULL)
-    stat = &local_stat;
-  reduction_stat_init(stat);
+  /* reduce the encoding vector alone, to reject packets that would be 
+     reduced to nothing before any operation on their payload, and to 
+     record the row operations */
+  coded_packet_t header;
+  reduction_stat_t header_stat;
+  reduction_stat_init(&header_stat);
+  coded_packet_copy_header_from(&header, pkt);
+  plan->pivot = packet_set_reduce_internal(set, &header, &header_stat, true,
+					   plan);
+  if (plan->pivot == COEF_POS_NONE) {
+    stat->non_innovative ++;
+    return false;
+  }
+  /* the row operations are counted as they are replayed on the payload */
+  header_stat.reduction_success = 0;
+  reduction_stat_accumulate(stat, &header_stat);
+  return true;
+}
+
+/* reduce `pkt` with the row operations of `plan`, returns its pivot;
+   if a decoded packet cannot be fetched (from get_decoded_packet_func), 
+   the reduction goes on with packet_set_reduce */
+static uint16_t packet_set_reduce_with_plan(packet_set_t* set,
+					    coded_packet_t* pkt,
+					    reduction_plan_t* plan,
+					    reduction_stat_t* stat)
+{
+  uint16_t op;
+  for (op=0; op<plan->nb_op; op++)
+    if (!packet_set_replay_op(set, pkt, plan, op, stat))
+      return packet_set_reduce(set, pkt, stat);
+  if (!coded_packet_adjust_min_max_coef(pkt))
+    return COEF_POS_NONE;
+  return plan->pivot;
+}
 
-  /* reduce the packet */
-  uint16_t coef_pos = packet_set_reduce(set, pkt, stat);
+/* reduce `pkt`, store it in the set with a coefficient `1` for its pivot and
+   notify if it is decoded; it is not eliminated from the other packets */
+static uint16_t packet_set_insert(packet_set_t* set, coded_packet_t* pkt,
+				  reduction_stat_t* stat)
+{
+  reduction_plan_t plan;
+  if (!packet_set_precheck(set, pkt, stat, &plan))
+    return PACKET_ID_NONE;
+  uint16_t coef_pos = packet_set_reduce_with_plan(set, pkt, &plan, stat);
   if (coef_pos == COEF_POS_NONE)
     return PACKET_ID_NONE;
+  return packet_set_store(set, pkt, coef_pos, stat);
+}
+
+/* store the reduced packet `pkt` with pivot `coef_pos` in the set */
+static uint16_t packet_set_store(packet_set_t* set, coded_packet_t* pkt,
+				 uint16_t coef_pos, reduction_stat_t* stat)
+{
+  uint8_t l = set->log2_nb_bit_coef;
 
   /*check if it can be inserted as new reference for base packet at coef_pos */
   if (packet_set_is_empty(set)) {
@@ -294,8 +747,7 @@ uint16_t packet_set_add(packet_set_t* set, coded_packet_t* pkt,
   if (pkt->coef_pos_max > set->coef_pos_max) {
     if (pkt->coef_pos_max - set->coef_pos_min >= MAX_CODED_PACKET) {
       /* attempt to call to make room */
-      if (set->notify_set_full_func != NULL)
-        set->notify_set_full_func(set, pkt->coef_pos_max - MAX_CODED_PACKET-1);
+      packet_set_notify_full(set, pkt->coef_pos_max - MAX_CODED_PACKET + 1);
 
       /*check if, *now*, it can be inserted as new reference */
       if (packet_set_is_empty(set)) { /* XXX:clean-up */
@@ -322,8 +774,8 @@ uint16_t packet_set_add(packet_set_t* set, coded_packet_t* pkt,
 
   /* get a packet_id */
   uint16_t packet_id = packet_set_alloc_packet_id(set);
-  if (packet_id == PACKET_ID_NONE && set->notify_set_full_func != NULL) {
-    set->notify_set_full_func(set, COEF_POS_NONE);
+  if (packet_id == PACKET_ID_NONE) {
+    packet_set_notify_full(set, COEF_POS_NONE);
     packet_id = packet_set_alloc_packet_id(set);
   }
 
@@ -338,51 +790,434 @@ uint16_t packet_set_add(packet_set_t* set, coded_packet_t* pkt,
   ASSERT( set->id_to_pos[packet_id] == COEF_POS_NONE );
 
   coded_packet_t* stored_pkt = &set->coded_packet[packet_id];
-  coded_packet_copy_from(stored_pkt, pkt);
+  packet_set_copy_packet(set, stored_pkt, pkt);
   set->pos_to_id[coef_pos % MAX_CODED_PACKET] = packet_id;
   set->id_to_pos[packet_id] = coef_pos;
   
   uint8_t coef = coded_packet_get_coef(stored_pkt, coef_pos);
   ASSERT( coef != 0 );
-  coded_packet_to_mul(stored_pkt, lc_inv(coef, l) );
+  if (coef != 1)
+    packet_set_to_mul(set, stored_pkt, lc_inv(coef, l));
+
+  packet_set_notify_if_decoded(set, packet_id, stat);
+  return packet_id;
+}
+
+/* eliminate the pivot `coef_pos` of the packet `stored_pkt` from the
+   (non-decoded) packet of the set that has the pivot `i`, if any.
+   Returns true if a row operation was done. */
+static bool packet_set_eliminate_at(packet_set_t* set, 
+				    coded_packet_t* stored_pkt,
+				    uint16_t coef_pos, uint16_t i,
+				    reduction_stat_t* stat)
+{
+  uint8_t l = set->log2_nb_bit_coef;
+  if (i == coef_pos || set->pos_to_id[i%MAX_CODED_PACKET] == PACKET_ID_NONE)
+    return false;
+  uint16_t other_packet_id = set->pos_to_id[i%MAX_CODED_PACKET];
+  ASSERT( other_packet_id < MAX_CODED_PACKET );
+  coded_packet_t* other_pkt = &set->coded_packet[other_packet_id];
+  if (coded_packet_was_decoded(other_pkt))
+    return false;
 
   if (coded_packet_was_decoded(stored_pkt)) {
-    bitmap_set_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, 
-		   stored_pkt->coef_pos_min);
-    stat->decoded ++;
-    if (set->notify_packet_decoded_func != NULL)
-      set->notify_packet_decoded_func(set, packet_id);
+    /* substitute the decoded packet: since its header is a unit vector,
+       only the payload is combined and one coefficient is cleared */
+    ASSERT( coef_pos == stored_pkt->coef_pos_min );
+    if (!packet_set_substitute_decoded(set, other_pkt, stored_pkt))
+      return false;
+  } else {
+    uint8_t other_coef = coded_packet_get_coef(other_pkt, coef_pos);
+    if (other_coef == 0)
+      return false;
+    uint8_t factor  = lc_neg(other_coef, l);
+    packet_set_add_mult(set, other_pkt, factor, stored_pkt);
+    coded_packet_adjust_min_max_coef(other_pkt);
   }
+  stat->elimination++;
+  /* XXX: check this cannot occur */
+  ASSERT( !coded_packet_was_empty(other_pkt) );
+  packet_set_notify_if_decoded(set, other_packet_id, stat);
+  return true;
+}
+
+/* eliminate the pivot of the packet `packet_id` from all the other
+   (non-decoded) packets of the set */
+static void packet_set_eliminate(packet_set_t* set, uint16_t packet_id,
+				 reduction_stat_t* stat)
+{
+  uint16_t coef_pos = set->id_to_pos[packet_id];
+  coded_packet_t* stored_pkt = &set->coded_packet[packet_id];
+  ASSERT( coef_pos != COEF_POS_NONE );
 
-  /* eliminate */
   uint16_t i;
   for (i=set->coef_pos_min; i<=set->coef_pos_max; i++)
-    if (i != coef_pos && set->pos_to_id[i%MAX_CODED_PACKET] != PACKET_ID_NONE) {
-      uint16_t other_packet_id = set->pos_to_id[i%MAX_CODED_PACKET];
-      ASSERT( other_packet_id < MAX_CODED_PACKET );
-      coded_packet_t* other_pkt = &set->coded_packet[other_packet_id];
-      if (coded_packet_was_decoded(other_pkt))
-	continue;
-      uint8_t other_coef = coded_packet_get_coef(other_pkt, coef_pos);
-      if (other_coef == 0)
+    packet_set_eliminate_at(set, stored_pkt, coef_pos, i, stat);
+}
+
+/* eliminate the pivots of the `nb_pending` packets `pending_id` (inserted,
+   but not eliminated yet) from all the other packets of the set, in one
+   pass over the packets of the set by increasing pivot. A packet has no
+   coefficient above its pivot: it is only reduced with lower pending
+   pivots, whose packets were already visited, hence fully reduced. */
+static void packet_set_eliminate_pending(packet_set_t* set,
+					 uint16_t* pending_id,
+					 uint16_t* pending_pos,
+					 reduction_stat_t** pending_stat,
+					 uint16_t nb_pending)
+{
+  uint16_t i, j;
+  for (i=set->coef_pos_min; i<=set->coef_pos_max; i++)
+    for (j=0; j<nb_pending; j++) {
+      /* packets might have been freed from the callbacks */
+      if (packet_set_is_empty(set) || i > set->coef_pos_max)
+	return;
+      if (pending_pos[j] >= i
+	  || set->id_to_pos[pending_id[j]] != pending_pos[j])
 	continue;
-      stat->elimination++;
-      uint8_t factor  = lc_neg(other_coef, l);
-      coded_packet_add_mult(other_pkt, factor, stored_pkt);
-      coded_packet_adjust_min_max_coef(other_pkt);
-      if (coded_packet_was_decoded(other_pkt)) {
-	bitmap_set_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, 
-		       other_pkt->coef_pos_min);
-	stat->decoded ++;
-	if (set->notify_packet_decoded_func != NULL)
-	  set->notify_packet_decoded_func(set, other_packet_id);
-      }
-      /* XXX: check this cannot occur */
-      ASSERT( !coded_packet_was_empty(other_pkt) );
+      packet_set_eliminate_at(set, &set->coded_packet[pending_id[j]],
+			      pending_pos[j], i, pending_stat[j]);
     }
+}
+
+#ifdef CONF_WITH_INSTRUMENT
+static void packet_set_account_add(packet_set_t* set, uint16_t nb_pkt,
+				   uint64_t time)
+{
+  packet_set_instrument_t* instrument = &set->instrument;
+  instrument->nb_add += nb_pkt;
+  instrument_time_stat_add(&instrument->add_time, time);
+}
+#endif /* CONF_WITH_INSTRUMENT */
+
+uint16_t packet_set_add(packet_set_t* set, coded_packet_t* pkt,
+			reduction_stat_t* stat, 
+			bool_t can_remove)
+{
+  (void)can_remove;
+  reduction_stat_t local_stat;
+#if PACKET_SET_QUEUE_SIZE > 0
+  if (set->queue_count > 0)
+    packet_set_step(set, UINT32_MAX, NULL);
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+  if (stat == NULL)
+    stat = &local_stat;
+  reduction_stat_init(stat);
+#ifdef CONF_WITH_INSTRUMENT
+  uint64_t start_time = instrument_get_time();
+  packet_set_mark_seen(set, pkt, start_time);
+#endif /* CONF_WITH_INSTRUMENT */
+
+  uint16_t packet_id = packet_set_insert(set, pkt, stat);
+  if (packet_id != PACKET_ID_NONE)
+    packet_set_eliminate(set, packet_id, stat);
+  packet_set_flush(set);
+
+#ifdef CONF_WITH_INSTRUMENT
+  reduction_stat_accumulate(&set->instrument.total_stat, stat);
+  packet_set_account_add(set, 1, instrument_get_time() - start_time);
+#endif /* CONF_WITH_INSTRUMENT */
   return packet_id;
 }
 
+uint16_t packet_set_add_batch(packet_set_t* set, coded_packet_t* pkt_table,
+			      uint16_t nb_pkt, reduction_stat_t* stat_table)
+{
+  /* packets inserted, but not eliminated yet from the other ones */
+  uint16_t pending_id[MAX_CODED_PACKET];
+  uint16_t pending_pos[MAX_CODED_PACKET];
+  reduction_stat_t* pending_stat[MAX_CODED_PACKET];
+  uint16_t nb_pending = 0;
+  reduction_stat_t local_stat;
+  uint16_t nb_added = 0;
+  uint16_t i;
+
+#if PACKET_SET_QUEUE_SIZE > 0
+  if (set->queue_count > 0)
+    packet_set_step(set, UINT32_MAX, NULL);
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+#ifdef CONF_WITH_INSTRUMENT
+  uint64_t start_time = instrument_get_time();
+  for (i=0; i<nb_pkt; i++)
+    packet_set_mark_seen(set, &pkt_table[i], start_time);
+#endif /* CONF_WITH_INSTRUMENT */
+
+  for (i=0; i<nb_pkt; i++) {
+    reduction_stat_t* stat = (stat_table != NULL) ? &stat_table[i] 
+      : &local_stat;
+#ifdef CONF_WITH_INSTRUMENT
+    if (stat_table == NULL && i > 0) /* (before it is reused) */
+      reduction_stat_accumulate(&set->instrument.total_stat, &local_stat);
+#endif /* CONF_WITH_INSTRUMENT */
+    reduction_stat_init(stat);
+    uint16_t packet_id = packet_set_insert(set, &pkt_table[i], stat);
+    if (packet_id == PACKET_ID_NONE)
+      continue;
+    nb_added ++;
+
+    /* a decoded packet might be freed from the callbacks, hence it is
+       eliminated immediately */
+    if (coded_packet_was_decoded(&set->coded_packet[packet_id])) {
+      packet_set_eliminate(set, packet_id, stat);
+      continue;
+    }
+
+    if (nb_pending == MAX_CODED_PACKET) {
+      /* only possible when packets were freed: flush */
+      packet_set_eliminate_pending(set, pending_id, pending_pos,
+				   pending_stat, nb_pending);
+      nb_pending = 0;
+    }
+    pending_id[nb_pending] = packet_id;
+    pending_pos[nb_pending] = set->id_to_pos[packet_id];
+    pending_stat[nb_pending] = stat;
+    nb_pending ++;
+  }
+
+  /* one sweep for all packets of the batch: the reduced form is the same
+     as with successive calls to packet_set_add */
+  packet_set_eliminate_pending(set, pending_id, pending_pos, pending_stat,
+			       nb_pending);
+
+  packet_set_flush(set);
+
+#ifdef CONF_WITH_INSTRUMENT
+  if (stat_table == NULL) {
+    if (nb_pkt > 0)
+      reduction_stat_accumulate(&set->instrument.total_stat, &local_stat);
+  } else for (i=0; i<nb_pkt; i++)
+    reduction_stat_accumulate(&set->instrument.total_stat, &stat_table[i]);
+  packet_set_account_add(set, nb_pkt, instrument_get_time() - start_time);
+#endif /* CONF_WITH_INSTRUMENT */
+  return nb_added;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if PACKET_SET_QUEUE_SIZE > 0
+
+bool packet_set_enqueue(packet_set_t* set, coded_packet_t* pkt)
+{
+  REQUIRE( set->log2_nb_bit_coef == pkt->log2_nb_bit_coef );
+  if (set->queue_count == PACKET_SET_QUEUE_SIZE)
+    return false;
+  uint16_t index = (set->queue_first + set->queue_count) 
+    % PACKET_SET_QUEUE_SIZE;
+  coded_packet_copy_from(&set->queue[index], pkt);
+  set->queue_count ++;
+#ifdef CONF_WITH_INSTRUMENT
+  set->instrument.nb_add ++;
+  packet_set_mark_seen(set, pkt, instrument_get_time());
+#endif /* CONF_WITH_INSTRUMENT */
+  return true;
+}
+
+/* store the first queued packet, and start its elimination; returns false
+   if it could not be stored */
+static bool packet_set_step_store(packet_set_t* set, coded_packet_t* pkt,
+				  uint16_t coef_pos, reduction_stat_t* stat)
+{
+  uint16_t packet_id = packet_set_store(set, pkt, coef_pos, stat);
+  if (packet_id == PACKET_ID_NONE)
+    return false;
+  set->step_phase = PACKET_SET_STEP_ELIMINATE;
+  set->step_packet_id = packet_id;
+  set->step_packet_pos = coef_pos;
+  set->step_coef_pos = set->coef_pos_min;
+  return true;
+}
+
+/* the first queued packet goes through the same operations as in 
+   packet_set_add, one row operation (at most) per iteration */
+uint32_t packet_set_step(packet_set_t* set, uint32_t budget,
+			 reduction_stat_t* stat)
+{
+  reduction_stat_t local_stat;
+  if (stat == NULL)
+    stat = &local_stat;
+  reduction_stat_init(stat);
+  uint32_t nb_op = 0;
+#ifdef CONF_WITH_INSTRUMENT
+  uint64_t start_time = instrument_get_time();
+#endif /* CONF_WITH_INSTRUMENT */
+
+  while (nb_op < budget && set->queue_count > 0) {
+    coded_packet_t* pkt = &set->queue[set->queue_first];
+    coded_packet_t* stored_pkt;
+    uint16_t coef_pos;
+    bool is_done = false;
+
+    switch (set->step_phase) {
+    case PACKET_SET_STEP_START:
+      if (!packet_set_precheck(set, pkt, stat, &set->step_plan))
+	is_done = true;
+      else {
+	set->step_phase = PACKET_SET_STEP_REPLAY;
+	set->step_op = 0;
+      }
+      break;
+
+    case PACKET_SET_STEP_REPLAY: /* as packet_set_reduce_with_plan */
+      if (set->step_op < set->step_plan.nb_op) {
+	if (packet_set_replay_op(set, pkt, &set->step_plan, set->step_op,
+				 stat)) {
+	  nb_op ++;
+	  set->step_op ++;
+	} else {
+	  set->step_phase = PACKET_SET_STEP_REDUCE;
+	  set->step_coef_pos = pkt->coef_pos_max;
+	}
+      } else if (!coded_packet_adjust_min_max_coef(pkt))
+	is_done = true;
+      else {
+	nb_op ++;
+	is_done = !packet_set_step_store(set, pkt, set->step_plan.pivot,
+					 stat);
+      }
+      break;
+
+    case PACKET_SET_STEP_REDUCE: /* as packet_set_reduce_internal */
+      coef_pos = set->step_coef_pos;
+      if (!coded_packet_adjust_min_max_coef(pkt))
+	is_done = true;
+      else if (coef_pos == COEF_POS_NONE || coef_pos < pkt->coef_pos_min) {
+	coef_pos = packet_set_get_pivot(set, pkt);
+	if (coef_pos == COEF_POS_NONE)
+	  is_done = true;
+	else {
+	  nb_op ++;
+	  is_done = !packet_set_step_store(set, pkt, coef_pos, stat);
+	}
+      } else {
+	if (packet_set_reduce_coef(set, pkt, coef_pos, stat, false))
+	  nb_op ++;
+	set->step_coef_pos --;
+      }
+      break;
+
+    case PACKET_SET_STEP_ELIMINATE: /* as packet_set_eliminate */
+      /* if the packet was decoded, it might have been freed by a callback
+	 or between two steps: it is then found in the store */
+      coef_pos = set->step_packet_pos;
+      if (set->id_to_pos[set->step_packet_id] == coef_pos)
+	stored_pkt = &set->coded_packet[set->step_packet_id];
+      else stored_pkt = packet_set_get_decoded_packet(set, coef_pos);
+      if (stored_pkt == NULL || packet_set_is_empty(set)
+	  || set->step_coef_pos > set->coef_pos_max) {
+	is_done = true;
+	break;
+      }
+      if (set->step_coef_pos < set->coef_pos_min)
+	set->step_coef_pos = set->coef_pos_min;
+      if (packet_set_eliminate_at(set, stored_pkt, coef_pos, 
+				  set->step_coef_pos, stat))
+	nb_op ++;
+      set->step_coef_pos ++;
+      break;
+
+    default:
+      FATAL("invalid step phase");
+    }
+
+    if (is_done) {
+      set->queue_first = (set->queue_first + 1) % PACKET_SET_QUEUE_SIZE;
+      set->queue_count --;
+      set->step_phase = PACKET_SET_STEP_START;
+    }
+  }
+  packet_set_flush(set);
+#ifdef CONF_WITH_INSTRUMENT
+  reduction_stat_accumulate(&set->instrument.total_stat, stat);
+  set->instrument.nb_step ++;
+  set->instrument.step_time += instrument_get_time() - start_time;
+#endif /* CONF_WITH_INSTRUMENT */
+  return nb_op;
+}
+
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+
+/*---------------------------------------------------------------------------*/
+
+bool packet_set_recode(packet_set_t* set, coef_generator_t* generator,
+		       coded_packet_t* pkt, uint16_t window_hint)
+{
+  uint8_t l = set->log2_nb_bit_coef;
+  uint8_t* data_table[MAX_CODED_PACKET];
+  uint16_t data_size_table[MAX_CODED_PACKET];
+  uint8_t coef_table[MAX_CODED_PACKET];
+  uint16_t nb_pkt = 0;
+  uint16_t i;
+
+  if (packet_set_is_empty(set))
+    return false;
+  uint16_t window = MIN(1<<log2_window_size(l), MAX_CODED_PACKET);
+  if (window_hint > 0 && window_hint < window)
+    window = window_hint;
+  uint16_t coef_pos_low = (set->coef_pos_max >= window - 1) ?
+    set->coef_pos_max - (window - 1) : 0;
+
+  coded_packet_init(pkt, l);
+  uint16_t min_data_size = CODED_PACKET_SIZE;
+  uint16_t max_data_size = 0;
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    if (set->id_to_pos[i] != COEF_POS_NONE
+	&& set->coded_packet[i].coef_pos_min >= coef_pos_low) {
+      coded_packet_t* stored_pkt = &set->coded_packet[i];
+      data_table[nb_pkt] = stored_pkt->content.u8;
+      data_size_table[nb_pkt] = stored_pkt->data_size;
+      min_data_size = MIN(min_data_size, stored_pkt->data_size);
+      max_data_size = MAX(max_data_size, stored_pkt->data_size);
+      pkt->coef_pos_min = min_except(pkt->coef_pos_min, 
+				     stored_pkt->coef_pos_min, COEF_POS_NONE);
+      pkt->coef_pos_max = max_except(pkt->coef_pos_max, 
+				     stored_pkt->coef_pos_max, COEF_POS_NONE);
+      nb_pkt ++;
+    }
+  if (nb_pkt > 0) {
+    /* the stored packets are linearly independent: any non-zero
+       coefficients give a non-empty combination */
+    coef_generator_fill(generator, l, coef_table, nb_pkt,
+			COEF_GENERATOR_LEADING_NONZERO);
+    /* encoding vectors and common part of the payloads in one pass, 
+       then the remaining part of the longer payloads (if any) */
+    lc_vector_linear_combination(coef_table, data_table, nb_pkt,
+				 COEF_HEADER_SIZE + min_data_size, l,
+				 pkt->content.u8);
+    if (max_data_size > min_data_size) {
+      uint16_t offset = COEF_HEADER_SIZE + min_data_size;
+      memset(pkt->content.u8 + offset, 0, max_data_size - min_data_size);
+      for (i=0; i<nb_pkt; i++)
+	if (data_size_table[i] > min_data_size)
+	  lc_vector_mul_add(coef_table[i], data_table[i] + offset,
+			    data_size_table[i] - min_data_size, l,
+			    pkt->content.u8 + offset);
+    }
+    pkt->data_size = max_data_size;
+    coded_packet_adjust_min_max_coef(pkt);
+  }
+
+  /* the decoded packets freed from the set (they are below its lowest
+     source index) that are still in the window are combined too, 
+     since receivers may have missed them */
+  uint16_t coef_pos;
+  for (coef_pos = coef_pos_low; coef_pos < set->coef_pos_min; coef_pos ++) {
+    if (!bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, coef_pos))
+      continue;
+    coded_packet_t tmp_pkt;
+    coded_packet_t* decoded_pkt = packet_set_get_base_packet
+      (set, coef_pos, &tmp_pkt, false);
+    if (decoded_pkt == NULL)
+      continue; /* neither in the store nor from get_decoded_packet_func */
+    coef_generator_fill(generator, l, coef_table, 1, COEF_GENERATOR_NONZERO);
+    coded_packet_add_mult(pkt, coef_table[0], decoded_pkt);
+    nb_pkt ++;
+  }
+
+  /* no packet within the window: `window_hint` is smaller than the span
+     of every packet of the set */
+  return nb_pkt > 0;
+}
+
 static uint16_t packet_set_get_highest_decoded(packet_set_t* set)
 {
   uint16_t i;
@@ -439,6 +1274,107 @@ uint16_t packet_set_get_low_index(packet_set_t* set)
   return result;
 }
 
+void packet_set_get_receiver_state(packet_set_t* set, uint16_t coef_pos_base,
+				   receiver_state_t* state)
+{
+  uint16_t i;
+  state->coef_pos_base = coef_pos_base;
+  state->rank = packet_set_count(set, false);
+  bitmap_init(state->decoded_bitmap, RECEIVER_STATE_BITMAP_SIZE);
+  bitmap_init(state->seen_bitmap, RECEIVER_STATE_BITMAP_SIZE);
+
+  for (i=0; i<RECEIVER_STATE_SIZE; i++) {
+    uint32_t coef_pos = (uint32_t)coef_pos_base + i;
+    if (coef_pos >= MAX_COEF_POS)
+      break;
+    if (bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, coef_pos)) {
+      bitmap_set_bit(state->decoded_bitmap, RECEIVER_STATE_BITMAP_SIZE, i);
+      bitmap_set_bit(state->seen_bitmap, RECEIVER_STATE_BITMAP_SIZE, i);
+    } else if (packet_set_get_id_of_coef_pos(set, coef_pos) != PACKET_ID_NONE)
+      bitmap_set_bit(state->seen_bitmap, RECEIVER_STATE_BITMAP_SIZE, i);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+#define SPAN_UNSEEN  0
+#define SPAN_SEEN    1
+#define SPAN_DECODED 2
+#define SPAN_KIND_SHIFT 6
+#define SPAN_MAX_LENGTH (1<<SPAN_KIND_SHIFT)
+
+static uint8_t receiver_state_get_span_kind(receiver_state_t* state,
+					    uint16_t coef_pos)
+{
+  if (receiver_state_is_decoded(state, coef_pos))
+    return SPAN_DECODED;
+  else if (receiver_state_is_seen(state, coef_pos))
+    return SPAN_SEEN;
+  else return SPAN_UNSEEN;
+}
+
+uint16_t receiver_state_serialize(receiver_state_t* state, uint8_t* buffer,
+				  uint16_t buffer_size)
+{
+  uint32_t end = (uint32_t)state->coef_pos_base + RECEIVER_STATE_SIZE;
+  uint32_t low = state->coef_pos_base;
+  uint32_t last = low; /* end of the last span that is not unseen */
+  uint32_t coef_pos;
+
+  while (low < end && receiver_state_is_decoded(state, low))
+    low ++;
+  for (coef_pos = low; coef_pos < end; coef_pos++)
+    if (receiver_state_is_seen(state, coef_pos))
+      last = coef_pos+1;
+  if (buffer_size < 3 || low > 0xffffu)
+    return 0;
+  buffer[0] = low >> 8;
+  buffer[1] = low & 0xff;
+  buffer[2] = MIN(state->rank, 0xffu);
+
+  uint16_t size = 3;
+  coef_pos = low;
+  while (coef_pos < last) {
+    uint8_t kind = receiver_state_get_span_kind(state, coef_pos);
+    uint16_t length = 1;
+    while (coef_pos + length < last && length < SPAN_MAX_LENGTH
+	   && receiver_state_get_span_kind(state, coef_pos + length) == kind)
+      length ++;
+    if (size >= buffer_size)
+      return 0;
+    buffer[size++] = (kind << SPAN_KIND_SHIFT) | (length-1);
+    coef_pos += length;
+  }
+  return size;
+}
+
+bool receiver_state_parse(receiver_state_t* state, uint8_t* buffer,
+			  uint16_t buffer_size)
+{
+  uint16_t i, j, offset = 0;
+  if (buffer_size < 3)
+    return false;
+  state->coef_pos_base = (buffer[0] << 8) | buffer[1];
+  state->rank = buffer[2];
+  bitmap_init(state->decoded_bitmap, RECEIVER_STATE_BITMAP_SIZE);
+  bitmap_init(state->seen_bitmap, RECEIVER_STATE_BITMAP_SIZE);
+
+  for (i=3; i<buffer_size; i++) {
+    uint8_t kind = buffer[i] >> SPAN_KIND_SHIFT;
+    uint16_t length = (buffer[i] & (SPAN_MAX_LENGTH-1)) + 1;
+    if (kind > SPAN_DECODED || offset + length > RECEIVER_STATE_SIZE)
+      return false;
+    for (j=offset; j<offset+length; j++) {
+      if (kind == SPAN_DECODED)
+	bitmap_set_bit(state->decoded_bitmap, RECEIVER_STATE_BITMAP_SIZE, j);
+      if (kind != SPAN_UNSEEN)
+	bitmap_set_bit(state->seen_bitmap, RECEIVER_STATE_BITMAP_SIZE, j);
+    }
+    offset += length;
+  }
+  return true;
+}
+
 /*---------------------------------------------------------------------------*/
 
 #ifdef CONF_WITH_FPRINTF
@@ -571,6 +1507,43 @@ void reduction_stat_pywrite(FILE* out, reduction_stat_t* stat)
   fprintf(out, ", 'coefTooHigh':%u", stat->coef_pos_too_high );
   fprintf(out, ", 'elim':%u", stat->elimination );
   fprintf(out, ", 'decoded':%u", stat->decoded );
+  fprintf(out, ", 'nonInnov':%u", stat->non_innovative );
+  fprintf(out, ", 'inactiv':%u", stat->inactivation );
+  fprintf(out, " }");
+}
+
+#ifdef CONF_WITH_INSTRUMENT
+void packet_set_instrument_pywrite(FILE* out, 
+				   packet_set_instrument_t* instrument)
+{
+  fprintf(out, "{ 'type':'packet-set-instrument'");
+  fprintf(out, ", 'timeUnit':'%s'", INSTRUMENT_TIME_UNIT);
+  fprintf(out, ", 'nbAdd':%u", instrument->nb_add);
+  fprintf(out, ", 'addTime':");
+  instrument_time_stat_pywrite(out, &instrument->add_time);
+  fprintf(out, ", 'nbStep':%u", instrument->nb_step);
+  fprintf(out, ", 'stepTime':%llu", 
+	  (unsigned long long)instrument->step_time);
+  fprintf(out, ", 'nbCallback':%u", instrument->nb_callback);
+  fprintf(out, ", 'callbackTime':%llu", 
+	  (unsigned long long)instrument->callback_time);
+  fprintf(out, ", 'decodeDelay':");
+  instrument_time_stat_pywrite(out, &instrument->decode_delay);
+  fprintf(out, ", 'totalStat':");
+  reduction_stat_pywrite(out, &instrument->total_stat);
+  fprintf(out, " }");
+}
+#endif /* CONF_WITH_INSTRUMENT */
+
+void receiver_state_pywrite(FILE* out, receiver_state_t* state)
+{
+  fprintf(out, "{ 'type':'receiver-state'");
+  fprintf(out, ", 'coefPosBase':%u", state->coef_pos_base);
+  fprintf(out, ", 'rank':%u", state->rank);
+  fprintf(out, ", 'decoded':");
+  bitmap_pywrite(out, state->decoded_bitmap, RECEIVER_STATE_BITMAP_SIZE);
+  fprintf(out, ", 'seen':");
+  bitmap_pywrite(out, state->seen_bitmap, RECEIVER_STATE_BITMAP_SIZE);
   fprintf(out, " }");
 }
 
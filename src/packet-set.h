@@ -45,6 +45,8 @@ extern "C" {
 
 #include "bitmap.h"
 #include "coded-packet.h"
+#include "coef-generator.h"
+#include "instrument.h"
 
 /*---------------------------------------------------------------------------*/
 
@@ -60,11 +62,36 @@ typedef struct {
   unsigned int coef_pos_too_high; /**< */
   unsigned int elimination;       /**< */
   unsigned int decoded;           /**< */
+  unsigned int non_innovative;    /**< rejected as not innovative: already decoded source packet, or encoding vector reduced to nothing */
+  unsigned int inactivation;      /**< sources inactivated when peeling stalled (peeling_set_t) */
 } reduction_stat_t;
 
 static inline void reduction_stat_init(reduction_stat_t* stat)
 { memset(stat, 0, sizeof(reduction_stat_t)); }
 
+/**
+ * @brief Adds the counters of `stat` to the ones of `total`.
+ */
+void reduction_stat_accumulate(reduction_stat_t* total, 
+			       reduction_stat_t* stat);
+
+#ifdef CONF_WITH_INSTRUMENT
+/**
+ * @brief packet_set_instrument_t holds cumulative counters of one packet
+ *        set (never reset by the set), with times in INSTRUMENT_TIME_UNIT.
+ */
+typedef struct {
+  reduction_stat_t total_stat; /**< sum of the reduction_stat_t of every packet */
+  uint32_t nb_add;       /**< packets given to packet_set_add, packet_set_add_batch or packet_set_enqueue */
+  instrument_time_stat_t add_time; /**< of the calls of packet_set_add and packet_set_add_batch */
+  uint32_t nb_step;      /**< calls of packet_set_step */
+  uint64_t step_time;    /**< total time of these calls */
+  uint32_t nb_callback;  /**< calls of the callbacks of the application */
+  uint64_t callback_time; /**< total time spent in them (also counted in add_time and step_time) */
+  instrument_time_stat_t decode_delay; /**< of each source index, from the arrival of the first packet including it to its decoding notification */
+} packet_set_instrument_t;
+#endif /* CONF_WITH_INSTRUMENT */
+
 /*---------------------------------------------------------------------------*/
 
 #ifdef CONF_MAX_CODED_PACKET
@@ -81,6 +108,39 @@ static inline void reduction_stat_init(reduction_stat_t* stat)
 
 #define DECODED_BITMAP_SIZE (BYTES_PER_BITMAP(MAX_COEF_POS))
 
+/* Number of decoded packets that are kept after being freed from the set
+   (with packet_set_free_first), so that packets combining them can still be
+   reduced without calling get_decoded_packet_func. 0 disables the store.
+   It should be at least the size of the coding window. The store is not
+   in the default build (it makes each packet set larger): it needs an 
+   explicit CONF_DECODED_STORE_SIZE, as in the Python binding. */
+#ifdef CONF_DECODED_STORE_SIZE
+#define DECODED_STORE_SIZE CONF_DECODED_STORE_SIZE
+#else /* CONF_DECODED_STORE_SIZE */
+#define DECODED_STORE_SIZE 0
+#endif /* CONF_DECODED_STORE_SIZE */
+
+/* Number of coded packets that can be queued with packet_set_enqueue, to be
+   decoded incrementally by packet_set_step. 0 disables the queue. */
+#ifdef CONF_PACKET_SET_QUEUE_SIZE
+#define PACKET_SET_QUEUE_SIZE CONF_PACKET_SET_QUEUE_SIZE
+#else /* CONF_PACKET_SET_QUEUE_SIZE */
+#define PACKET_SET_QUEUE_SIZE 0
+#endif /* CONF_PACKET_SET_QUEUE_SIZE */
+
+/* Number of source indices described by a receiver_state_t */
+#ifdef CONF_RECEIVER_STATE_SIZE
+#define RECEIVER_STATE_SIZE CONF_RECEIVER_STATE_SIZE
+#else /* CONF_RECEIVER_STATE_SIZE */
+#define RECEIVER_STATE_SIZE 64
+#endif /* CONF_RECEIVER_STATE_SIZE */
+
+#define RECEIVER_STATE_BITMAP_SIZE (BYTES_PER_BITMAP(RECEIVER_STATE_SIZE))
+
+/* Maximum size of a serialized receiver state (see receiver_state_serialize):
+   low watermark (2 bytes), rank (1 byte), and one byte per span */
+#define RECEIVER_STATE_MAX_SERIALIZED_SIZE (3 + RECEIVER_STATE_SIZE)
+
 struct s_packet_set_t;
 
 typedef void (*notify_packet_decoded_func_t) 
@@ -93,9 +153,29 @@ typedef bool_t (*get_decoded_packet_func_t)
 (struct s_packet_set_t* packet_set, uint16_t required_min_coef_pos,
  coded_packet_t* res_coded_packet);
 
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+/**
+ * @brief Function executing all the operations of a payload program (e.g.
+ *        on several threads), see packet_set_set_payload_executor.
+ */
+typedef void (*execute_payload_func_t)
+(void* execute_data, payload_program_t* program);
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
 
 #define PACKET_ID_NONE 0xfffeu
 
+/**
+ * @brief reduction_plan_t holds the row operations found when the encoding
+ *        vector of a packet is reduced alone, to be replayed on the packet
+ *        with its payload once it is known to be innovative.
+ */
+typedef struct {
+  uint16_t coef_pos[MAX_CODED_PACKET]; /**< pivot (or decoded source index) of the packet to add, for each row operation in order */
+  uint8_t factor[MAX_CODED_PACKET]; /**< multiplier of that packet */
+  uint16_t nb_op;  /**< number of row operations */
+  uint16_t pivot;  /**< pivot of the reduced packet */
+} reduction_plan_t;
+
 /**
  * @brief packet_set_t is the main decoding buffer, 
  *        it keeps packets added with packet_set_add(...)
@@ -124,9 +204,53 @@ typedef struct s_packet_set_t {
   uint16_t nb_decoded_packet;
 
   uint8_t decoded_bitmap[DECODED_BITMAP_SIZE];
+
+#if DECODED_STORE_SIZE > 0
+  coded_packet_t decoded_store[DECODED_STORE_SIZE]; /**< freed decoded packets, the one for source index `coef_pos` is at `coef_pos % DECODED_STORE_SIZE` */
+  uint16_t decoded_store_pos[DECODED_STORE_SIZE]; /**< source index (coef_pos) of each entry of decoded_store, or COEF_POS_NONE */
+#endif /* DECODED_STORE_SIZE > 0 */
+
+#if PACKET_SET_QUEUE_SIZE > 0
+  coded_packet_t queue[PACKET_SET_QUEUE_SIZE]; /**< packets enqueued by packet_set_enqueue, the first one is being processed by packet_set_step */
+  uint16_t queue_first; /**< index in queue of the first packet */
+  uint16_t queue_count; /**< number of packets in queue */
+  uint8_t step_phase;   /**< processing of the first packet (see packet_set_step) */
+  uint16_t step_coef_pos; /**< next source index to reduce or to eliminate from */
+  uint16_t step_packet_pos; /**< pivot of the first packet, once stored */
+  uint16_t step_packet_id;  /**< its packet_id, once stored */
+  reduction_plan_t step_plan; /**< row operations to replay on the first packet */
+  uint16_t step_op; /**< next row operation of step_plan */
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+
+#ifdef CONF_WITH_INSTRUMENT
+  packet_set_instrument_t instrument; /**< see packet_set_get_instrument */
+  uint64_t seen_time[MAX_CODED_PACKET]; /**< arrival of the first packet including the source index seen_pos[i] */
+  uint16_t seen_pos[MAX_CODED_PACKET]; /**< source index (coef_pos) of each entry of seen_time, at `coef_pos % MAX_CODED_PACKET`, or COEF_POS_NONE */
+#endif /* CONF_WITH_INSTRUMENT */
+
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  payload_program_t* payload_program; /**< when not NULL, the operations on the payloads are deferred in it, see packet_set_set_payload_executor */
+  execute_payload_func_t execute_payload_func; /**< NULL to execute the program in the calling thread */
+  void* execute_payload_data;
+  uint16_t deferred_decoded_id[MAX_CODED_PACKET]; /**< decoded packets, notified after the payload program is executed */
+  uint16_t nb_deferred_decoded;
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
 } packet_set_t;
 
 
+/**
+ * @brief receiver_state_t is the decoding state of a packet set, as it can
+ *        be reported to an encoder: for the source indices from 
+ *        `coef_pos_base`, which ones are decoded, and which ones are "seen"
+ *        (they are the pivot of a packet of the set, decoded or not).
+ */
+typedef struct {
+  uint16_t coef_pos_base; /**< lowest described source index, the lower ones are considered decoded */
+  uint16_t rank; /**< number of packets of the set that are not decoded */
+  uint8_t decoded_bitmap[RECEIVER_STATE_BITMAP_SIZE]; /**< bit `i` is set when the source index `coef_pos_base+i` is decoded */
+  uint8_t seen_bitmap[RECEIVER_STATE_BITMAP_SIZE]; /**< bit `i` is set when the source index `coef_pos_base+i` is seen */
+} receiver_state_t;
+
 /**
  * @brief     Initializes one packet set.
  * @param[in] set is the packet set
@@ -135,11 +259,14 @@ typedef struct s_packet_set_t {
  *            is used (it would be `0,1,2,3` respectively).
  * @param[in] notify_packet_decoded_func (optional, can be NULL) is a callback 
  *            called every time a packet has been decoded if not NULL.
- * @param[in] notify_packet_decoded_func (optional, can be NULL) is a callback 
- *            called every time a packet has been decoded if not NULL.
+ * @param[in] notify_set_full_func (optional, can be NULL) is a callback
+ *            called when a packet cannot be stored because the set is full,
+ *            to free decoded packets (e.g. packet_set_free_decoded). When
+ *            NULL, nothing is freed and the packet is not stored.
  * @param[in] get_decoded_packet_func (optional, can be NULL) is a function
  *            used by the library, to get back decoded packet if it has been
- *            removed from the packet set. This is specific to some use cases.
+ *            removed from the packet set (and is not in the store of decoded
+ *            packets). This is specific to some use cases.
  * @param[in] notif_data not used for now (XXX), intended to be passed as last
  *            argument of each callback function.
  */
@@ -166,6 +293,149 @@ uint16_t packet_set_add(packet_set_t* set, coded_packet_t* pkt,
 			reduction_stat_t* stat,
 			bool_t can_remove);
 
+/**
+ * @brief         Add several coded packets to a packet set, as if
+ *                `packet_set_add` was called for each of them in sequence.
+ *                Each packet is reduced and stored, but the elimination of
+ *                its pivot from the other packets is done once at the end,
+ *                in one sweep for the whole batch: each packet of the set
+ *                is visited once, and reduced with all the new pivots.
+ * @param[in]     set is the packet set
+ * @param[in,out] pkt_table is an array of `nb_pkt` coded packets (they are
+ *                modified as in `packet_set_add`).
+ * @param[in]     nb_pkt is the number of coded packets.
+ * @param[out]    stat_table (optional, can be NULL) is an array of `nb_pkt`
+ *                statistics, one for each packet of `pkt_table`.
+ * @return        the number of packets that were inserted in the set.
+ * @details       The callbacks are called as with `packet_set_add`: one
+ *                notification for every decoded packet.
+ */
+uint16_t packet_set_add_batch(packet_set_t* set, coded_packet_t* pkt_table,
+			      uint16_t nb_pkt, reduction_stat_t* stat_table);
+
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+/**
+ * @brief         Separate the operations on the encoding vectors and on the
+ *                payloads: in packet_set_add and packet_set_add_batch,
+ *                the pivots are chosen and the encoding vectors are reduced
+ *                first, while the corresponding operations on the payloads
+ *                are recorded in a payload program; the program is then
+ *                executed at once by `execute_payload_func` (e.g. on 
+ *                stripes of the payloads in parallel, see stripe-pool.h), 
+ *                before the callbacks are called.
+ * @param[in]     set is the packet set
+ * @param[in]     program is the payload program used by the set (NULL to
+ *                operate on the payloads immediately, the default)
+ * @param[in]     execute_payload_func executes the program (NULL to execute
+ *                it in the calling thread)
+ * @param[in]     execute_payload_data is given to execute_payload_func
+ * @details       The result is exactly the same as without a program; it
+ *                is intended for large payloads.
+ */
+void packet_set_set_payload_executor(packet_set_t* set, 
+				     payload_program_t* program,
+				     execute_payload_func_t execute_payload_func,
+				     void* execute_payload_data);
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+
+#if PACKET_SET_QUEUE_SIZE > 0
+/**
+ * @brief         Queue one coded packet, to be added to the set by 
+ *                packet_set_step (packets are added in the order of
+ *                the queue, as with packet_set_add).
+ * @param[in]     set is the packet set
+ * @param[in]     pkt is the coded packet (it is copied)
+ * @return        true if the packet was queued, false if the queue is full.
+ */
+bool packet_set_enqueue(packet_set_t* set, coded_packet_t* pkt);
+
+/**
+ * @brief         Process the queued packets for a limited number of row 
+ *                operations: the reduction and the elimination of one 
+ *                packet can be spread over several calls, e.g. so that an
+ *                event loop can interleave the decoding of several flows
+ *                with I/O at bounded latency.
+ * @param[in]     set is the packet set
+ * @param[in]     budget is the maximum number of row operations (each 
+ *                combines the payload of one packet into another one, or
+ *                copies a packet in the set)
+ * @param[out]    stat (optional, can be NULL) holds the events of this step
+ * @return        the number of row operations done (at most `budget`).
+ * @details       The callbacks are called as with packet_set_add. Between
+ *                two steps, the set is consistent (as during 
+ *                packet_set_add_batch): it can be used in any way, except
+ *                that packet_set_add and packet_set_add_batch first 
+ *                process all the queued packets.
+ */
+uint32_t packet_set_step(packet_set_t* set, uint32_t budget,
+			 reduction_stat_t* stat);
+
+/**
+ * @brief         Returns the number of queued packets (including the one
+ *                being processed).
+ */
+static inline uint16_t packet_set_get_nb_queued(packet_set_t* set)
+{ return set->queue_count; }
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+
+#ifdef CONF_WITH_INSTRUMENT
+/**
+ * @brief         Copies the cumulative counters of one packet set (e.g. 
+ *                the difference of two snapshots gives the activity of
+ *                one period).
+ */
+static inline void packet_set_get_instrument(packet_set_t* set,
+					     packet_set_instrument_t* snapshot)
+{ memcpy(snapshot, &set->instrument, sizeof(packet_set_instrument_t)); }
+
+/**
+ * @brief         Adds the counters of `instrument` to the ones of `total`,
+ *                e.g. to aggregate the decoding delays of several sets (the
+ *                maxima are also aggregated).
+ */
+void packet_set_instrument_accumulate(packet_set_instrument_t* total,
+				      packet_set_instrument_t* instrument);
+#endif /* CONF_WITH_INSTRUMENT */
+
+/**
+ * @brief         Indicates whether a coded packet would bring new information
+ *                to the packet set, e.g. whether `packet_set_add` would not
+ *                reduce it to an empty packet.
+ * @param[in]     set is the packet set
+ * @param[in]     pkt is the coded packet, it is not modified.
+ * @return        true if the packet is innovative, false otherwise.
+ * @details       Only a copy of the encoding vector is reduced with the
+ *                stored packets: the coded payload is not accessed, so this
+ *                is much cheaper than a full reduction.
+ */
+bool packet_set_is_innovative(packet_set_t* set, coded_packet_t* pkt);
+
+/**
+ * @brief         Generate a new coded packet, as a random linear combination
+ *                of the packets of the set (decoded ones included), 
+ *                e.g. for forwarding by an intermediate node without 
+ *                decoding.
+ * @param[in]     set is the packet set
+ * @param[in]     generator is the generator of the random coefficients
+ * @param[out]    pkt is the resulting coded packet
+ * @param[in]     window_hint is the maximum number of source indices
+ *                spanned by the result (`0` for no limit); only the packets 
+ *                within the `window_hint` highest source indices of the set
+ *                are combined. It is anyway limited to the window of the 
+ *                encoding vector and to MAX_CODED_PACKET.
+ * @return        true if a packet was generated; false if the set is empty,
+ *                or if no packet is within the window (`window_hint` is
+ *                smaller than the span of every packet of the set).
+ * @details       The encoding vectors and the payloads of the packets of
+ *                the set are combined together in one pass. The decoded
+ *                packets that were freed from the set but are still within
+ *                the window are combined too: they are taken from the store
+ *                of decoded packets or from get_decoded_packet_func, and 
+ *                skipped if neither has them.
+ */
+bool packet_set_recode(packet_set_t* set, coef_generator_t* generator,
+		       coded_packet_t* pkt, uint16_t window_hint);
+
 /**
  * @brief         Get the index of the internal set->coded_packet array
  *                of the coded_packet corresponding to the pivot for
@@ -178,6 +448,18 @@ uint16_t packet_set_add(packet_set_t* set, coded_packet_t* pkt,
  */
 uint16_t packet_set_get_id_of_coef_pos(packet_set_t* set, uint16_t coef_pos);
 
+/**
+ * @brief         Get the decoded packet for one source index, either from
+ *                the set itself or from the store of recently freed
+ *                decoded packets (see DECODED_STORE_SIZE).
+ * @param[in]     set is the packet set
+ * @param[in]     coef_pos is the index of the source packet.
+ * @return        the decoded packet (owned by the set), or NULL if it is
+ *                not available.
+ */
+coded_packet_t* packet_set_get_decoded_packet(packet_set_t* set,
+					      uint16_t coef_pos);
+
 /**
  * @brief         Indicates if the packet set is empty.
  * @param[in]     set is the packet set.
@@ -199,12 +481,30 @@ uint16_t packet_set_count(packet_set_t* set, bool_t count_decoded);
  * @brief         Remove the packet that correspond to the lowest source
  *                packet index in the packet set, if there is one, and
  *                it has been decoded.
+ *                When DECODED_STORE_SIZE > 0, the removed packet is kept
+ *                in the store of decoded packets.
  * @param[in]     set is the packet set
  * @return        the packet_id if one packet has been removed,
  *                otherwise PACKET_ID_NONE
  */
 uint8_t packet_set_free_first(packet_set_t* set);
 
+/**
+ * @brief         Free the first decoded packets of the set (as with
+ *                packet_set_free_first), until its lowest source index is
+ *                at least `required_min_coef_pos`. It has the type
+ *                notify_set_full_func_t: given to packet_set_init, the set
+ *                makes room by itself when it is full.
+ * @param[in]     set is the packet set
+ * @param[in]     required_min_coef_pos is the lowest source index that the
+ *                set should keep, or COEF_POS_NONE to free one packet.
+ * @details       Packets that still combine a freed source packet can only
+ *                be reduced with the store of decoded packets (see
+ *                DECODED_STORE_SIZE) or with get_decoded_packet_func; this
+ *                is not needed when the coding window only slides forward.
+ */
+void packet_set_free_decoded(packet_set_t* set, uint16_t required_min_coef_pos);
+
 /**
  * @brief         Get the lowest source packet index of (undecoded?) packets
  * @param[in]     set is the packet set
@@ -212,6 +512,80 @@ uint8_t packet_set_free_first(packet_set_t* set);
  */
 uint16_t packet_set_get_low_index(packet_set_t* set);
 
+/**
+ * @brief         Export the decoding state of the packet set, for the
+ *                RECEIVER_STATE_SIZE source indices from `coef_pos_base`.
+ * @param[in]     set is the packet set
+ * @param[in]     coef_pos_base is the lowest source index of interest
+ *                (e.g. the lowest one that is not yet decoded, or the
+ *                lowest one of the window of the encoder).
+ * @param[out]    state is the resulting receiver state
+ */
+void packet_set_get_receiver_state(packet_set_t* set, uint16_t coef_pos_base,
+				   receiver_state_t* state);
+
+/**
+ * @brief         Indicates whether a source index is decoded in a receiver
+ *                state (those below its base are, those above its end 
+ *                are not).
+ */
+static inline bool receiver_state_is_decoded(receiver_state_t* state,
+					     uint16_t coef_pos)
+{
+  if (coef_pos < state->coef_pos_base)
+    return true;
+  if (coef_pos - state->coef_pos_base >= RECEIVER_STATE_SIZE)
+    return false;
+  return bitmap_get_bit(state->decoded_bitmap, RECEIVER_STATE_BITMAP_SIZE,
+			coef_pos - state->coef_pos_base);
+}
+
+/**
+ * @brief         Indicates whether a source index is seen in a receiver
+ *                state (a decoded source index is also seen).
+ */
+static inline bool receiver_state_is_seen(receiver_state_t* state,
+					  uint16_t coef_pos)
+{
+  if (coef_pos < state->coef_pos_base)
+    return true;
+  if (coef_pos - state->coef_pos_base >= RECEIVER_STATE_SIZE)
+    return false;
+  return bitmap_get_bit(state->seen_bitmap, RECEIVER_STATE_BITMAP_SIZE,
+			coef_pos - state->coef_pos_base);
+}
+
+/**
+ * @brief         Serialize a receiver state in a few bytes, e.g. for
+ *                feedback piggybacked on reverse packets.
+ * @param[in]     state is the receiver state
+ * @param[out]    buffer is the result
+ * @param[in]     buffer_size is the size of `buffer` (it is enough when
+ *                at least RECEIVER_STATE_MAX_SERIALIZED_SIZE)
+ * @return        the size of the serialized state, or 0 if it does not fit
+ *                in `buffer`.
+ * @details       The format is: the low watermark (first source index that
+ *                is not decoded, 2 bytes, big endian), the rank (1 byte, 
+ *                saturated), then the spans of source indices from the low
+ *                watermark that are unseen, seen or decoded, one byte per 
+ *                span: the kind in the 2 highest bits (0, 1, 2 
+ *                respectively), the length minus one in the others. The 
+ *                last unseen span is omitted.
+ */
+uint16_t receiver_state_serialize(receiver_state_t* state, uint8_t* buffer,
+				  uint16_t buffer_size);
+
+/**
+ * @brief         Parse a receiver state serialized by 
+ *                receiver_state_serialize.
+ * @param[out]    state is the resulting receiver state
+ * @param[in]     buffer is the serialized state
+ * @param[in]     buffer_size is its size
+ * @return        true if the serialized state is valid, false otherwise.
+ */
+bool receiver_state_parse(receiver_state_t* state, uint8_t* buffer,
+			  uint16_t buffer_size);
+
 /**
  * @brief         (Internal) Adjust the coef_pos_min and coef_pos_max of the
  *                packet set to the current value.
@@ -231,12 +605,21 @@ void packet_set_check(packet_set_t* set);
 
 #ifdef CONF_WITH_FPRINTF
 
+void bitmap_pywrite(FILE* out, uint8_t* bitmap, uint16_t size);
+
 void coef_pos_pywrite(FILE* out, uint16_t coef_pos);
 
 void packet_set_pywrite(FILE* out, packet_set_t* set);
 
 void reduction_stat_pywrite(FILE* out, reduction_stat_t* stat);
 
+#ifdef CONF_WITH_INSTRUMENT
+void packet_set_instrument_pywrite(FILE* out, 
+				   packet_set_instrument_t* instrument);
+#endif /* CONF_WITH_INSTRUMENT */
+
+void receiver_state_pywrite(FILE* out, receiver_state_t* state);
+
 #endif /* CONF_WITH_FPRINTF */
 
 /*---------------------------------------------------------------------------*/
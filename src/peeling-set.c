@@ -0,0 +1,504 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Peeling decoder with inactivation, for sparse combinations
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "bitmap.h"
+#include "peeling-set.h"
+
+/*---------------------------------------------------------------------------*/
+
+void peeling_set_init
+(peeling_set_t* set, uint8_t log2_nb_bit_coef,
+ peeling_notify_packet_decoded_func_t notify_packet_decoded_func,
+ peeling_notify_set_full_func_t notify_set_full_func,
+ peeling_get_decoded_packet_func_t get_decoded_packet_func,
+ void* notif_data)
+{
+  uint16_t i;
+  for (i=0; i<MAX_CODED_PACKET; i++) {
+    set->state[i] = PEELING_STATE_FREE;
+    set->id_to_pos[i] = COEF_POS_NONE;
+    set->pos_to_id[i] = PACKET_ID_NONE;
+  }
+  set->coef_pos_min = COEF_POS_NONE;
+  set->coef_pos_max = COEF_POS_NONE;
+  set->log2_nb_bit_coef = log2_nb_bit_coef;
+
+  set->notify_packet_decoded_func = notify_packet_decoded_func;
+  set->notify_set_full_func = notify_set_full_func;
+  set->get_decoded_packet_func = get_decoded_packet_func;
+  set->notif_data = notif_data;
+
+  set->nb_decoded_packet = 0;
+  bitmap_init(set->decoded_bitmap, DECODED_BITMAP_SIZE);
+}
+
+/* maximum number of source indices spanned by the packets of the set */
+static uint16_t peeling_set_max_span(peeling_set_t* set)
+{ return MIN(MAX_CODED_PACKET, 1<<log2_window_size(set->log2_nb_bit_coef)); }
+
+bool peeling_set_is_empty(peeling_set_t* set)
+{
+  if (set->coef_pos_min == COEF_POS_NONE) {
+    ASSERT( set->coef_pos_max == COEF_POS_NONE );
+    return true;
+  }
+  return false;
+}
+
+static void peeling_set_adjust_min_max_coef(peeling_set_t* set)
+{
+  set->coef_pos_min = COEF_POS_NONE;
+  set->coef_pos_max = COEF_POS_NONE;
+  uint16_t i;
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    if (set->state[i] != PEELING_STATE_FREE) {
+      coded_packet_t* pkt = &set->coded_packet[i];
+      set->coef_pos_min = min_except(set->coef_pos_min, pkt->coef_pos_min,
+				     COEF_POS_NONE);
+      set->coef_pos_max = max_except(set->coef_pos_max, pkt->coef_pos_max,
+				     COEF_POS_NONE);
+    }
+}
+
+coded_packet_t* peeling_set_get_decoded_packet(peeling_set_t* set,
+					       uint16_t coef_pos)
+{
+  if (peeling_set_is_empty(set)
+      || coef_pos < set->coef_pos_min || coef_pos > set->coef_pos_max)
+    return NULL;
+  uint16_t packet_id = set->pos_to_id[coef_pos % MAX_CODED_PACKET];
+  if (packet_id == PACKET_ID_NONE)
+    return NULL;
+  ASSERT( set->state[packet_id] == PEELING_STATE_DECODED );
+  ASSERT( set->coded_packet[packet_id].coef_pos_min == coef_pos );
+  return &set->coded_packet[packet_id];
+}
+
+uint16_t peeling_set_count(peeling_set_t* set, bool_t count_decoded)
+{
+  uint16_t result = 0;
+  uint16_t i;
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    if (set->state[i] == PEELING_STATE_PENDING
+	|| (count_decoded && set->state[i] == PEELING_STATE_DECODED))
+      result ++;
+  return result;
+}
+
+static void peeling_set_release(peeling_set_t* set, uint16_t packet_id)
+{
+  if (set->state[packet_id] == PEELING_STATE_DECODED) {
+    uint16_t coef_pos = set->coded_packet[packet_id].coef_pos_min;
+    set->pos_to_id[coef_pos % MAX_CODED_PACKET] = PACKET_ID_NONE;
+  }
+  set->id_to_pos[packet_id] = COEF_POS_NONE;
+  set->state[packet_id] = PEELING_STATE_FREE;
+  peeling_set_adjust_min_max_coef(set);
+}
+
+uint8_t peeling_set_free_first(peeling_set_t* set)
+{
+  ASSERT (!peeling_set_is_empty(set));
+  coded_packet_t* pkt = peeling_set_get_decoded_packet(set, set->coef_pos_min);
+  /* don't throw undecoded packets */
+  if (pkt == NULL)
+    return false;
+  peeling_set_release(set, pkt - set->coded_packet);
+  return true;
+}
+
+void peeling_set_free_decoded(peeling_set_t* set,
+			      uint16_t required_min_coef_pos)
+{
+  while (!peeling_set_is_empty(set) && peeling_set_free_first(set))
+    if (required_min_coef_pos == COEF_POS_NONE
+	|| (!peeling_set_is_empty(set)
+	    && set->coef_pos_min >= required_min_coef_pos))
+      break;
+}
+
+static void peeling_set_notify_full(peeling_set_t* set,
+				    uint16_t required_min_coef_pos)
+{
+  if (set->notify_set_full_func != NULL)
+    set->notify_set_full_func(set, required_min_coef_pos);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the pending packet `packet_id` has one source left: it is decoded, 
+   and substituted in the other pending packets */
+static void peeling_set_decode(peeling_set_t* set, uint16_t packet_id,
+			       reduction_stat_t* stat)
+{
+  uint8_t l = set->log2_nb_bit_coef;
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint16_t coef_pos = pkt->coef_pos_min;
+  ASSERT( coded_packet_was_decoded(pkt) && !coded_packet_was_empty(pkt) );
+  ASSERT( !bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, coef_pos));
+
+  uint8_t coef = coded_packet_get_coef(pkt, coef_pos);
+  if (coef != 1)
+    coded_packet_to_mul(pkt, lc_inv(coef, l));
+  set->state[packet_id] = PEELING_STATE_DECODED;
+  set->id_to_pos[packet_id] = coef_pos;
+  set->pos_to_id[coef_pos % MAX_CODED_PACKET] = packet_id;
+  bitmap_set_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, coef_pos);
+  set->nb_decoded_packet ++;
+  stat->decoded ++;
+
+  uint16_t i;
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    if (set->state[i] == PEELING_STATE_PENDING
+	&& coded_packet_substitute_decoded(&set->coded_packet[i], pkt)) {
+      stat->elimination ++;
+      if (coded_packet_was_empty(&set->coded_packet[i])) {
+	/* it was another packet for the same (last) source */
+	stat->non_innovative ++;
+	peeling_set_release(set, i);
+      }
+    }
+
+  if (set->notify_packet_decoded_func != NULL)
+    set->notify_packet_decoded_func(set, packet_id);
+}
+
+/* The inactivation below works on a table of packets and of their states:
+   either the ones of the set, or copies of the encoding vectors of its
+   pending packets (`header_only`), with the payloads left untouched. */
+
+/* the pending packet `packet_id` is scaled so that its coefficient of
+   `coef_pos` is 1, and eliminated from the other pending packets */
+static void peeling_set_eliminate(peeling_set_t* set, coded_packet_t* table,
+				  uint8_t* state, bool header_only,
+				  uint16_t packet_id, uint16_t coef_pos,
+				  reduction_stat_t* stat)
+{
+  uint8_t l = set->log2_nb_bit_coef;
+  coded_packet_t* pivot_pkt = &table[packet_id];
+  uint8_t coef = coded_packet_get_coef(pivot_pkt, coef_pos);
+  ASSERT( coef != 0 );
+  if (coef != 1) /* (only the header of a copy, as its data_size is 0) */
+    coded_packet_to_mul(pivot_pkt, lc_inv(coef, l));
+
+  uint16_t j;
+  for (j=0; j<MAX_CODED_PACKET; j++) {
+    if (j == packet_id || state[j] != PEELING_STATE_PENDING)
+      continue;
+    coded_packet_t* other_pkt = &table[j];
+    coef = coded_packet_get_coef(other_pkt, coef_pos);
+    if (coef == 0)
+      continue;
+    if (header_only)
+      coded_packet_header_add_mult(other_pkt, lc_neg(coef, l), pivot_pkt);
+    else {
+      coded_packet_add_mult(other_pkt, lc_neg(coef, l), pivot_pkt);
+      stat->elimination ++;
+    }
+    if (!coded_packet_adjust_min_max_coef(other_pkt)) {
+      /* linearly dependent packets */
+      if (header_only)
+	state[j] = PEELING_STATE_FREE;
+      else {
+	stat->non_innovative ++;
+	peeling_set_release(set, j);
+      }
+    }
+  }
+}
+
+/* peeling has stalled: inactivation decoding of the pending packets.
+   The unknown source found in the most (non-peeled) pending packets is
+   inactivated, and peeling goes on as if it was known: a pending packet
+   with one active source left is eliminated from the other packets.
+   When all pending packets are peeled or have only inactivated sources,
+   the latter are solved with Gauss-Jordan elimination, which is also
+   eliminated from the peeled packets. A pending packet is then left with
+   one source exactly when Gaussian Elimination of the pending packets
+   would decode this source.
+   The choices only depend on the encoding vectors, so that a run on
+   `header_only` copies performs the same row operations as a run on
+   the set.
+   Returns true if this yields at least one packet with one source left. */
+static bool peeling_set_inactivate(peeling_set_t* set, coded_packet_t* table,
+				   uint8_t* state, bool header_only,
+				   reduction_stat_t* stat)
+{
+  bool_t is_inactive[MAX_CODED_PACKET]; /* of coef_pos - coef_pos_base */
+  uint16_t nb_packet[MAX_CODED_PACKET]; /* of coef_pos - coef_pos_base */
+  bool_t is_used[MAX_CODED_PACKET]; /* of packet_id: peeled or pivot */
+  uint16_t i, coef_pos;
+
+  /* the bounds of the set only shrink as packets are released */
+  uint16_t coef_pos_base = set->coef_pos_min;
+  uint16_t coef_pos_last = set->coef_pos_max;
+  ASSERT( coef_pos_last - coef_pos_base < MAX_CODED_PACKET );
+  memset(is_inactive, 0, sizeof(is_inactive));
+  memset(is_used, 0, sizeof(is_used));
+
+  for (;;) {
+    uint16_t peel_id = PACKET_ID_NONE;
+    uint16_t peel_pos = COEF_POS_NONE;
+    memset(nb_packet, 0, sizeof(nb_packet));
+    for (i=0; i<MAX_CODED_PACKET && peel_id == PACKET_ID_NONE; i++) {
+      if (state[i] != PEELING_STATE_PENDING || is_used[i])
+	continue;
+      coded_packet_t* pkt = &table[i];
+      uint16_t nb_active = 0;
+      uint16_t active_pos = COEF_POS_NONE;
+      for (coef_pos = pkt->coef_pos_min; coef_pos <= pkt->coef_pos_max;
+	   coef_pos ++)
+	if (!is_inactive[coef_pos - coef_pos_base]
+	    && coded_packet_get_coef(pkt, coef_pos) != 0) {
+	  nb_active ++;
+	  nb_packet[coef_pos - coef_pos_base] ++;
+	  active_pos = coef_pos;
+	}
+      if (nb_active == 1) {
+	peel_id = i;
+	peel_pos = active_pos;
+      }
+    }
+
+    if (peel_id != PACKET_ID_NONE) {
+      is_used[peel_id] = true;
+      peeling_set_eliminate(set, table, state, header_only,
+			    peel_id, peel_pos, stat);
+      continue;
+    }
+
+    uint16_t best_index = 0;
+    for (i=1; i<=coef_pos_last - coef_pos_base; i++)
+      if (nb_packet[i] > nb_packet[best_index])
+	best_index = i;
+    if (nb_packet[best_index] == 0)
+      break; /* only inactivated sources are left */
+    is_inactive[best_index] = true;
+    if (header_only)
+      stat->inactivation ++;
+  }
+
+  for (coef_pos = coef_pos_last; ; coef_pos --) {
+    if (is_inactive[coef_pos - coef_pos_base]) {
+      uint16_t pivot_id = PACKET_ID_NONE;
+      for (i=0; i<MAX_CODED_PACKET && pivot_id == PACKET_ID_NONE; i++)
+	if (state[i] == PEELING_STATE_PENDING && !is_used[i]
+	    && coded_packet_get_coef(&table[i], coef_pos) != 0)
+	  pivot_id = i;
+      if (pivot_id != PACKET_ID_NONE) {
+	is_used[pivot_id] = true;
+	peeling_set_eliminate(set, table, state, header_only,
+			      pivot_id, coef_pos, stat);
+      }
+    }
+    if (coef_pos == coef_pos_base)
+      break;
+  }
+
+  bool result = false;
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    if (state[i] == PEELING_STATE_PENDING
+	&& coded_packet_was_decoded(&table[i]))
+      result = true;
+  return result;
+}
+
+/* inactivation is first run on the encoding vectors of the pending
+   packets, and is run again with the payloads only when it decodes
+   at least one source: a packet that does not give enough rank to the
+   inactivated sources costs no payload operation. */
+static bool peeling_set_try_inactivate(peeling_set_t* set,
+				       reduction_stat_t* stat)
+{
+  coded_packet_t header[MAX_CODED_PACKET];
+  uint8_t state[MAX_CODED_PACKET];
+  uint16_t i;
+
+  if (peeling_set_count(set, false) < 2)
+    return false;
+  for (i=0; i<MAX_CODED_PACKET; i++) {
+    state[i] = set->state[i];
+    if (state[i] == PEELING_STATE_PENDING)
+      coded_packet_copy_header_from(&header[i], &set->coded_packet[i]);
+  }
+  if (!peeling_set_inactivate(set, header, state, true, stat))
+    return false;
+
+  bool result = peeling_set_inactivate(set, set->coded_packet, set->state,
+				       false, stat);
+  ASSERT( result );
+  return result;
+}
+
+static void peeling_set_peel(peeling_set_t* set, reduction_stat_t* stat)
+{
+  for (;;) {
+    bool progress = false;
+    uint16_t i;
+    for (i=0; i<MAX_CODED_PACKET; i++)
+      if (set->state[i] == PEELING_STATE_PENDING
+	  && coded_packet_was_decoded(&set->coded_packet[i])) {
+	peeling_set_decode(set, i, stat);
+	progress = true;
+      }
+    if (!progress && !peeling_set_try_inactivate(set, stat))
+      break;
+  }
+  peeling_set_adjust_min_max_coef(set); /* substitutions shrink packets */
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint16_t peeling_set_alloc_packet_id(peeling_set_t* set)
+{
+  uint16_t i;
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    if (set->state[i] == PEELING_STATE_FREE)
+      return i;
+  return PACKET_ID_NONE;
+}
+
+uint16_t peeling_set_add(peeling_set_t* set, coded_packet_t* pkt,
+			 reduction_stat_t* stat, bool_t can_remove)
+{
+  (void)can_remove;
+  reduction_stat_t local_stat;
+  if (stat == NULL)
+    stat = &local_stat;
+  reduction_stat_init(stat);
+  REQUIRE( set->log2_nb_bit_coef == pkt->log2_nb_bit_coef );
+
+  if (!coded_packet_adjust_min_max_coef(pkt)) {
+    stat->non_innovative ++;
+    return PACKET_ID_NONE;
+  }
+
+  /* substitute the decoded sources */
+  uint16_t coef_pos;
+  for (coef_pos = pkt->coef_pos_min; coef_pos <= pkt->coef_pos_max; 
+       coef_pos ++) {
+    if (coded_packet_get_coef(pkt, coef_pos) == 0
+	|| !bitmap_get_bit(set->decoded_bitmap, DECODED_BITMAP_SIZE, coef_pos))
+      continue;
+    coded_packet_t tmp_pkt;
+    coded_packet_t* decoded_pkt = peeling_set_get_decoded_packet(set, coef_pos);
+    if (decoded_pkt == NULL && set->get_decoded_packet_func != NULL
+	&& set->get_decoded_packet_func(set, coef_pos, &tmp_pkt))
+      decoded_pkt = &tmp_pkt;
+    if (decoded_pkt == NULL) {
+      /* the packet cannot be used without this source */
+      stat->non_reduction ++;
+      return PACKET_ID_NONE;
+    }
+    coded_packet_substitute_decoded(pkt, decoded_pkt);
+    stat->reduction_success ++;
+    if (coded_packet_was_empty(pkt)) {
+      stat->non_innovative ++;
+      return PACKET_ID_NONE;
+    }
+  }
+
+  /* check that it fits in the set, possibly after making room */
+  uint16_t max_span = peeling_set_max_span(set);
+  if (!peeling_set_is_empty(set) && pkt->coef_pos_max > set->coef_pos_max
+      && pkt->coef_pos_max - set->coef_pos_min >= max_span)
+    peeling_set_notify_full(set, pkt->coef_pos_max - max_span + 1);
+  if (!peeling_set_is_empty(set)) {
+    uint16_t coef_pos_min = MIN(pkt->coef_pos_min, set->coef_pos_min);
+    uint16_t coef_pos_max = MAX(pkt->coef_pos_max, set->coef_pos_max);
+    if (coef_pos_max - coef_pos_min >= max_span) {
+      if (pkt->coef_pos_max > set->coef_pos_max)
+	stat->coef_pos_too_high ++;
+      else stat->coef_pos_too_low ++;
+      return PACKET_ID_NONE;
+    }
+  }
+
+  uint16_t packet_id = peeling_set_alloc_packet_id(set);
+  if (packet_id == PACKET_ID_NONE) {
+    peeling_set_notify_full(set, COEF_POS_NONE);
+    packet_id = peeling_set_alloc_packet_id(set);
+  }
+  if (packet_id == PACKET_ID_NONE) {
+    WARN("no room in peeling_set_add");
+    return PACKET_ID_NONE;
+  }
+
+  coded_packet_copy_from(&set->coded_packet[packet_id], pkt);
+  set->state[packet_id] = PEELING_STATE_PENDING;
+  set->coef_pos_min = min_except(set->coef_pos_min, pkt->coef_pos_min,
+				 COEF_POS_NONE);
+  set->coef_pos_max = max_except(set->coef_pos_max, pkt->coef_pos_max,
+				 COEF_POS_NONE);
+  peeling_set_peel(set, stat);
+  return packet_id;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void peeling_set_pywrite(FILE* out, peeling_set_t* set)
+{
+  fprintf(out, "{ 'type':'peeling-set'");
+  fprintf(out, ", 'l':%u", set->log2_nb_bit_coef);
+  fprintf(out, ", 'coefPosMin':");
+  coef_pos_pywrite(out, set->coef_pos_min);
+  fprintf(out, ", 'coefPosMax':"); 
+  coef_pos_pywrite(out, set->coef_pos_max);
+  fprintf(out, ", 'packetTable': {");
+  uint16_t i;
+  bool is_first = true;
+  for (i=0; i<MAX_CODED_PACKET; i++)
+    if (set->state[i] != PEELING_STATE_FREE) {
+      if (is_first) is_first = false;
+      else fprintf(out, ", ");
+      fprintf(out, "%d:", i);
+      coded_packet_pywrite(out, &set->coded_packet[i]);
+    }
+  fprintf(out, "}");
+  fprintf(out, ", 'decoded':");
+  bitmap_pywrite(out, set->decoded_bitmap, DECODED_BITMAP_SIZE);
+  fprintf(out, " }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,194 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Peeling decoder with inactivation, for sparse combinations
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __PEELING_SET_H__
+#define __PEELING_SET_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "bitmap.h"
+#include "coded-packet.h"
+#include "packet-set.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define PEELING_STATE_FREE    0 /**< the slot holds no packet */
+#define PEELING_STATE_PENDING 1 /**< the packet has several unknown sources */
+#define PEELING_STATE_DECODED 2 /**< the packet is one decoded source */
+
+struct s_peeling_set_t;
+
+/* the callbacks of a peeling set, as the ones of a packet set */
+
+typedef void (*peeling_notify_packet_decoded_func_t)
+(struct s_peeling_set_t* peeling_set, uint16_t packet_index);
+
+typedef void (*peeling_notify_set_full_func_t)
+(struct s_peeling_set_t* peeling_set, uint16_t required_min_coef_pos);
+
+typedef bool_t (*peeling_get_decoded_packet_func_t)
+(struct s_peeling_set_t* peeling_set, uint16_t required_min_coef_pos,
+ coded_packet_t* res_coded_packet);
+
+/**
+ * @brief peeling_set_t is an alternate decoding buffer to packet_set_t, 
+ *        with a similar interface. It is intended for sparse combinations:
+ *        decoded sources are substituted in the stored packets, and
+ *        every packet left with only one unknown source is decoded
+ *        ("peeled"). When peeling stalls, the unknown source found in
+ *        the most pending packets is "inactivated": peeling goes on as
+ *        if it was known, and the inactivated sources are finally solved
+ *        with Gaussian Elimination on the packets left with only them.
+ *        This decodes every source that Gaussian Elimination on the
+ *        pending packets would decode.
+ *
+ * @details The packets of the set span at most MAX_CODED_PACKET source
+ *          indices (and the window of the encoding vector).
+ *          Unlike packet_set_t, non-decoded packets are not eliminated
+ *          with each other as they arrive, and inactivation is first run
+ *          on their encoding vectors only: the payloads are combined only
+ *          when it decodes at least one source.
+ */
+typedef struct s_peeling_set_t {
+  coded_packet_t coded_packet[MAX_CODED_PACKET]; /**< the actual set */
+  uint16_t id_to_pos[MAX_CODED_PACKET]; /**< index in coded_packet array (packet_id) to decoded source (coef_pos), COEF_POS_NONE when not decoded */
+  uint16_t pos_to_id[MAX_CODED_PACKET]; /**< decoded source (coef_pos) to index in coded_packet (packet_id) */
+
+  void* notif_data;
+  peeling_notify_packet_decoded_func_t notify_packet_decoded_func;
+  peeling_notify_set_full_func_t notify_set_full_func;
+  peeling_get_decoded_packet_func_t get_decoded_packet_func;
+
+  uint16_t coef_pos_min;
+  uint16_t coef_pos_max; 
+  uint8_t log2_nb_bit_coef; /**< same as in packet_set_t */
+  uint16_t nb_decoded_packet;
+
+  uint8_t decoded_bitmap[DECODED_BITMAP_SIZE];
+
+  uint8_t state[MAX_CODED_PACKET]; /**< PEELING_STATE_... of each packet */
+} peeling_set_t;
+
+/**
+ * @brief     Initializes one peeling set, see `packet_set_init`.
+ */
+void peeling_set_init
+(peeling_set_t* set, uint8_t log2_nb_bit_coef,
+ peeling_notify_packet_decoded_func_t notify_packet_decoded_func,
+ peeling_notify_set_full_func_t notify_set_full_func,
+ peeling_get_decoded_packet_func_t get_decoded_packet_func,
+ void* notif_data);
+
+/**
+ * @brief         Add one coded packet to a peeling set: decoded sources
+ *                are substituted in it, then peeling (and if needed,
+ *                inactivation) is performed. Multiple packets can be decoded,
+ *                appropriate callbacks are called (decoded, set full, ...).
+ * @param[in]     set is the peeling set
+ * @param[in,out] pkt is the coded packet that is added to the set. It is 
+ *                modified by the substitutions.
+ * @param[out]    stat (optional, can be NULL) holds information (counters)
+ *                of the events that happened; `inactivation` is the number 
+ *                of sources that were inactivated when peeling stalled.
+ * @param[in]     can_remove is currently not used.
+ * @return        return the packet_id associated with the inserted packet,
+ *                or PACKET_ID_NONE otherwise.
+ */
+uint16_t peeling_set_add(peeling_set_t* set, coded_packet_t* pkt,
+			 reduction_stat_t* stat, bool_t can_remove);
+
+/**
+ * @brief         Get the decoded packet for one source index, if it is
+ *                in the set.
+ * @param[in]     set is the peeling set
+ * @param[in]     coef_pos is the index of the source packet.
+ * @return        the decoded packet (owned by the set), or NULL.
+ */
+coded_packet_t* peeling_set_get_decoded_packet(peeling_set_t* set,
+					       uint16_t coef_pos);
+
+/**
+ * @brief         Indicates if the peeling set is empty.
+ */
+bool peeling_set_is_empty(peeling_set_t* set);
+
+/**
+ * @brief         Counts the number of coded packets in the peeling set,
+ *                see `packet_set_count`.
+ */
+uint16_t peeling_set_count(peeling_set_t* set, bool_t count_decoded);
+
+/**
+ * @brief         Remove the decoded packet that corresponds to the lowest 
+ *                source packet index in the peeling set, if there is one
+ *                (and no non-decoded packet has a lower index).
+ * @param[in]     set is the peeling set
+ * @return        true if one packet has been removed, false otherwise.
+ */
+uint8_t peeling_set_free_first(peeling_set_t* set);
+
+/**
+ * @brief         Free the first decoded packets of the peeling set, as 
+ *                packet_set_free_decoded does for a packet set: it is the
+ *                notify_set_full_func to give to peeling_set_init for 
+ *                the peeling set to make room by itself when it is full.
+ * @param[in]     set is the peeling set
+ * @param[in]     required_min_coef_pos is the lowest source index that the
+ *                set should keep, or COEF_POS_NONE to free one packet.
+ */
+void peeling_set_free_decoded(peeling_set_t* set,
+			      uint16_t required_min_coef_pos);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void peeling_set_pywrite(FILE* out, peeling_set_t* set);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PEELING_SET_H__ */
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -44,6 +44,15 @@
 #define WITH_GF256
 
 #define CONF_WITH_FPRINTF
+#define CONF_WITH_PTHREAD
+
+#ifndef CONF_DECODED_STORE_SIZE
+#define CONF_DECODED_STORE_SIZE 0
+#endif /* CONF_DECODED_STORE_SIZE */
+
+#ifndef CONF_ENCODER_NB_ACCUMULATOR
+#define CONF_ENCODER_NB_ACCUMULATOR 4
+#endif /* CONF_ENCODER_NB_ACCUMULATOR */
 
 /*---------------------------------------------------------------------------*/
 
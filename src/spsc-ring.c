@@ -0,0 +1,200 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Bounded lock-free ring with a single producer and a single 
+ *          consumer
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "spsc-ring.h"
+
+#ifdef CONF_WITH_PTHREAD
+
+/*---------------------------------------------------------------------------*/
+
+void spsc_ring_init(spsc_ring_t* ring, void* buffer, uint32_t entry_size,
+		    uint32_t size)
+{
+  REQUIRE( size > 0 && (size & (size-1)) == 0 );
+  memset(ring, 0, sizeof(*ring));
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->head, 0);
+  ring->buffer = buffer;
+  ring->entry_size = entry_size;
+  ring->size = size;
+  atomic_init(&ring->producer_sleeping, false);
+  atomic_init(&ring->consumer_sleeping, false);
+  atomic_init(&ring->is_closed, false);
+  pthread_mutex_init(&ring->lock, NULL);
+  pthread_cond_init(&ring->wake, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* same as spsc_ring_reserve, without the statistics */
+static void* spsc_ring_get_free(spsc_ring_t* ring)
+{
+  ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  if (tail - ring->cached_head == ring->size)
+    return NULL;
+  return ring->buffer + (tail & (ring->size-1)) * ring->entry_size;
+}
+
+/* same as spsc_ring_peek, without the statistics */
+static void* spsc_ring_get_used(spsc_ring_t* ring)
+{
+  ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  if (head == ring->cached_tail)
+    return NULL;
+  return ring->buffer + (head & (ring->size-1)) * ring->entry_size;
+}
+
+/* The sleeping flag is set before the last check of the ring (under the 
+   lock), and the other side moves its index before checking the flag, 
+   with a fence on each side: either the last check sees the new index, 
+   or the other side sees the flag and wakes this side, once it waits. */
+
+void* spsc_ring_wait_not_full(spsc_ring_t* ring)
+{
+  uint32_t nb_poll = 0;
+  void* entry;
+  ring->producer_stat.nb_wait ++;
+  while ((entry = spsc_ring_get_free(ring)) == NULL) {
+    if (nb_poll < SPSC_RING_NB_POLL) {
+      nb_poll ++;
+      sched_yield();
+      continue;
+    }
+    pthread_mutex_lock(&ring->lock);
+    atomic_store_explicit(&ring->producer_sleeping, true, 
+			  memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while ((entry = spsc_ring_get_free(ring)) == NULL) {
+      ring->producer_stat.nb_sleep ++;
+      pthread_cond_wait(&ring->wake, &ring->lock);
+    }
+    atomic_store_explicit(&ring->producer_sleeping, false,
+			  memory_order_relaxed);
+    pthread_mutex_unlock(&ring->lock);
+  }
+  return entry;
+}
+
+void* spsc_ring_wait_not_empty(spsc_ring_t* ring)
+{
+  uint32_t nb_poll = 0;
+  void* entry;
+  while ((entry = spsc_ring_get_used(ring)) == NULL) {
+    /* the last entries are committed before the ring is closed */
+    if (atomic_load_explicit(&ring->is_closed, memory_order_acquire))
+      return spsc_ring_get_used(ring);
+    if (nb_poll < SPSC_RING_NB_POLL) {
+      nb_poll ++;
+      sched_yield();
+      continue;
+    }
+    pthread_mutex_lock(&ring->lock);
+    atomic_store_explicit(&ring->consumer_sleeping, true,
+			  memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while ((entry = spsc_ring_get_used(ring)) == NULL
+	   && !atomic_load_explicit(&ring->is_closed, memory_order_acquire)) {
+      ring->consumer_stat.nb_sleep ++;
+      pthread_cond_wait(&ring->wake, &ring->lock);
+    }
+    atomic_store_explicit(&ring->consumer_sleeping, false,
+			  memory_order_relaxed);
+    pthread_mutex_unlock(&ring->lock);
+  }
+  return entry;
+}
+
+void spsc_ring_wake(spsc_ring_t* ring)
+{
+  pthread_mutex_lock(&ring->lock);
+  pthread_cond_broadcast(&ring->wake);
+  pthread_mutex_unlock(&ring->lock);
+}
+
+void spsc_ring_close(spsc_ring_t* ring)
+{
+  pthread_mutex_lock(&ring->lock);
+  atomic_store_explicit(&ring->is_closed, true, memory_order_release);
+  pthread_cond_broadcast(&ring->wake);
+  pthread_mutex_unlock(&ring->lock);
+}
+
+void spsc_ring_get_stat(spsc_ring_t* ring, spsc_ring_stat_t* stat)
+{
+  memcpy(&stat->producer, &ring->producer_stat, sizeof(stat->producer));
+  memcpy(&stat->consumer, &ring->consumer_stat, sizeof(stat->consumer));
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void spsc_ring_stat_pywrite(FILE* out, spsc_ring_stat_t* stat)
+{
+  uint16_t i, last = 0;
+  fprintf(out, "{ 'type':'spsc-ring-stat'");
+  fprintf(out, ", 'nbCommit':%u", stat->producer.nb_commit);
+  fprintf(out, ", 'nbFull':%u", stat->producer.nb_full);
+  fprintf(out, ", 'nbWait':%u", stat->producer.nb_wait);
+  fprintf(out, ", 'nbProducerSleep':%u", stat->producer.nb_sleep);
+  fprintf(out, ", 'occupancyMax':%u", stat->producer.occupancy_max);
+  for (i=0; i<SPSC_RING_NB_OCCUPANCY_BUCKET; i++)
+    if (stat->producer.occupancy_hist[i] > 0)
+      last = i;
+  fprintf(out, ", 'occupancyHist':[");
+  for (i=0; i<=last; i++)
+    fprintf(out, "%s%u", (i > 0) ? "," : "", 
+	    stat->producer.occupancy_hist[i]);
+  fprintf(out, "]");
+  fprintf(out, ", 'nbRelease':%u", stat->consumer.nb_release);
+  fprintf(out, ", 'nbEmpty':%u", stat->consumer.nb_empty);
+  fprintf(out, ", 'nbConsumerSleep':%u", stat->consumer.nb_sleep);
+  fprintf(out, " }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
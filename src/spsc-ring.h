@@ -0,0 +1,300 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Bounded lock-free ring with a single producer and a single 
+ *          consumer
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "general.h"
+
+#ifdef CONF_WITH_PTHREAD
+
+#include <stdatomic.h>
+#include <sched.h>
+#include <pthread.h>
+
+/*---------------------------------------------------------------------------*/
+
+#define SPSC_RING_CACHE_LINE_SIZE 64
+
+/* Number of polls of a waiting side (yielding the processor) before it 
+   sleeps until the other side wakes it */
+#ifdef CONF_SPSC_RING_NB_POLL
+#define SPSC_RING_NB_POLL CONF_SPSC_RING_NB_POLL
+#else /* CONF_SPSC_RING_NB_POLL */
+#define SPSC_RING_NB_POLL 64
+#endif /* CONF_SPSC_RING_NB_POLL */
+
+/* Number of buckets of the histogram of the occupancy: bucket `i` counts
+   the occupancies in [2^(i-1), 2^i) (bucket 0 is for an empty ring) */
+#define SPSC_RING_NB_OCCUPANCY_BUCKET 17
+
+/**
+ * @brief spsc_ring_producer_stat_t gives the backpressure seen by the 
+ *        producer of a ring: it is written only by the producer.
+ */
+typedef struct {
+  uint32_t nb_commit;    /**< entries written */
+  uint32_t nb_full;      /**< calls of spsc_ring_reserve with a full ring */
+  uint32_t nb_wait;      /**< calls of spsc_ring_reserve_wait that waited */
+  uint32_t nb_sleep;     /**< times spsc_ring_reserve_wait slept */
+  uint32_t occupancy_max; /**< highest number of entries, after a commit */
+  uint32_t occupancy_hist[SPSC_RING_NB_OCCUPANCY_BUCKET]; /**< number of entries, after each commit */
+} spsc_ring_producer_stat_t;
+
+/**
+ * @brief spsc_ring_consumer_stat_t is written only by the consumer.
+ */
+typedef struct {
+  uint32_t nb_release;   /**< entries read */
+  uint32_t nb_empty;     /**< calls of spsc_ring_peek with an empty ring */
+  uint32_t nb_sleep;     /**< times spsc_ring_peek_wait slept */
+} spsc_ring_consumer_stat_t;
+
+/**
+ * @brief spsc_ring_t is a bounded ring of fixed size entries, shared by 
+ *        one producer thread and one consumer thread without locks.
+ *
+ *        The entries are used in place (as views, without copy): the 
+ *        producer gets a free entry with spsc_ring_reserve, fills it, and
+ *        publishes it with spsc_ring_commit; the consumer gets the oldest
+ *        entry with spsc_ring_peek, uses it, and gives it back with 
+ *        spsc_ring_release.
+ *
+ *        The indices of each side and their statistics are on separate
+ *        cache lines.
+ *
+ *        A side that waits (spsc_ring_reserve_wait, spsc_ring_peek_wait)
+ *        polls SPSC_RING_NB_POLL times, then sleeps on a condition 
+ *        variable after setting its `*_sleeping` flag; the other side 
+ *        checks the flag after each commit or release and wakes it.
+ */
+typedef struct {
+  _Atomic uint32_t tail;  /**< next entry to write, written by the producer */
+  uint32_t cached_head;   /**< last head seen by the producer */
+  spsc_ring_producer_stat_t producer_stat;
+  uint8_t padding1[SPSC_RING_CACHE_LINE_SIZE];
+
+  _Atomic uint32_t head;  /**< next entry to read, written by the consumer */
+  uint32_t cached_tail;   /**< last tail seen by the consumer */
+  spsc_ring_consumer_stat_t consumer_stat;
+  uint8_t padding2[SPSC_RING_CACHE_LINE_SIZE];
+
+  uint8_t* buffer;        /**< size*entry_size bytes, owned by the caller */
+  uint32_t entry_size;
+  uint32_t size;          /**< number of entries, a power of 2 */
+
+  _Atomic bool producer_sleeping; /**< the producer waits for a release */
+  _Atomic bool consumer_sleeping; /**< the consumer waits for a commit */
+  _Atomic bool is_closed; /**< no more commits, see spsc_ring_close */
+  pthread_mutex_t lock;   /**< only used to sleep and wake */
+  pthread_cond_t wake;
+} spsc_ring_t;
+
+/**
+ * @brief spsc_ring_stat_t gives all the statistics of one ring.
+ */
+typedef struct {
+  spsc_ring_producer_stat_t producer;
+  spsc_ring_consumer_stat_t consumer;
+} spsc_ring_stat_t;
+
+/**
+ * @brief     Initialize a ring (before the threads use it).
+ * @param[in] ring is the ring
+ * @param[in] buffer is the memory of the entries, of size*entry_size bytes
+ *            (e.g. an array of `size` entries)
+ * @param[in] entry_size is the size of one entry in bytes
+ * @param[in] size is the number of entries, a power of 2
+ */
+void spsc_ring_init(spsc_ring_t* ring, void* buffer, uint32_t entry_size,
+		    uint32_t size);
+
+/**
+ * @brief     Producer side: returns the next free entry, or NULL if the ring
+ *            is full. The entry is only visible to the consumer after
+ *            spsc_ring_commit.
+ */
+static inline void* spsc_ring_reserve(spsc_ring_t* ring)
+{
+  uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  if (tail - ring->cached_head == ring->size) {
+    ring->cached_head = atomic_load_explicit(&ring->head, 
+					     memory_order_acquire);
+    if (tail - ring->cached_head == ring->size) {
+      ring->producer_stat.nb_full ++;
+      return NULL;
+    }
+  }
+  return ring->buffer + (tail & (ring->size-1)) * ring->entry_size;
+}
+
+/* slow paths of spsc_ring_reserve_wait and spsc_ring_peek_wait */
+void* spsc_ring_wait_not_full(spsc_ring_t* ring);
+void* spsc_ring_wait_not_empty(spsc_ring_t* ring);
+
+/* wakes the side sleeping on the ring */
+void spsc_ring_wake(spsc_ring_t* ring);
+
+/**
+ * @brief     Producer side: returns the next free entry, waiting while the 
+ *            ring is full (polling, then sleeping until a release).
+ */
+static inline void* spsc_ring_reserve_wait(spsc_ring_t* ring)
+{
+  void* entry = spsc_ring_reserve(ring);
+  if (entry == NULL)
+    entry = spsc_ring_wait_not_full(ring);
+  return entry;
+}
+
+/**
+ * @brief     Producer side: publishes the entry returned by the last
+ *            spsc_ring_reserve.
+ */
+static inline void spsc_ring_commit(spsc_ring_t* ring)
+{
+  uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed) + 1;
+  atomic_store_explicit(&ring->tail, tail, memory_order_release);
+  /* orders the store of tail before the load of the flag, see 
+     spsc_ring_wait_not_empty */
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&ring->consumer_sleeping, memory_order_relaxed))
+    spsc_ring_wake(ring);
+
+  spsc_ring_producer_stat_t* stat = &ring->producer_stat;
+  uint32_t occupancy = tail - ring->cached_head; /* upper bound */
+  uint16_t bucket = 0;
+  while (occupancy >> bucket != 0 && bucket < SPSC_RING_NB_OCCUPANCY_BUCKET-1)
+    bucket ++;
+  stat->nb_commit ++;
+  stat->occupancy_hist[bucket] ++;
+  stat->occupancy_max = MAX(stat->occupancy_max, occupancy);
+}
+
+/**
+ * @brief     Consumer side: returns the oldest entry, or NULL if the ring is
+ *            empty. The entry stays in the ring until spsc_ring_release.
+ */
+static inline void* spsc_ring_peek(spsc_ring_t* ring)
+{
+  uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  if (head == ring->cached_tail) {
+    ring->cached_tail = atomic_load_explicit(&ring->tail, 
+					     memory_order_acquire);
+    if (head == ring->cached_tail) {
+      ring->consumer_stat.nb_empty ++;
+      return NULL;
+    }
+  }
+  return ring->buffer + (head & (ring->size-1)) * ring->entry_size;
+}
+
+/**
+ * @brief     Consumer side: gives back the entry returned by the last
+ *            spsc_ring_peek.
+ */
+static inline void spsc_ring_release(spsc_ring_t* ring)
+{
+  uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  atomic_store_explicit(&ring->head, head+1, memory_order_release);
+  ring->consumer_stat.nb_release ++;
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&ring->producer_sleeping, memory_order_relaxed))
+    spsc_ring_wake(ring);
+}
+
+/**
+ * @brief     Consumer side: returns the oldest entry, waiting while the 
+ *            ring is empty (polling, then sleeping until a commit); or NULL
+ *            when the ring is empty and closed.
+ */
+static inline void* spsc_ring_peek_wait(spsc_ring_t* ring)
+{
+  void* entry = spsc_ring_peek(ring);
+  if (entry == NULL)
+    entry = spsc_ring_wait_not_empty(ring);
+  return entry;
+}
+
+/**
+ * @brief     Producer side: tells the consumer that nothing more will be 
+ *            committed; spsc_ring_peek_wait returns NULL once the ring is 
+ *            empty.
+ */
+void spsc_ring_close(spsc_ring_t* ring);
+
+/**
+ * @brief     Returns the number of entries in the ring (exact only when 
+ *            called from one side while the other one is inactive).
+ */
+static inline uint32_t spsc_ring_get_occupancy(spsc_ring_t* ring)
+{ 
+  return atomic_load_explicit(&ring->tail, memory_order_acquire)
+    - atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+/**
+ * @brief     Copy the statistics of both sides of a ring (consistent only
+ *            when both threads are stopped, e.g. joined).
+ */
+void spsc_ring_get_stat(spsc_ring_t* ring, spsc_ring_stat_t* stat);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void spsc_ring_stat_pywrite(FILE* out, spsc_ring_stat_t* stat);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPSC_RING_H__ */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,200 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Execution of payload programs on stripes of the payloads, by
+ *          several threads
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "general.h"
+#include "stripe-pool.h"
+
+#if defined(CONF_WITH_PTHREAD) && defined(CONF_WITH_PAYLOAD_PROGRAM)
+
+/*---------------------------------------------------------------------------*/
+
+/* execute a program on all its stripes, in the calling thread */
+static void stripe_pool_run_inline(stripe_pool_t* pool,
+				   payload_program_t* program)
+{
+  uint32_t start;
+  for (start=0; start<program->max_size; start+=pool->stripe_size)
+    payload_program_execute(program, start,
+			    MIN(start + pool->stripe_size, program->max_size));
+}
+
+/* execute the current program on stripes until there are none left */
+static void stripe_pool_run_stripes(stripe_pool_t* pool)
+{
+  payload_program_t* program = pool->program;
+  for (;;) {
+    uint32_t stripe = atomic_fetch_add_explicit(&pool->next_stripe, 1,
+						memory_order_relaxed);
+    if (stripe >= pool->nb_stripe)
+      break;
+    uint32_t start = stripe * pool->stripe_size;
+    uint32_t end = MIN(start + pool->stripe_size, program->max_size);
+    payload_program_execute(program, start, end);
+  }
+}
+
+static void* stripe_pool_run(void* arg)
+{
+  stripe_pool_t* pool = arg;
+  uint32_t generation = 0;
+  pthread_mutex_lock(&pool->mutex);
+  for (;;) {
+    while (pool->generation == generation && !pool->is_stopping)
+      pthread_cond_wait(&pool->start_cond, &pool->mutex);
+    if (pool->is_stopping)
+      break;
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->mutex);
+
+    stripe_pool_run_stripes(pool);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->nb_running --;
+    if (pool->nb_running == 0)
+      pthread_cond_signal(&pool->done_cond);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+bool stripe_pool_start(stripe_pool_t* pool, uint16_t nb_thread,
+		       uint16_t stripe_size)
+{
+  uint16_t i;
+  REQUIRE( nb_thread <= STRIPE_POOL_MAX_THREAD );
+  REQUIRE( stripe_size > 0 );
+  pool->nb_thread = 0;
+  pool->stripe_size = stripe_size;
+  pool->min_parallel_size = STRIPE_POOL_MIN_PARALLEL_SIZE;
+  pool->generation = 0;
+  pool->nb_running = 0;
+  pool->is_stopping = false;
+  pool->program = NULL;
+  pool->nb_stripe = 0;
+  atomic_init(&pool->next_stripe, 0);
+  memset(&pool->stat, 0, sizeof(pool->stat));
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->start_cond, NULL);
+  pthread_cond_init(&pool->done_cond, NULL);
+
+  for (i=0; i<nb_thread; i++) {
+    if (pthread_create(&pool->thread[i], NULL, stripe_pool_run, pool) != 0) {
+      WARN("cannot start stripe pool thread %u", i);
+      stripe_pool_stop(pool);
+      return false;
+    }
+    pool->nb_thread ++;
+  }
+  return true;
+}
+
+void stripe_pool_execute(void* pool_ptr, payload_program_t* program)
+{
+  stripe_pool_t* pool = pool_ptr;
+  pool->stat.nb_program ++;
+  pool->stat.nb_op += program->nb_op;
+  uint32_t nb_stripe = (program->max_size + pool->stripe_size - 1)
+    / pool->stripe_size;
+  if (pool->nb_thread == 0 || nb_stripe <= 1
+      || (uint32_t)program->nb_op * program->max_size 
+      < pool->min_parallel_size) {
+    stripe_pool_run_inline(pool, program);
+    return;
+  }
+  pool->stat.nb_parallel ++;
+  pool->stat.nb_stripe += nb_stripe;
+
+  /* the mutex orders the program before its execution by the threads,
+     and the execution by the threads before the return */
+  pthread_mutex_lock(&pool->mutex);
+  pool->program = program;
+  pool->nb_stripe = nb_stripe;
+  atomic_store_explicit(&pool->next_stripe, 0, memory_order_relaxed);
+  pool->nb_running = pool->nb_thread;
+  pool->generation ++;
+  pthread_cond_broadcast(&pool->start_cond);
+  pthread_mutex_unlock(&pool->mutex);
+
+  stripe_pool_run_stripes(pool);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->nb_running > 0)
+    pthread_cond_wait(&pool->done_cond, &pool->mutex);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+void stripe_pool_stop(stripe_pool_t* pool)
+{
+  uint16_t i;
+  pthread_mutex_lock(&pool->mutex);
+  pool->is_stopping = true;
+  pthread_cond_broadcast(&pool->start_cond);
+  pthread_mutex_unlock(&pool->mutex);
+  for (i=0; i<pool->nb_thread; i++)
+    pthread_join(pool->thread[i], NULL);
+  pool->nb_thread = 0;
+  pthread_cond_destroy(&pool->done_cond);
+  pthread_cond_destroy(&pool->start_cond);
+  pthread_mutex_destroy(&pool->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void stripe_pool_pywrite(FILE* out, stripe_pool_t* pool)
+{
+  fprintf(out, "{ 'type':'stripe-pool'");
+  fprintf(out, ", 'nbThread':%u", pool->nb_thread);
+  fprintf(out, ", 'stripeSize':%u", pool->stripe_size);
+  fprintf(out, ", 'minParallelSize':%u", pool->min_parallel_size);
+  fprintf(out, ", 'nbProgram':%u", pool->stat.nb_program);
+  fprintf(out, ", 'nbParallel':%u", pool->stat.nb_parallel);
+  fprintf(out, ", 'nbOp':%u", pool->stat.nb_op);
+  fprintf(out, ", 'nbStripe':%u", pool->stat.nb_stripe);
+  fprintf(out, " }");
+}
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD && CONF_WITH_PAYLOAD_PROGRAM */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
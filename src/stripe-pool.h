@@ -0,0 +1,172 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @defgroup    LibLC    Linear Coding Library
+ * @ingroup     liblc
+ * @brief       linear coding and decoding of packets.
+ * @{
+ *
+ * @file
+ * @brief   Execution of payload programs on stripes of the payloads, by
+ *          several threads
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ */
+
+#ifndef __STRIPE_POOL_H__
+#define __STRIPE_POOL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#include "coded-packet.h"
+
+#if defined(CONF_WITH_PTHREAD) && defined(CONF_WITH_PAYLOAD_PROGRAM)
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*---------------------------------------------------------------------------*/
+
+/* Maximum number of threads of a pool */
+#ifdef CONF_STRIPE_POOL_MAX_THREAD
+#define STRIPE_POOL_MAX_THREAD CONF_STRIPE_POOL_MAX_THREAD
+#else /* CONF_STRIPE_POOL_MAX_THREAD */
+#define STRIPE_POOL_MAX_THREAD 8
+#endif /* CONF_STRIPE_POOL_MAX_THREAD */
+
+/* Default size of a stripe in bytes: the stripes of all the packets of 
+   a program should fit in the cache of one core */
+#ifdef CONF_STRIPE_POOL_STRIPE_SIZE
+#define STRIPE_POOL_STRIPE_SIZE CONF_STRIPE_POOL_STRIPE_SIZE
+#else /* CONF_STRIPE_POOL_STRIPE_SIZE */
+#define STRIPE_POOL_STRIPE_SIZE 1024
+#endif /* CONF_STRIPE_POOL_STRIPE_SIZE */
+
+/* Minimum work of a program (operations x payload size, in bytes) for its
+   stripes to be shared with the threads: smaller programs are executed by
+   the calling thread alone, as starting the threads and waiting for them
+   (a mutex and two condition variables) would cost more than it saves */
+#ifdef CONF_STRIPE_POOL_MIN_PARALLEL_SIZE
+#define STRIPE_POOL_MIN_PARALLEL_SIZE CONF_STRIPE_POOL_MIN_PARALLEL_SIZE
+#else /* CONF_STRIPE_POOL_MIN_PARALLEL_SIZE */
+#define STRIPE_POOL_MIN_PARALLEL_SIZE (64*1024)
+#endif /* CONF_STRIPE_POOL_MIN_PARALLEL_SIZE */
+
+/**
+ * @brief stripe_pool_stat_t gives statistics about a pool.
+ */
+typedef struct {
+  uint32_t nb_program;    /**< executed programs */
+  uint32_t nb_parallel;   /**< programs executed by the threads of the pool */
+  uint32_t nb_op;         /**< operations of all the programs */
+  uint32_t nb_stripe;     /**< stripes of the programs executed in parallel */
+} stripe_pool_stat_t;
+
+/**
+ * @brief stripe_pool_t is a small pool of threads executing payload
+ *        programs (payload_program_t): the payloads are split in stripes of
+ *        `stripe_size` bytes, and the threads (and the calling thread) 
+ *        execute the whole program on different stripes, taken in turn.
+ *
+ *        A pool executes one program at a time: it is used by one 
+ *        decoding thread (e.g. for the packet sets of that thread).
+ *
+ *        The threads are optional: with `0` threads, the calling thread 
+ *        executes the program stripe by stripe, which keeps the payloads
+ *        in its cache. The threads only help for programs of at least 
+ *        `min_parallel_size` bytes of work, with idle cores.
+ */
+typedef struct {
+  pthread_t thread[STRIPE_POOL_MAX_THREAD];
+  uint16_t nb_thread;
+  uint16_t stripe_size;
+  uint32_t min_parallel_size; /**< STRIPE_POOL_MIN_PARALLEL_SIZE by default */
+
+  pthread_mutex_t mutex;
+  pthread_cond_t start_cond; /**< a new program, or stopping */
+  pthread_cond_t done_cond;  /**< all threads have finished the program */
+  uint32_t generation;       /**< incremented for each program */
+  uint16_t nb_running;       /**< threads still executing the program */
+  bool is_stopping;
+
+  payload_program_t* program;   /**< the current program */
+  uint32_t nb_stripe;
+  _Atomic uint32_t next_stripe; /**< next stripe to execute */
+
+  stripe_pool_stat_t stat;
+} stripe_pool_t;
+
+/**
+ * @brief     Start the threads of a pool.
+ * @param[in] pool is the pool
+ * @param[in] nb_thread is the number of threads of the pool, in addition to
+ *            the calling thread (`0` executes everything in the calling 
+ *            thread)
+ * @param[in] stripe_size is the size of the stripes in bytes (e.g. 
+ *            STRIPE_POOL_STRIPE_SIZE)
+ * @return    true on success, false if the threads could not be started.
+ */
+bool stripe_pool_start(stripe_pool_t* pool, uint16_t nb_thread,
+		       uint16_t stripe_size);
+
+/**
+ * @brief     Execute a payload program, returning when it is finished. 
+ *            Programs spanning only one stripe, or with less work than
+ *            `min_parallel_size`, are executed by the calling thread 
+ *            alone (still stripe by stripe).
+ * @param[in] pool is the pool (as a `void*`, so that it can be given to
+ *            packet_set_set_payload_executor)
+ * @param[in] program is the program
+ */
+void stripe_pool_execute(void* pool, payload_program_t* program);
+
+/**
+ * @brief     Stop the threads of a pool.
+ */
+void stripe_pool_stop(stripe_pool_t* pool);
+
+/*---------------------------------------------------------------------------*/
+
+#ifdef CONF_WITH_FPRINTF
+
+void stripe_pool_pywrite(FILE* out, stripe_pool_t* pool);
+
+#endif /* CONF_WITH_FPRINTF */
+
+/*---------------------------------------------------------------------------*/
+
+#endif /* CONF_WITH_PTHREAD && CONF_WITH_PAYLOAD_PROGRAM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STRIPE_POOL_H__ */
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,218 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the block decoder, with the block encoder and with random
+ *          coding of large generations
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "block-encoder.h"
+#include "block-decoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define MAX_K BLOCK_DECODER_MAX_K
+#define MAX_DATA_SIZE 64
+
+#define K 8
+#define M 4
+#define DATA_SIZE 40
+#define COEF_POS_BASE 100
+
+uint8_t source_table[MAX_K][MAX_DATA_SIZE];
+uint8_t result[MAX_K][MAX_DATA_SIZE];
+uint8_t* source_ptr_table[MAX_K];
+uint8_t* result_ptr_table[MAX_K];
+uint8_t coef_table[MAX_K];
+uint8_t coef_vector[MAX_K];
+uint8_t coded_data[MAX_DATA_SIZE];
+block_decoder_t decoder;
+void* memory;
+unsigned int nb_error = 0;
+
+static void check_result(uint16_t k, uint16_t data_size, char* name)
+{
+  uint16_t j;
+  for (j=0; j<k; j++)
+    if (memcmp(result[j], source_table[j], data_size) != 0) {
+      fprintf(stdout, "ERROR: %s: bad decoded packet %u\n", name, j);
+      nb_error ++;
+      return;
+    }
+}
+
+/* every set of K packets among the K+M ones of a block_encoder_t must 
+   decode the block */
+static void test_block_encoder(uint8_t l)
+{
+  block_encoder_t encoder;
+  coded_packet_t repair_table[M];
+  uint32_t mask;
+  uint16_t i, nb_test = 0;
+
+  if (!block_encoder_init(&encoder, l, K, M)) {
+    fprintf(stdout, "ERROR: GF(%u) K=%u M=%u not supported\n", 
+	    1<<(1<<l), K, M);
+    nb_error ++;
+    return;
+  }
+  block_encoder_generate(&encoder, COEF_POS_BASE, source_ptr_table, DATA_SIZE,
+			 repair_table);
+
+  for (mask=0; mask < (1u<<(K+M)); mask++) {
+    if (__builtin_popcount(mask) != K)
+      continue;
+    block_decoder_init(&decoder, l, K, DATA_SIZE, memory, 
+		       block_decoder_get_memory_size(K, DATA_SIZE));
+    for (i=0; i<K+M; i++) {
+      if ((mask & (1u<<i)) == 0)
+	continue;
+      coded_packet_t pkt;
+      if (i < K)
+	coded_packet_init_from_base_packet(&pkt, l, COEF_POS_BASE+i,
+					   source_table[i], DATA_SIZE);
+      else coded_packet_copy_from(&pkt, &repair_table[i-K]);
+      if (!block_decoder_add_coded_packet(&decoder, COEF_POS_BASE, &pkt)) {
+	fprintf(stdout, "ERROR: GF(%u) mask 0x%x: packet %u not innovative\n",
+		1<<(1<<l), mask, i);
+	nb_error ++;
+      }
+    }
+    if (!block_decoder_is_complete(&decoder)) {
+      fprintf(stdout, "ERROR: GF(%u) mask 0x%x: not complete\n",
+	      1<<(1<<l), mask);
+      nb_error ++;
+      continue;
+    }
+    block_decoder_decode(&decoder, result_ptr_table);
+    check_result(K, DATA_SIZE, "block encoder");
+    nb_test ++;
+  }
+  fprintf(stdout, "GF(%u) K=%u M=%u: %u erasure patterns\n", 1<<(1<<l), 
+	  K, M, nb_test);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* random linear coding of sources with random sizes (padded with zeros),
+   the first ones sent uncoded, and one duplicate packet */
+static void test_random(uint8_t l, uint16_t k, uint16_t data_size)
+{
+  uint16_t vector_size = ((k << l) + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+  uint16_t i, j, nb_sent = 0, nb_innovative = 0;
+
+  for (i=0; i<k; i++) {
+    uint16_t size = 1 + rand() % data_size;
+    for (j=0; j<data_size; j++)
+      source_table[i][j] = (j < size) ? rand() & 0xff : 0;
+  }
+  REQUIRE( block_decoder_init(&decoder, l, k, data_size, memory,
+			      block_decoder_get_memory_size(k, data_size)) );
+
+  while (!block_decoder_is_complete(&decoder) && nb_sent < 2*k + 20) {
+    bool is_duplicate = (nb_sent == k/2 + 1);
+    if (!is_duplicate) {
+      for (j=0; j<k; j++) {
+	if (nb_sent < k/2)
+	  coef_table[j] = (j == nb_sent);
+	else coef_table[j] = (rand() >> 8) & MASK(1<<l); /* (the low bit of 
+							      rand() is linear) */
+      }
+      memset(coef_vector, 0, vector_size);
+      for (j=0; j<k; j++)
+	lc_vector_set(coef_vector, vector_size, l, j, coef_table[j]);
+      lc_vector_linear_combination(coef_table, source_ptr_table, k,
+				   data_size, l, coded_data);
+    }
+    bool is_innovative = block_decoder_add(&decoder, coef_vector, coded_data,
+					   data_size);
+    if (is_duplicate && is_innovative) {
+      fprintf(stdout, "ERROR: GF(%u) K=%u: duplicate packet is innovative\n",
+	      1<<(1<<l), k);
+      nb_error ++;
+    }
+    nb_innovative += is_innovative;
+    nb_sent ++;
+  }
+  if (!block_decoder_is_complete(&decoder) || nb_innovative != k) {
+    fprintf(stdout, "ERROR: GF(%u) K=%u: rank %u after %u packets\n",
+	    1<<(1<<l), k, decoder.nb_row, nb_sent);
+    nb_error ++;
+    return;
+  }
+  block_decoder_decode(&decoder, result_ptr_table);
+  check_result(k, data_size, "random");
+  fprintf(stdout, "GF(%u) K=%u: %u packets, ", 1<<(1<<l), k, nb_sent);
+  block_decoder_pywrite(stdout, &decoder);
+  fprintf(stdout, "\n");
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+  uint16_t i, j;
+  uint8_t l;
+  srand(1);
+  memory = malloc(block_decoder_get_memory_size(MAX_K, MAX_DATA_SIZE));
+  REQUIRE( memory != NULL );
+  for (i=0; i<MAX_K; i++) {
+    for (j=0; j<MAX_DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+    source_ptr_table[i] = source_table[i];
+    result_ptr_table[i] = result[i];
+  }
+
+  test_block_encoder(2);
+  test_block_encoder(3);
+
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_random(l, 1, MAX_DATA_SIZE);
+    test_random(l, 37, MAX_DATA_SIZE);
+    test_random(l, 256, 17);
+  }
+  test_random(0, MAX_K, 8);
+
+  free(memory);
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,133 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the MDS property of the block encoder
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "block-encoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define K MIN(MAX_CODED_PACKET-1, 8)
+#define M 4
+#define DATA_SIZE 40
+#define COEF_POS_BASE 100
+
+uint8_t source_table[K][DATA_SIZE];
+unsigned int nb_decoded;
+unsigned int nb_error = 0;
+
+static void check_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint16_t j = pkt->coef_pos_min - COEF_POS_BASE;
+  if (j >= K || memcmp(coded_packet_data(pkt), source_table[j], DATA_SIZE)
+      != 0) {
+    fprintf(stdout, "ERROR: bad decoded packet %u\n", j);
+    nb_error ++;
+  }
+  nb_decoded ++;
+}
+
+/* every set of K packets among the K+M ones must decode the block */
+static void test_block(uint8_t l)
+{
+  block_encoder_t encoder;
+  coded_packet_t repair_table[M];
+  uint8_t* data_table[K];
+  uint32_t mask;
+  uint16_t i, nb_test = 0;
+
+  if (!block_encoder_init(&encoder, l, K, M)) {
+    fprintf(stdout, "ERROR: GF(%u) K=%u M=%u not supported\n", 
+	    1<<(1<<l), K, M);
+    nb_error ++;
+    return;
+  }
+  for (i=0; i<K; i++)
+    data_table[i] = source_table[i];
+  block_encoder_generate(&encoder, COEF_POS_BASE, data_table, DATA_SIZE,
+			 repair_table);
+
+  for (mask=0; mask < (1u<<(K+M)); mask++) {
+    if (__builtin_popcount(mask) != K)
+      continue;
+    packet_set_t set;
+    packet_set_init(&set, l, check_decoded, NULL, NULL, NULL);
+    nb_decoded = 0;
+    for (i=0; i<K+M; i++) {
+      if ((mask & (1u<<i)) == 0)
+	continue;
+      coded_packet_t pkt;
+      if (i < K)
+	coded_packet_init_from_base_packet(&pkt, l, COEF_POS_BASE+i,
+					   source_table[i], DATA_SIZE);
+      else coded_packet_copy_from(&pkt, &repair_table[i-K]);
+      packet_set_add(&set, &pkt, NULL, false);
+    }
+    if (nb_decoded != K) {
+      fprintf(stdout, "ERROR: GF(%u) mask 0x%x: %u/%u decoded\n",
+	      1<<(1<<l), mask, nb_decoded, K);
+      nb_error ++;
+    }
+    nb_test ++;
+  }
+  fprintf(stdout, "GF(%u) K=%u M=%u: %u erasure patterns\n", 1<<(1<<l), 
+	  K, M, nb_test);
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t i, j;
+  srand(1);
+  for (i=0; i<K; i++)
+    for (j=0; j<DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+
+  test_block(2);
+  test_block(3);
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
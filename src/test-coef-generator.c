@@ -0,0 +1,177 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the generator of random coefficients
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "linear-code.h"
+#include "coef-generator.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_COEF 1000
+#define NB_DRAW 64
+
+unsigned int nb_error = 0;
+
+static void test_fill(uint8_t l, uint8_t flags)
+{
+  coef_generator_t generator, generator2;
+  uint8_t coef_table[NB_COEF], coef_table2[NB_COEF];
+  unsigned int count[256];
+  uint16_t nb_value = 1<<(1<<l);
+  uint16_t i, nb_coef;
+
+  coef_generator_init(&generator, 12345);
+  coef_generator_init(&generator2, 12345);
+  memset(count, 0, sizeof(count));
+  for (nb_coef=1; nb_coef<NB_DRAW; nb_coef++) {
+    coef_generator_fill(&generator, l, coef_table, nb_coef, flags);
+    coef_generator_fill(&generator2, l, coef_table2, nb_coef, flags);
+    if (memcmp(coef_table, coef_table2, nb_coef) != 0) {
+      fprintf(stdout, "ERROR: GF(%u) not reproducible\n", nb_value);
+      nb_error ++;
+    }
+    if ((flags & COEF_GENERATOR_LEADING_NONZERO) != 0
+	&& coef_table[nb_coef-1] == 0) {
+      fprintf(stdout, "ERROR: GF(%u) leading coefficient is 0\n", nb_value);
+      nb_error ++;
+    }
+    for (i=0; i<nb_coef; i++) {
+      if (coef_table[i] >= nb_value
+	  || ((flags & COEF_GENERATOR_NONZERO) != 0 && coef_table[i] == 0)) {
+	fprintf(stdout, "ERROR: GF(%u) bad coefficient %u\n", nb_value,
+		coef_table[i]);
+	nb_error ++;
+      }
+      count[coef_table[i]] ++;
+    }
+  }
+
+  /* coarse uniformity check */
+  unsigned int total = (NB_DRAW-1)*NB_DRAW/2;
+  uint16_t nb_expected = nb_value - ((flags & COEF_GENERATOR_NONZERO) != 0);
+  for (i=((flags & COEF_GENERATOR_NONZERO) != 0); i<nb_value; i++)
+    if (nb_value > 2 && nb_expected <= 16
+	&& (count[i] < total/nb_expected/2 || count[i] > 2*total/nb_expected)){
+      fprintf(stdout, "ERROR: GF(%u) coefficient %u appears %u times\n",
+	      nb_value, i, count[i]);
+      nb_error ++;
+    }
+}
+
+static void test_get_coef(uint8_t l)
+{
+  coef_generator_t generator, generator2;
+  uint32_t i;
+  unsigned int nb_same = 0;
+
+  coef_generator_init_stream(&generator, 777, 1);
+  coef_generator_init_stream(&generator2, 777, 2);
+  for (i=0; i<NB_COEF; i++) {
+    uint8_t coef = coef_generator_get_coef(777, i, l, COEF_GENERATOR_NONZERO);
+    if (coef == 0 || coef != coef_generator_get_coef(777, i, l, 
+						     COEF_GENERATOR_NONZERO)) {
+      fprintf(stdout, "ERROR: GF(%u) bad counter-based coefficient\n",
+	      1<<(1<<l));
+      nb_error ++;
+    }
+    nb_same += (coef_generator_next(&generator) 
+		== coef_generator_next(&generator2));
+  }
+  if (nb_same > 1) {
+    fprintf(stdout, "ERROR: streams 1 and 2 are not independent\n");
+    nb_error ++;
+  }
+}
+
+/* coef_generator_fill_packet gives the coefficients of coef_generator_fill,
+   from any first source index (aligned on a byte of the header or not, and
+   wrapping around its window) */
+static void test_fill_packet(uint8_t l, uint8_t flags)
+{
+  coef_generator_t generator, generator2;
+  uint8_t coef_table[NB_COEF];
+  coded_packet_t pkt;
+  uint16_t window = 1<<log2_window_size(l);
+  uint16_t coef_pos_min, nb_coef, i;
+
+  for (coef_pos_min=0; coef_pos_min<2*window; coef_pos_min+=7)
+    for (nb_coef=1; nb_coef<=window; nb_coef+=nb_coef/2+1) {
+      coef_generator_init(&generator, coef_pos_min);
+      coef_generator_init(&generator2, coef_pos_min);
+      coef_generator_fill(&generator, l, coef_table, nb_coef, flags);
+      coded_packet_init(&pkt, l);
+      coef_generator_fill_packet(&generator2, &pkt, coef_pos_min, nb_coef,
+				 flags);
+      for (i=0; i<nb_coef; i++)
+	if (coded_packet_get_coef(&pkt, coef_pos_min+i) != coef_table[i])
+	  break;
+      if (i < nb_coef
+	  || coef_generator_next(&generator) != coef_generator_next
+	  (&generator2)) {
+	fprintf(stdout, "ERROR: GF(%u) packed coefficients differ (%u+%u)\n",
+		1<<(1<<l), coef_pos_min, nb_coef);
+	nb_error ++;
+	return;
+      }
+    }
+}
+
+int main(int argc, char** argv)
+{
+  uint8_t l;
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_fill(l, 0);
+    test_fill(l, COEF_GENERATOR_NONZERO);
+    test_fill(l, COEF_GENERATOR_LEADING_NONZERO);
+    test_fill_packet(l, 0);
+    test_fill_packet(l, COEF_GENERATOR_NONZERO);
+    test_fill_packet(l, COEF_GENERATOR_LEADING_NONZERO);
+    test_get_coef(l);
+  }
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  fprintf(stdout, "ok\n");
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,170 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the decoding of flows in a separate thread
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "decode-pipeline.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 300
+#define DATA_SIZE 32
+#define NB_FLOW 4
+#define WINDOW(l) MIN(MAX_CODED_PACKET-1, 1<<log2_window_size(l))
+
+/* the set of a flow relies on its own store of decoded packets */
+#if DECODED_STORE_SIZE > 0
+#define FLOW_WINDOW(l) MIN(WINDOW(l), DECODED_STORE_SIZE)
+#else /* DECODED_STORE_SIZE > 0 */
+#define FLOW_WINDOW(l) WINDOW(l)
+#endif /* DECODED_STORE_SIZE > 0 */
+
+decode_pipeline_t pipeline;
+uint16_t nb_decoded_table[NB_FLOW];
+unsigned int nb_error = 0;
+
+/* the content of each source packet depends on its flow id */
+static void make_source(uint32_t flow_id, uint16_t coef_pos, uint8_t* data)
+{
+  uint16_t j;
+  for (j=0; j<DATA_SIZE; j++)
+    data[j] = (flow_id*131 + coef_pos*7 + j*j) & 0xff;
+}
+
+static void check_decoded(void* data, decode_pipeline_entry_t* entry)
+{
+  uint8_t source[DATA_SIZE];
+  (void)data;
+  make_source(entry->flow_id, entry->pkt.coef_pos_min, source);
+  if (entry->flow_id >= NB_FLOW
+      || memcmp(coded_packet_data(&entry->pkt), source, DATA_SIZE) != 0) {
+    fprintf(stdout, "ERROR: bad decoded packet %u of flow %u\n",
+	    entry->pkt.coef_pos_min, entry->flow_id);
+    nb_error ++;
+    return;
+  }
+  nb_decoded_table[entry->flow_id] ++;
+}
+
+static void read_decoded(void)
+{
+  decode_pipeline_entry_t* entry;
+  while ((entry = decode_pipeline_peek_decoded(&pipeline)) != NULL) {
+    check_decoded(NULL, entry);
+    decode_pipeline_release_decoded(&pipeline);
+  }
+}
+
+/* the coded packet is built in place, in the entry of the ring */
+static void make_combination(coded_packet_t* pkt, uint8_t l, uint32_t flow_id,
+			     uint16_t first, uint16_t last)
+{
+  uint8_t coef_max = (1<<(1<<l))-1;
+  uint8_t data[DATA_SIZE];
+  uint16_t i;
+  coded_packet_init(pkt, l);
+  for (i=first; i<=last; i++) {
+    uint8_t coef = (i == last) ? 1 + rand()%coef_max : rand()%(coef_max+1);
+    if (coef == 0)
+      continue;
+    coded_packet_t src;
+    make_source(flow_id, i, data);
+    coded_packet_init_from_base_packet(&src, l, i, data, DATA_SIZE);
+    coded_packet_add_mult(pkt, coef, &src);
+  }
+}
+
+static void test_pipeline(uint8_t l)
+{
+  uint32_t nb_packet = 0;
+  uint16_t i, f;
+
+  memset(nb_decoded_table, 0, sizeof(nb_decoded_table));
+  if (!decode_pipeline_start(&pipeline, l, NB_SOURCE)) {
+    fprintf(stdout, "ERROR: cannot start the pipeline\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i=0; i<NB_SOURCE; i++)
+    for (f=0; f<NB_FLOW; f++) {
+      uint16_t first = (i >= FLOW_WINDOW(l)-1) ? i-(FLOW_WINDOW(l)-1) : 0;
+      decode_pipeline_entry_t* entry;
+      while ((entry = decode_pipeline_reserve(&pipeline)) == NULL)
+	read_decoded();
+      entry->flow_id = f;
+      entry->now = i;
+      make_combination(&entry->pkt, l, f, first, i);
+      decode_pipeline_commit(&pipeline);
+      nb_packet ++;
+      read_decoded();
+    }
+  decode_pipeline_stop(&pipeline, check_decoded, NULL);
+
+  for (f=0; f<NB_FLOW; f++)
+    if (nb_decoded_table[f] != NB_SOURCE) {
+      fprintf(stdout, "ERROR: GF(%u) flow %u: %u/%u decoded\n", 1<<(1<<l),
+	      f, nb_decoded_table[f], NB_SOURCE);
+      nb_error ++;
+    }
+  spsc_ring_stat_t stat;
+  spsc_ring_get_stat(&pipeline.packet_ring, &stat);
+  if (stat.producer.nb_commit != nb_packet 
+      || stat.consumer.nb_release != nb_packet
+      || pipeline.decoded_ring.producer_stat.nb_commit
+      != NB_FLOW*NB_SOURCE) {
+    fprintf(stdout, "ERROR: unexpected statistics of the rings\n");
+    nb_error ++;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  uint8_t l;
+  srand(1);
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++)
+    test_pipeline(l);
+  decode_pipeline_pywrite(stdout, &pipeline);
+  fprintf(stdout, "\n");
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
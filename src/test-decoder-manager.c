@@ -0,0 +1,220 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the decoding of several flows with a decoder manager
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "decoder-manager.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 100
+#define DATA_SIZE 32
+#define NB_FLOW 6
+#define POOL_SIZE 300
+#define WINDOW(l) MIN(MAX_CODED_PACKET-1, 1<<log2_window_size(l))
+
+/* the sets rely on their own store of decoded packets */
+#if DECODED_STORE_SIZE > 0
+#define FLOW_WINDOW(l) MIN(WINDOW(l), DECODED_STORE_SIZE)
+#else /* DECODED_STORE_SIZE > 0 */
+#define FLOW_WINDOW(l) WINDOW(l)
+#endif /* DECODED_STORE_SIZE > 0 */
+
+decoder_flow_t flow_table[POOL_SIZE];
+uint16_t nb_decoded_table[NB_FLOW];
+unsigned int nb_error = 0;
+
+/* the content of each source packet depends on its flow id */
+static void make_source(uint32_t flow_id, uint16_t coef_pos, uint8_t* data)
+{
+  uint16_t j;
+  for (j=0; j<DATA_SIZE; j++)
+    data[j] = (flow_id*131 + coef_pos*7 + j*j) & 0xff;
+}
+
+static void check_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  uint8_t data[DATA_SIZE];
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint32_t flow_id = decoder_manager_get_flow_id(set);
+  make_source(flow_id, pkt->coef_pos_min, data);
+  if (flow_id >= NB_FLOW
+      || memcmp(coded_packet_data(pkt), data, DATA_SIZE) != 0) {
+    fprintf(stdout, "ERROR: bad decoded packet %u of flow %u\n",
+	    pkt->coef_pos_min, flow_id);
+    nb_error ++;
+    return;
+  }
+  nb_decoded_table[flow_id] ++;
+}
+
+static void make_combination(coded_packet_t* pkt, uint8_t l, uint32_t flow_id,
+			     uint16_t first, uint16_t last)
+{
+  uint8_t coef_max = (1<<(1<<l))-1;
+  uint8_t data[DATA_SIZE];
+  uint16_t i;
+  coded_packet_init(pkt, l);
+  for (i=first; i<=last; i++) {
+    uint8_t coef = (i == last) ? 1 + rand()%coef_max : rand()%(coef_max+1);
+    if (coef == 0)
+      continue;
+    coded_packet_t src;
+    make_source(flow_id, i, data);
+    coded_packet_init_from_base_packet(&src, l, i, data, DATA_SIZE);
+    coded_packet_add_mult(pkt, coef, &src);
+  }
+}
+
+/* the packets of the flows are interleaved */
+static void test_decoding(uint8_t l)
+{
+  decoder_manager_t manager;
+  coded_packet_t pkt;
+  uint16_t i, f;
+
+  memset(nb_decoded_table, 0, sizeof(nb_decoded_table));
+  decoder_manager_init(&manager, flow_table, NB_FLOW+2, 100, l,
+		       check_decoded, packet_set_free_decoded, NULL, NULL);
+  for (i=0; i<NB_SOURCE; i++)
+    for (f=0; f<NB_FLOW; f++) {
+      uint16_t first = (i >= FLOW_WINDOW(l)-1) ? i-(FLOW_WINDOW(l)-1) : 0;
+      make_combination(&pkt, l, f, first, i);
+      decoder_manager_add(&manager, f, i, &pkt, NULL);
+    }
+
+  for (f=0; f<NB_FLOW; f++)
+    if (nb_decoded_table[f] != NB_SOURCE) {
+      fprintf(stdout, "ERROR: GF(%u) flow %u: %u/%u decoded\n", 1<<(1<<l),
+	      f, nb_decoded_table[f], NB_SOURCE);
+      nb_error ++;
+    }
+  if (manager.stat.nb_created != NB_FLOW || manager.stat.nb_evicted_lru != 0
+      || manager.stat.nb_hit != NB_FLOW*(NB_SOURCE-1)) {
+    fprintf(stdout, "ERROR: unexpected statistics of the manager\n");
+    nb_error ++;
+  }
+}
+
+/* the least recently used flow is evicted when the pool is full,
+   idle flows are evicted by decoder_manager_evict_idle */
+static void test_eviction(void)
+{
+  decoder_manager_t manager;
+  uint32_t f;
+
+  decoder_manager_init(&manager, flow_table, 4, 10, 0, NULL, NULL, NULL, NULL);
+  for (f=0; f<4; f++)
+    decoder_manager_get_set(&manager, f, 0, true);
+  decoder_manager_get_set(&manager, 0, 5, true);
+  decoder_manager_get_set(&manager, 4, 8, true);
+  if (decoder_manager_get_set(&manager, 1, 8, false) != NULL
+      || decoder_manager_get_set(&manager, 0, 8, false) == NULL
+      || manager.stat.nb_evicted_lru != 1) {
+    fprintf(stdout, "ERROR: least recently used flow not evicted\n");
+    nb_error ++;
+  }
+
+  /* flows 2 and 3 were used at time 0, flow 4 at 8, flow 0 at 8 */
+  if (decoder_manager_evict_idle(&manager, 15) != 2
+      || decoder_manager_get_set(&manager, 2, 15, false) != NULL
+      || decoder_manager_get_set(&manager, 4, 15, false) == NULL) {
+    fprintf(stdout, "ERROR: idle flows not evicted\n");
+    nb_error ++;
+  }
+
+  if (!decoder_manager_remove(&manager, 0)
+      || decoder_manager_remove(&manager, 0)
+      || !decoder_manager_remove(&manager, 4)
+      || manager.stat.nb_active != 0 || manager.lru_first != FLOW_INDEX_NONE) {
+    fprintf(stdout, "ERROR: flows not removed\n");
+    nb_error ++;
+  }
+}
+
+/* more flows than hash buckets */
+static void test_lookup(void)
+{
+  decoder_manager_t manager;
+  uint32_t flow_id_table[POOL_SIZE];
+  uint16_t i;
+
+  decoder_manager_init(&manager, flow_table, POOL_SIZE, 10, 0,
+		       NULL, NULL, NULL, NULL);
+  for (i=0; i<POOL_SIZE; i++) {
+    flow_id_table[i] = (i%2 == 0) ? i*DECODER_MANAGER_NB_BUCKET : rand();
+    decoder_manager_get_set(&manager, flow_id_table[i], i, true);
+  }
+  for (i=0; i<POOL_SIZE; i+=2)
+    decoder_manager_remove(&manager, flow_id_table[i]);
+  for (i=0; i<POOL_SIZE; i++) {
+    packet_set_t* set = decoder_manager_get_set(&manager, flow_id_table[i],
+						POOL_SIZE, false);
+    if ((i%2 == 0) != (set == NULL)
+	|| (set != NULL && decoder_manager_get_flow_id(set) 
+	    != flow_id_table[i])) {
+      fprintf(stdout, "ERROR: bad lookup of flow %u\n", flow_id_table[i]);
+      nb_error ++;
+    }
+  }
+  if (manager.stat.nb_active != POOL_SIZE/2 
+      || manager.stat.nb_active_max != POOL_SIZE) {
+    fprintf(stdout, "ERROR: unexpected number of active flows\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "%u flows: %lu bytes\n", POOL_SIZE, 
+	  (unsigned long)decoder_manager_get_memory_size(&manager));
+}
+
+int main(int argc, char** argv)
+{
+  uint8_t l;
+  srand(1);
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++)
+    test_decoding(l);
+  test_eviction();
+  test_lookup();
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
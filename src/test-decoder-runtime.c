@@ -0,0 +1,177 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the decoding of flows by several threads
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "decoder-runtime.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 200
+#define DATA_SIZE 32
+#define NB_FLOW 32
+#define NB_WORKER 4
+#define WINDOW(l) MIN(MAX_CODED_PACKET-1, 1<<log2_window_size(l))
+
+/* the sets rely on their own store of decoded packets */
+#if DECODED_STORE_SIZE > 0
+#define FLOW_WINDOW(l) MIN(WINDOW(l), DECODED_STORE_SIZE)
+#else /* DECODED_STORE_SIZE > 0 */
+#define FLOW_WINDOW(l) WINDOW(l)
+#endif /* DECODED_STORE_SIZE > 0 */
+
+decoder_runtime_t runtime;
+/* only written by the worker owning the flow */
+uint16_t nb_decoded_table[NB_FLOW];
+unsigned int nb_bad_decoded[NB_WORKER];
+unsigned int nb_error = 0;
+
+/* the content of each source packet depends on its flow id */
+static void make_source(uint32_t flow_id, uint16_t coef_pos, uint8_t* data)
+{
+  uint16_t j;
+  for (j=0; j<DATA_SIZE; j++)
+    data[j] = (flow_id*131 + coef_pos*7 + j*j) & 0xff;
+}
+
+static void check_decoded(void* notif_data, uint16_t worker_index,
+			  uint32_t flow_id, coded_packet_t* pkt)
+{
+  uint8_t data[DATA_SIZE];
+  (void)notif_data;
+  make_source(flow_id, pkt->coef_pos_min, data);
+  if (flow_id >= NB_FLOW
+      || memcmp(coded_packet_data(pkt), data, DATA_SIZE) != 0) {
+    nb_bad_decoded[worker_index] ++;
+    return;
+  }
+  nb_decoded_table[flow_id] ++;
+}
+
+static void make_combination(coded_packet_t* pkt, uint8_t l, uint32_t flow_id,
+			     uint16_t first, uint16_t last)
+{
+  uint8_t coef_max = (1<<(1<<l))-1;
+  uint8_t data[DATA_SIZE];
+  uint16_t i;
+  coded_packet_init(pkt, l);
+  for (i=first; i<=last; i++) {
+    uint8_t coef = (i == last) ? 1 + rand()%coef_max : rand()%(coef_max+1);
+    if (coef == 0)
+      continue;
+    coded_packet_t src;
+    make_source(flow_id, i, data);
+    coded_packet_init_from_base_packet(&src, l, i, data, DATA_SIZE);
+    coded_packet_add_mult(pkt, coef, &src);
+  }
+}
+
+/* some flows send more (redundant) packets than others, and shards are 
+   also migrated explicitly, while packets are dispatched */
+static void test_runtime(uint8_t l)
+{
+  coded_packet_t pkt;
+  uint16_t i, f, k;
+
+  memset(nb_decoded_table, 0, sizeof(nb_decoded_table));
+  memset(nb_bad_decoded, 0, sizeof(nb_bad_decoded));
+  if (!decoder_runtime_start(&runtime, NB_WORKER, l, NB_SOURCE,
+			     check_decoded, NULL)) {
+    fprintf(stdout, "ERROR: cannot start the runtime\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i=0; i<NB_SOURCE; i++) {
+    for (f=0; f<NB_FLOW; f++) {
+      uint16_t first = (i >= FLOW_WINDOW(l)-1) ? i-(FLOW_WINDOW(l)-1) : 0;
+      uint16_t nb_packet = (f%4 == 0) ? 4 : 1;
+      for (k=0; k<nb_packet; k++) {
+	make_combination(&pkt, l, f, first, i);
+	decoder_runtime_dispatch(&runtime, f, i, &pkt);
+      }
+    }
+    if (i%10 == 0) {
+      f = (i/10) % NB_FLOW;
+      decoder_runtime_migrate(&runtime, decoder_runtime_get_shard(f),
+			      (i/10) % NB_WORKER);
+    }
+  }
+  decoder_runtime_stop(&runtime);
+
+  for (f=0; f<NB_FLOW; f++)
+    if (nb_decoded_table[f] != NB_SOURCE) {
+      fprintf(stdout, "ERROR: GF(%u) flow %u: %u/%u decoded\n", 1<<(1<<l),
+	      f, nb_decoded_table[f], NB_SOURCE);
+      nb_error ++;
+    }
+
+  uint32_t nb_flow_in = 0, nb_flow_out = 0, nb_packet = 0;
+  for (i=0; i<NB_WORKER; i++) {
+    nb_flow_in += runtime.worker[i].stat.nb_flow_in;
+    nb_flow_out += runtime.worker[i].stat.nb_flow_out;
+    nb_packet += runtime.worker[i].stat.nb_packet;
+    if (nb_bad_decoded[i] > 0) {
+      fprintf(stdout, "ERROR: worker %u: %u bad decoded packets\n",
+	      i, nb_bad_decoded[i]);
+      nb_error ++;
+    }
+  }
+  if (nb_flow_in != nb_flow_out || nb_flow_in == 0
+      || runtime.stat.nb_migration == 0
+      || nb_packet != runtime.stat.nb_dispatched) {
+    fprintf(stdout, "ERROR: unexpected statistics of the runtime\n");
+    nb_error ++;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  uint8_t l;
+  srand(1);
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++)
+    test_runtime(l);
+  decoder_runtime_pywrite(stdout, &runtime);
+  fprintf(stdout, "\n");
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
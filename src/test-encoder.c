@@ -0,0 +1,449 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the sliding window encoder (with a packet set as decoder)
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "encoder.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 200
+#define DATA_SIZE 32
+#define NB_VECTOR 5
+#define NB_RECEIVER 3
+
+uint8_t source_table[NB_SOURCE][DATA_SIZE];
+coded_packet_t decoded_table[NB_SOURCE];
+bool_t is_decoded[NB_SOURCE];
+unsigned int nb_error = 0;
+
+static void check_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint16_t coef_pos = pkt->coef_pos_min;
+  if (coef_pos >= NB_SOURCE || is_decoded[coef_pos]
+      || memcmp(coded_packet_data(pkt), source_table[coef_pos], DATA_SIZE)
+      != 0) {
+    fprintf(stdout, "ERROR: bad decoded packet %u\n", coef_pos);
+    nb_error ++;
+    return;
+  }
+  is_decoded[coef_pos] = true;
+  coded_packet_copy_from(&decoded_table[coef_pos], pkt);
+}
+
+static bool_t get_decoded(packet_set_t* set, uint16_t coef_pos,
+			  coded_packet_t* result)
+{
+  if (coef_pos >= NB_SOURCE || !is_decoded[coef_pos])
+    return false;
+  coded_packet_copy_from(result, &decoded_table[coef_pos]);
+  return true;
+}
+
+static void make_room(packet_set_t* set, uint16_t required_min_coef_pos)
+{
+  (void)required_min_coef_pos;
+  while (!packet_set_is_empty(set) && packet_set_free_first(set))
+    ;
+}
+
+/* compare lc_vector_linear_combination with successive lc_vector_mul */
+static void test_linear_combination(uint8_t l, uint16_t size)
+{
+  uint8_t data[NB_VECTOR][CODED_PACKET_SIZE];
+  uint8_t* data_table[NB_VECTOR];
+  uint8_t coef_table[NB_VECTOR];
+  uint8_t expected[CODED_PACKET_SIZE], result[CODED_PACKET_SIZE];
+  uint8_t tmp[CODED_PACKET_SIZE];
+  uint16_t i, j;
+
+  memset(expected, 0, size);
+  for (i=0; i<NB_VECTOR; i++) {
+    for (j=0; j<size; j++)
+      data[i][j] = rand() & 0xff;
+    data_table[i] = data[i];
+    coef_table[i] = rand() & MASK(1<<l);
+    lc_vector_mul(coef_table[i], data[i], size, l, tmp);
+    lc_vector_add(expected, size, tmp, size, expected, &j);
+  }
+  lc_vector_linear_combination(coef_table, data_table, NB_VECTOR, size, l,
+			       result);
+  if (memcmp(expected, result, size) != 0) {
+    fprintf(stdout, "ERROR: GF(%u) bad linear combination of size %u\n",
+	    1<<(1<<l), size);
+    nb_error ++;
+  }
+}
+
+/* the receiver acknowledges the decoded packets before the first
+   non-decoded one */
+/* the density and band width of the coded packets are set with 
+   encoder_set_density */
+static void test_encoder(uint8_t l, int loss_percent, uint16_t density,
+			 uint16_t band_width)
+{
+  encoder_t encoder;
+  packet_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt;
+  uint16_t i, nb_decoded = 0, nb_acked = 0;
+  int j;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  encoder_init(&encoder, l, 0, 1+l);
+  encoder_set_density(&encoder, density, band_width);
+  packet_set_init(&set, l, check_decoded, make_room, get_decoded, NULL);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    if (encoder_add_source(&encoder, source_table[i], DATA_SIZE) != i) {
+      fprintf(stdout, "ERROR: bad source index %u\n", i);
+      nb_error ++;
+    }
+    for (j=0; j<2; j++) {
+      if (!encoder_generate(&encoder, &pkt))
+	continue;
+      if (band_width > 0 && pkt.coef_pos_max - pkt.coef_pos_min >= band_width) {
+	fprintf(stdout, "ERROR: coded packet larger than the band\n");
+	nb_error ++;
+      }
+      if (rand()%100 < loss_percent)
+	continue;
+      packet_set_add(&set, &pkt, &stat, true);
+      nb_decoded += stat.decoded;
+    }
+    while (nb_acked < NB_SOURCE && is_decoded[nb_acked])
+      nb_acked ++;
+    if (nb_acked > 0)
+      encoder_ack(&encoder, nb_acked-1);
+    if (encoder.coef_pos_min != MAX(nb_acked, 
+			    encoder_get_next_coef_pos(&encoder)
+				    - encoder.window_size)) {
+      fprintf(stdout, "ERROR: bad window after ack\n");
+      nb_error ++;
+    }
+  }
+
+  if (loss_percent == 0 && nb_decoded != NB_SOURCE) {
+    fprintf(stdout, "ERROR: not all packets decoded without losses\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% window=%u density=%u band=%u:"
+	  " %u/%u decoded\n", 1<<(1<<l), loss_percent, encoder.window_size,
+	  density, band_width, nb_decoded, NB_SOURCE);
+}
+
+/* systematic mode: every lost packet is reported immediately */
+static void test_systematic(uint8_t l, int loss_percent,
+			    uint16_t repair_interval)
+{
+  encoder_t encoder;
+  packet_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt;
+  uint16_t i, nb_decoded = 0, nb_acked = 0;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  encoder_init(&encoder, l, 0, 1+l);
+  encoder_set_repair_interval(&encoder, repair_interval);
+  packet_set_init(&set, l, check_decoded, make_room, get_decoded, NULL);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    encoder_add_source(&encoder, source_table[i], DATA_SIZE);
+    while (encoder_next_packet(&encoder, &pkt)) {
+      if (pkt.coef_pos_min < encoder.coef_pos_min
+	  || pkt.coef_pos_max >= encoder.next_systematic) {
+	fprintf(stdout, "ERROR: packet out of the sent, unacked window\n");
+	nb_error ++;
+      }
+      if (rand()%100 < loss_percent) {
+	encoder_notify_loss(&encoder, 1);
+	continue;
+      }
+      packet_set_add(&set, &pkt, &stat, true);
+      nb_decoded += stat.decoded;
+      while (nb_acked < NB_SOURCE && is_decoded[nb_acked])
+	nb_acked ++;
+      if (nb_acked > 0)
+	encoder_ack(&encoder, nb_acked-1);
+    }
+  }
+
+  if (encoder.nb_systematic_sent != NB_SOURCE
+      || (loss_percent == 0 && repair_interval == 0
+	  && encoder.nb_repair_sent != 0)) {
+    fprintf(stdout, "ERROR: unexpected number of sent packets\n");
+    nb_error ++;
+  }
+  if (loss_percent == 0 && nb_decoded != NB_SOURCE) {
+    fprintf(stdout, "ERROR: not all packets decoded without losses\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% systematic, repair interval=%u:"
+	  " %u/%u decoded, %u repair packets\n", 1<<(1<<l), loss_percent,
+	  repair_interval, nb_decoded, NB_SOURCE, encoder.nb_repair_sent);
+}
+
+/* broadcast to several receivers with independent losses: before each coded
+   packet, the encoder gets their state (when with_state is true), and
+   acknowledges the source packets decoded by all of them */
+/* returns the number of decoded source packets (of all the receivers) */
+static uint16_t test_innovative(uint8_t l, int loss_percent, bool with_state)
+{
+  encoder_t encoder;
+  packet_set_t set_table[NB_RECEIVER];
+  receiver_state_t state_table[NB_RECEIVER];
+  bool innovative_table[NB_RECEIVER];
+  reduction_stat_t stat;
+  coded_packet_t pkt, copy;
+  uint16_t i, r, nb_decoded = 0, nb_non_innovative = 0;
+  int j;
+
+  encoder_init(&encoder, l, 0, 1+l);
+  for (r=0; r<NB_RECEIVER; r++)
+    packet_set_init(&set_table[r], l, NULL, packet_set_free_decoded, NULL,
+		    NULL);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    encoder_add_source(&encoder, source_table[i], DATA_SIZE);
+    for (j=0; j<2; j++) {
+      bool has_pkt;
+      if (with_state) {
+	for (r=0; r<NB_RECEIVER; r++)
+	  packet_set_get_receiver_state(&set_table[r], encoder.coef_pos_min,
+					&state_table[r]);
+	has_pkt = encoder_generate_innovative(&encoder, state_table,
+					      NB_RECEIVER, &pkt,
+					      innovative_table);
+      } else has_pkt = encoder_generate(&encoder, &pkt);
+      if (!has_pkt)
+	continue;
+
+      for (r=0; r<NB_RECEIVER; r++) {
+	if (rand()%100 < loss_percent)
+	  continue;
+	bool is_innovative = packet_set_is_innovative(&set_table[r], &pkt);
+	if (with_state && innovative_table[r] && !is_innovative) {
+	  fprintf(stdout, "ERROR: packet not innovative as expected\n");
+	  nb_error ++;
+	}
+	nb_non_innovative += !is_innovative;
+	coded_packet_copy_from(&copy, &pkt);
+	packet_set_add(&set_table[r], &copy, &stat, true);
+	nb_decoded += stat.decoded;
+      }
+    }
+
+    for (;;) {
+      if (encoder_is_empty(&encoder))
+	break;
+      for (r=0; r<NB_RECEIVER; r++)
+	if (!bitmap_get_bit(set_table[r].decoded_bitmap, DECODED_BITMAP_SIZE,
+			    encoder.coef_pos_min))
+	  break;
+      if (r < NB_RECEIVER)
+	break;
+      encoder_ack(&encoder, encoder.coef_pos_min);
+    }
+  }
+
+  if (with_state && loss_percent == 0 && nb_decoded != NB_SOURCE*NB_RECEIVER) {
+    fprintf(stdout, "ERROR: not all packets decoded without losses\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% receivers=%u state=%u: %u/%u decoded,"
+	  " %u non-innovative\n", 1<<(1<<l), loss_percent, NB_RECEIVER,
+	  with_state, nb_decoded, NB_SOURCE*NB_RECEIVER, nb_non_innovative);
+  return nb_decoded;
+}
+
+#if ENCODER_NB_ACCUMULATOR > 0
+/* packets are generated from the accumulators, which must remain equal to
+   the combination of the window with their coefficients */
+static void test_accumulated(uint8_t l, int loss_percent)
+{
+  encoder_t encoder;
+  packet_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt, expected;
+  uint8_t coef_table[ENCODER_MAX_WINDOW];
+  uint16_t a, i, k, nb_decoded = 0, nb_acked = 0;
+  int j;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  encoder_init(&encoder, l, 0, 1+l);
+  packet_set_init(&set, l, check_decoded, make_room, get_decoded, NULL);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    encoder_add_source(&encoder, source_table[i], DATA_SIZE);
+    for (j=0; j<2; j++) {
+      if (!encoder_generate_accumulated(&encoder, &pkt))
+	continue;
+      if (rand()%100 < loss_percent)
+	continue;
+      packet_set_add(&set, &pkt, &stat, true);
+      nb_decoded += stat.decoded;
+    }
+    while (nb_acked < NB_SOURCE && is_decoded[nb_acked])
+      nb_acked ++;
+    if (nb_acked > 0)
+      encoder_ack(&encoder, nb_acked-1);
+
+    if (encoder_is_empty(&encoder))
+      continue;
+    for (a=0; a<ENCODER_NB_ACCUMULATOR; a++) {
+      for (k=0; k<encoder.nb_source; k++)
+	coef_table[k] = encoder_get_accumulator_coef
+	  (&encoder, a, encoder.coef_pos_min+k);
+      encoder_generate_with_coefs(&encoder, encoder.coef_pos_min, coef_table,
+				  encoder.nb_source, &expected);
+      if (!coded_packet_is_similar(&expected, &encoder.accumulator[a])) {
+	fprintf(stdout, "ERROR: accumulator %u differs from its combination\n",
+		a);
+	nb_error ++;
+      }
+    }
+  }
+
+  if (loss_percent == 0 && nb_decoded != NB_SOURCE) {
+    fprintf(stdout, "ERROR: not all packets decoded without losses\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% accumulated: %u/%u decoded\n",
+	  1<<(1<<l), loss_percent, nb_decoded, NB_SOURCE);
+}
+
+/* each accumulator combines the whole window (except the random ones of
+   GF(2)), so that accumulated packets recover lost source packets 
+   anywhere in the window: here, the ones with the same index modulo 
+   ENCODER_NB_ACCUMULATOR, which a partition of the window between the 
+   accumulators could not separate (the coefficients are random: this is
+   only required in GF(16) and GF(256)) */
+static void test_accumulated_window(uint8_t l)
+{
+  encoder_t encoder;
+  packet_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt;
+  uint8_t one = 1;
+  uint16_t a, i, nb_lost = 0, nb_recovered = 0;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  encoder_init(&encoder, l, 0, 7+l);
+  packet_set_init(&set, l, check_decoded, NULL, NULL, NULL);
+  for (i=0; i<encoder.window_size; i++)
+    encoder_add_source(&encoder, source_table[i], DATA_SIZE);
+
+  for (a=0; a<ENCODER_NB_ACCUMULATOR; a++)
+    for (i=0; i<encoder.window_size; i++)
+      if ((a == 0 || l > 0)
+	  && coded_packet_get_coef(&encoder.accumulator[a], i) == 0) {
+	fprintf(stdout, "ERROR: GF(%u) accumulator %u without source %u\n",
+		1<<(1<<l), a, i);
+	nb_error ++;
+      }
+
+  for (i=0; i<encoder.window_size; i++) {
+    if (i % ENCODER_NB_ACCUMULATOR == 0 && nb_lost < ENCODER_NB_ACCUMULATOR) {
+      nb_lost ++;
+      continue;
+    }
+    encoder_generate_with_coefs(&encoder, i, &one, 1, &pkt);
+    packet_set_add(&set, &pkt, &stat, true);
+  }
+  for (i=0; i<2*ENCODER_NB_ACCUMULATOR && nb_recovered < nb_lost; i++) {
+    encoder_generate_accumulated(&encoder, &pkt);
+    packet_set_add(&set, &pkt, &stat, true);
+    nb_recovered = 0;
+    for (a=0; a<nb_lost; a++)
+      nb_recovered += is_decoded[a*ENCODER_NB_ACCUMULATOR];
+  }
+  if (l >= 2 && nb_recovered < nb_lost) {
+    fprintf(stdout, "ERROR: GF(%u) %u/%u lost packets recovered\n",
+	    1<<(1<<l), nb_recovered, nb_lost);
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) window=%u accumulated: %u/%u lost packets "
+	  "recovered with %u packets\n", 1<<(1<<l), encoder.window_size,
+	  nb_recovered, nb_lost, i);
+}
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+
+int main(int argc, char** argv)
+{
+  uint16_t i, j;
+  srand(1);
+  for (i=0; i<NB_SOURCE; i++)
+    for (j=0; j<DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+
+  uint8_t l;
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_linear_combination(l, 1);
+    test_linear_combination(l, LC_BLOCK_SIZE+1);
+    test_linear_combination(l, CODED_PACKET_SIZE);
+    test_encoder(l, 0, ENCODER_DENSITY_FULL, 0);
+    test_encoder(l, 20, ENCODER_DENSITY_FULL, 0);
+    test_encoder(l, 0, ENCODER_DENSITY_FULL/2, 2);
+    test_encoder(l, 20, ENCODER_DENSITY_FULL/2, 2);
+    test_systematic(l, 0, 0);
+    test_systematic(l, 0, 4);
+    test_systematic(l, 20, 0);
+    test_systematic(l, 20, 4);
+    test_innovative(l, 0, true);
+    uint16_t nb_random = test_innovative(l, 20, false);
+    if (test_innovative(l, 20, true) < nb_random) {
+      fprintf(stdout, "ERROR: fewer packets decoded with receiver states\n");
+      nb_error ++;
+    }
+#if ENCODER_NB_ACCUMULATOR > 0
+    test_accumulated(l, 0);
+    test_accumulated(l, 20);
+    test_accumulated_window(l);
+#endif /* ENCODER_NB_ACCUMULATOR > 0 */
+  }
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,162 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the inner and outer decoding of Fulcrum coded packets
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "fulcrum.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define MAX_K 16
+#define DATA_SIZE 40
+#define NB_BLOCK 20
+#define MAX_PACKET_PER_BLOCK 100
+
+uint8_t source_table[MAX_K][DATA_SIZE];
+unsigned int nb_error = 0;
+
+/* every block is decoded by a new packet set, either in GF(2) with the
+   coded packets as they are (inner decoding), or in GF(256) after their
+   mapping to the outer code */
+static void test_fulcrum(uint16_t k, uint16_t r, bool is_outer)
+{
+  fulcrum_encoder_t encoder;
+  block_encoder_t outer;
+  packet_set_t set;
+  coded_packet_t pkt, outer_pkt;
+  uint8_t* data_table[MAX_K];
+  uint16_t b, i, j, nb_packet = 0;
+
+  if (!fulcrum_encoder_init(&encoder, k, r, (uint64_t)(k+r) << 32 | k)
+      || !block_encoder_init(&outer, 3, k, r)) {
+    fprintf(stdout, "ERROR: K=%u R=%u not supported\n", k, r);
+    nb_error ++;
+    return;
+  }
+
+  for (b=0; b<NB_BLOCK; b++) {
+    uint16_t coef_pos_base = b*(k+r);
+    for (i=0; i<k; i++) {
+      for (j=0; j<DATA_SIZE; j++)
+	source_table[i][j] = rand() & 0xff;
+      data_table[i] = source_table[i];
+    }
+    fulcrum_encoder_set_block(&encoder, coef_pos_base, data_table, DATA_SIZE);
+    packet_set_init(&set, is_outer ? 3 : 0, NULL, NULL, NULL, NULL);
+
+    uint16_t nb_source_decoded = 0;
+    for (i=0; i<MAX_PACKET_PER_BLOCK && nb_source_decoded < k; i++) {
+      fulcrum_encoder_generate(&encoder, &pkt);
+      nb_packet ++;
+      if (is_outer) {
+	fulcrum_map_to_outer(&outer, coef_pos_base, &pkt, &outer_pkt);
+	packet_set_add(&set, &outer_pkt, NULL, true);
+      } else packet_set_add(&set, &pkt, NULL, true);
+      nb_source_decoded = 0;
+      for (j=0; j<k; j++)
+	nb_source_decoded += bitmap_get_bit(set.decoded_bitmap, 
+					    DECODED_BITMAP_SIZE,
+					    coef_pos_base+j);
+    }
+
+    for (j=0; j<k; j++) {
+      coded_packet_t* decoded
+	= packet_set_get_decoded_packet(&set, coef_pos_base+j);
+      if (decoded == NULL
+	  || memcmp(coded_packet_data(decoded), source_table[j], DATA_SIZE)
+	  != 0) {
+	fprintf(stdout, "ERROR: K=%u R=%u block %u: source %u not decoded\n",
+		k, r, b, j);
+	nb_error ++;
+	break;
+      }
+    }
+  }
+  fprintf(stdout, "K=%u R=%u %s decoding: %.2f packets per block\n", k, r,
+	  is_outer ? "outer" : "inner", (double)nb_packet / NB_BLOCK);
+}
+
+/* the seeds differing only in their upper 32 bits give different inner
+   coefficients */
+static void test_seed(void)
+{
+  fulcrum_encoder_t encoder[2];
+  coded_packet_t pkt[2];
+  uint8_t* data_table[MAX_K];
+  uint16_t k = MIN(MAX_CODED_PACKET-1, MAX_K);
+  uint16_t i, n;
+
+  for (i=0; i<k; i++)
+    data_table[i] = source_table[i];
+  for (i=0; i<2; i++) {
+    fulcrum_encoder_init(&encoder[i], k, 1, (uint64_t)i << 32 | 1);
+    fulcrum_encoder_set_block(&encoder[i], 0, data_table, DATA_SIZE);
+  }
+  for (n=0; n<NB_BLOCK; n++) {
+    for (i=0; i<2; i++)
+      fulcrum_encoder_generate(&encoder[i], &pkt[i]);
+    if (memcmp(pkt[0].content.u8, pkt[1].content.u8, 
+	       COEF_HEADER_SIZE) != 0)
+      return;
+  }
+  fprintf(stdout, "ERROR: the upper 32 bits of the seed are ignored\n");
+  nb_error ++;
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t k, r;
+  srand(1);
+
+  for (r=1; r<=2; r++) {
+    k = MIN(MAX_CODED_PACKET-r, MAX_K);
+    test_fulcrum(k, r, false);
+    test_fulcrum(k, r, true);
+  }
+  test_seed();
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,343 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the instrumentation of the field kernels and packet sets
+ *          (built with CONF_WITH_INSTRUMENT)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "instrument.h"
+
+#ifndef CONF_WITH_INSTRUMENT
+#error "test-instrument must be compiled with CONF_WITH_INSTRUMENT"
+#endif /* CONF_WITH_INSTRUMENT */
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 200
+#define DATA_SIZE MIN(CODED_PACKET_SIZE, 100)
+#define WINDOW(l) MIN(MAX_CODED_PACKET-1, 1<<log2_window_size(l))
+#define NB_THREAD 3
+#define NB_THREAD_OP 1000
+
+uint8_t source_table[NB_SOURCE][DATA_SIZE];
+uint8_t source_size[NB_SOURCE];
+
+unsigned int nb_decoded = 0;
+unsigned int nb_set_full = 0;
+unsigned int nb_error = 0;
+
+static void check_counter(instrument_snapshot_t* diff, uint16_t index,
+			  uint64_t expected, char* name)
+{
+  if (diff->counter[index] != expected) {
+    fprintf(stdout, "ERROR: counter %s (%u): %llu instead of %llu\n", name, 
+	    index, (unsigned long long)diff->counter[index],
+	    (unsigned long long)expected);
+    nb_error ++;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* each kernel call must be counted exactly once, with its size */
+static void test_kernel(uint8_t l)
+{
+  uint8_t data1[DATA_SIZE], data2[DATA_SIZE], result[DATA_SIZE];
+  uint16_t result_size;
+  instrument_snapshot_t before, after, diff;
+  memset(data1, 0x5a, DATA_SIZE);
+  memset(data2, 0xa5, DATA_SIZE);
+
+  instrument_get_snapshot(&before);
+  lc_vector_mul_add(1, data1, DATA_SIZE, l, result);
+  lc_vector_mul_add(0, data1, DATA_SIZE, l, result); /* does nothing */
+  lc_vector_mul(1, data2, DATA_SIZE-1, l, result);
+  lc_vector_add(data1, DATA_SIZE, data2, DATA_SIZE-2, result, &result_size);
+  instrument_get_snapshot(&after);
+  instrument_snapshot_diff(&diff, &after, &before);
+
+  check_counter(&diff, INSTRUMENT_NB_MUL_ADD+l, 1, "nb_mul_add");
+  check_counter(&diff, INSTRUMENT_BYTE_MUL_ADD+l, DATA_SIZE, "byte_mul_add");
+  check_counter(&diff, INSTRUMENT_NB_MUL+l, 1, "nb_mul");
+  check_counter(&diff, INSTRUMENT_BYTE_MUL+l, DATA_SIZE-1, "byte_mul");
+  check_counter(&diff, INSTRUMENT_NB_ADD, 1, "nb_add");
+  check_counter(&diff, INSTRUMENT_BYTE_ADD, DATA_SIZE-2, "byte_add");
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void notify_packet_decoded(packet_set_t* set, uint16_t packet_id)
+{ nb_decoded ++; }
+
+static void notify_set_full(packet_set_t* set, uint16_t required_min_coef_pos)
+{
+  nb_set_full ++;
+  packet_set_free_decoded(set, required_min_coef_pos);
+}
+
+static void make_combination(coded_packet_t* pkt, uint8_t l,
+			     uint16_t first, uint16_t last)
+{
+  uint8_t coef_max = (1<<(1<<l))-1;
+  coded_packet_init(pkt, l);
+  uint16_t i;
+  for (i=first; i<=last; i++) {
+    uint8_t coef = (i == last) ? 1 + rand()%coef_max : rand()%(coef_max+1);
+    if (coef == 0)
+      continue;
+    coded_packet_t src;
+    coded_packet_init_from_base_packet(&src, l, i, source_table[i],
+				       source_size[i]);
+    coded_packet_add_mult(pkt, coef, &src);
+  }
+}
+
+/* a time stat must be consistent with its histogram */
+static bool check_time_stat(instrument_time_stat_t* stat)
+{
+  uint32_t count = 0;
+  uint16_t i;
+  for (i=0; i<INSTRUMENT_NB_BUCKET; i++)
+    count += stat->histogram[i];
+  uint64_t p50 = instrument_time_stat_get_percentile(stat, 50);
+  uint64_t p99 = instrument_time_stat_get_percentile(stat, 99);
+  return count == stat->count && stat->max <= stat->total
+    && p50 <= p99 && p99 <= stat->max
+    && instrument_time_stat_get_percentile(stat, 100) == stat->max;
+}
+
+#define TEST_ADD     0
+#define TEST_STEP    1
+#define TEST_PROGRAM 2
+
+/* sum of the counters of all the sets */
+packet_set_instrument_t total_instrument;
+uint32_t total_nb_decoded = 0;
+
+/* the counters of the set must agree with what the application sees */
+static void test_packet_set(uint8_t l, int loss_percent, uint8_t mode)
+{
+  packet_set_t set;
+  packet_set_instrument_t instrument;
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  payload_program_t program;
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  bool use_step = (mode == TEST_STEP);
+  instrument_snapshot_t before, after, diff;
+  coded_packet_t pkt;
+  uint32_t nb_pkt = 0, nb_call = 0;
+  uint16_t i, j;
+
+  nb_decoded = 0;
+  nb_set_full = 0;
+  packet_set_init(&set, l, notify_packet_decoded, notify_set_full, NULL, NULL);
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+  if (mode == TEST_PROGRAM)
+    packet_set_set_payload_executor(&set, &program, NULL, NULL);
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  instrument_get_snapshot(&before);
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= WINDOW(l)-1) ? i-(WINDOW(l)-1) : 0;
+    for (j=0; j<2; j++) {
+      make_combination(&pkt, l, first, i);
+      if (rand()%100 < loss_percent)
+	continue;
+      nb_pkt ++;
+#if PACKET_SET_QUEUE_SIZE > 0
+      if (use_step) {
+	if (!packet_set_enqueue(&set, &pkt)) {
+	  fprintf(stdout, "ERROR: GF(%u): cannot enqueue\n", 1<<(1<<l));
+	  nb_error ++;
+	  return;
+	}
+	while (packet_set_get_nb_queued(&set) > 0) {
+	  packet_set_step(&set, 1, NULL);
+	  nb_call ++;
+	}
+	continue;
+      }
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+      packet_set_add(&set, &pkt, NULL, true);
+      nb_call ++;
+    }
+  }
+  instrument_get_snapshot(&after);
+  instrument_snapshot_diff(&diff, &after, &before);
+  packet_set_get_instrument(&set, &instrument);
+
+  if (instrument.nb_add != nb_pkt
+      || instrument.total_stat.decoded != nb_decoded
+      || instrument.nb_callback != nb_decoded + nb_set_full
+      || (use_step ? instrument.nb_step : instrument.add_time.count) != nb_call
+      || !check_time_stat(&instrument.add_time)
+      || instrument.callback_time 
+         > instrument.add_time.total + instrument.step_time
+      || instrument.decode_delay.count != nb_decoded
+      || !check_time_stat(&instrument.decode_delay)) {
+    fprintf(stdout, "ERROR: GF(%u) loss=%d mode=%u: bad counters ", 
+	    1<<(1<<l), loss_percent, mode);
+    packet_set_instrument_pywrite(stdout, &instrument);
+    fprintf(stdout, "\n");
+    nb_error ++;
+  }
+  if (loss_percent == 0 && nb_decoded != NB_SOURCE) {
+    fprintf(stdout, "ERROR: GF(%u): %u/%u decoded\n", 1<<(1<<l),
+	    nb_decoded, NB_SOURCE);
+    nb_error ++;
+  }
+  if (nb_decoded > 0 && (diff.counter[INSTRUMENT_NB_ADJUST] == 0
+			 || diff.counter[INSTRUMENT_NB_MUL+l] == 0
+			 || diff.counter[INSTRUMENT_NB_ADD] == 0)) {
+    fprintf(stdout, "ERROR: GF(%u): kernels not counted\n", 1<<(1<<l));
+    nb_error ++;
+  }
+  packet_set_instrument_accumulate(&total_instrument, &instrument);
+  total_nb_decoded += nb_decoded;
+}
+
+/* percentiles of known times */
+static void test_time_stat(void)
+{
+  instrument_time_stat_t stat;
+  uint64_t time;
+  instrument_time_stat_init(&stat);
+  if (instrument_time_stat_get_percentile(&stat, 50) != 0) {
+    fprintf(stdout, "ERROR: percentile without any time\n");
+    nb_error ++;
+  }
+  for (time=0; time<1000; time++)
+    instrument_time_stat_add(&stat, time);
+  uint64_t p50 = instrument_time_stat_get_percentile(&stat, 50);
+  uint64_t p90 = instrument_time_stat_get_percentile(&stat, 90);
+  /* (the estimation is within a factor 2) */
+  if (!check_time_stat(&stat) || stat.count != 1000 || stat.max != 999
+      || p50 < 500/2 || p50 > 500*2 || p90 < 900/2 || p90 > 999) {
+    fprintf(stdout, "ERROR: bad time stat ");
+    instrument_time_stat_pywrite(stdout, &stat);
+    fprintf(stdout, "\n");
+    nb_error ++;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* the counters of the threads (even after they exited) are in the
+   snapshots */
+static void* thread_main(void* arg)
+{
+  uint8_t data[DATA_SIZE], result[DATA_SIZE];
+  uint16_t i;
+  memset(data, 0x33, DATA_SIZE);
+  for (i=0; i<NB_THREAD_OP; i++)
+    lc_vector_mul_add(2, data, DATA_SIZE, MAX_LOG2_NB_BIT_COEF, result);
+  return NULL;
+}
+
+static void test_thread(void)
+{
+  pthread_t thread_table[NB_THREAD];
+  instrument_snapshot_t before, after, diff;
+  uint16_t i;
+
+  instrument_get_snapshot(&before);
+  for (i=0; i<NB_THREAD; i++)
+    if (pthread_create(&thread_table[i], NULL, thread_main, NULL) != 0) {
+      fprintf(stdout, "ERROR: cannot create thread\n");
+      exit(EXIT_FAILURE);
+    }
+  for (i=0; i<NB_THREAD; i++)
+    pthread_join(thread_table[i], NULL);
+  instrument_get_snapshot(&after);
+  instrument_snapshot_diff(&diff, &after, &before);
+
+  check_counter(&diff, INSTRUMENT_NB_MUL_ADD+MAX_LOG2_NB_BIT_COEF,
+		NB_THREAD*NB_THREAD_OP, "nb_mul_add (threads)");
+  check_counter(&diff, INSTRUMENT_BYTE_MUL_ADD+MAX_LOG2_NB_BIT_COEF,
+		NB_THREAD*NB_THREAD_OP*DATA_SIZE, "byte_mul_add (threads)");
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+  instrument_snapshot_t snapshot;
+  uint16_t i, j;
+  uint8_t l;
+  memset(&total_instrument, 0, sizeof(total_instrument));
+  srand(1);
+  for (i=0; i<NB_SOURCE; i++) {
+    source_size[i] = 1 + rand()%DATA_SIZE;
+    for (j=0; j<source_size[i]; j++)
+      source_table[i][j] = rand() & 0xff;
+  }
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_kernel(l);
+    test_packet_set(l, 0, TEST_ADD);
+    test_packet_set(l, 30, TEST_ADD);
+#if PACKET_SET_QUEUE_SIZE > 0
+    test_packet_set(l, 0, TEST_STEP);
+    test_packet_set(l, 30, TEST_STEP);
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+#ifdef CONF_WITH_PAYLOAD_PROGRAM
+    test_packet_set(l, 30, TEST_PROGRAM);
+#endif /* CONF_WITH_PAYLOAD_PROGRAM */
+  }
+  test_thread();
+  test_time_stat();
+
+  if (total_instrument.decode_delay.count != total_nb_decoded
+      || !check_time_stat(&total_instrument.decode_delay)) {
+    fprintf(stdout, "ERROR: bad aggregated decoding delays\n");
+    nb_error ++;
+  }
+  packet_set_instrument_pywrite(stdout, &total_instrument);
+  fprintf(stdout, "\n");
+
+  instrument_get_snapshot(&snapshot);
+  instrument_snapshot_pywrite(stdout, &snapshot);
+  fprintf(stdout, "\n");
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
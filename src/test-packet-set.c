@@ -0,0 +1,496 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test decoding of sliding window combinations with a packet set
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "packet-set.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 200
+#define DATA_SIZE 32
+#define WINDOW(l) MIN(MAX_CODED_PACKET-1, 1<<log2_window_size(l))
+#define MAX_BATCH 8
+
+uint8_t source_table[NB_SOURCE][DATA_SIZE];
+coded_packet_t decoded_table[NB_SOURCE];
+bool_t is_decoded[NB_SOURCE];
+unsigned int nb_error = 0;
+
+static void check_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint16_t coef_pos = pkt->coef_pos_min;
+  if (!coded_packet_was_decoded(pkt) || coef_pos >= NB_SOURCE
+      || coded_packet_get_coef(pkt, coef_pos) != 1
+      || memcmp(coded_packet_data(pkt), source_table[coef_pos], DATA_SIZE)
+      != 0) {
+    fprintf(stdout, "ERROR: bad decoded packet %u\n", coef_pos);
+    nb_error ++;
+    return;
+  }
+  if (is_decoded[coef_pos]) {
+    fprintf(stdout, "ERROR: packet %u notified twice\n", coef_pos);
+    nb_error ++;
+  }
+  is_decoded[coef_pos] = true;
+  coded_packet_copy_from(&decoded_table[coef_pos], pkt);
+}
+
+static bool_t get_decoded(packet_set_t* set, uint16_t coef_pos,
+			  coded_packet_t* result)
+{
+  if (coef_pos >= NB_SOURCE || !is_decoded[coef_pos])
+    return false;
+  coded_packet_copy_from(result, &decoded_table[coef_pos]);
+  return true;
+}
+
+static void make_room(packet_set_t* set, uint16_t required_min_coef_pos)
+{
+  (void)required_min_coef_pos;
+  while (!packet_set_is_empty(set) && packet_set_free_first(set))
+    ;
+}
+
+/* the relay only gets back source packets that it has decoded */
+static bool_t get_source(packet_set_t* set, uint16_t coef_pos,
+			 coded_packet_t* result)
+{
+  if (coef_pos >= NB_SOURCE)
+    return false;
+  coded_packet_init_from_base_packet(result, set->log2_nb_bit_coef, coef_pos,
+				     source_table[coef_pos], DATA_SIZE);
+  return true;
+}
+
+static void make_combination(coded_packet_t* pkt, uint8_t l,
+			     uint16_t first, uint16_t last)
+{
+  uint8_t coef_max = (1<<(1<<l))-1;
+  coded_packet_init(pkt, l);
+  uint16_t i;
+  for (i=first; i<=last; i++) {
+    uint8_t coef = (i == last) ? 1 + rand()%coef_max : rand()%(coef_max+1);
+    if (coef == 0)
+      continue;
+    coded_packet_t src;
+    coded_packet_init_from_base_packet(&src, l, i, source_table[i],
+				       DATA_SIZE);
+    coded_packet_add_mult(pkt, coef, &src);
+  }
+}
+
+/* when batch_size > 1, packets are added with packet_set_add_batch,
+   when with_store is true, the set frees decoded packets itself and relies on
+   its own store of decoded packets instead of make_room and get_decoded,
+   when systematic is true, each source packet is also sent uncoded */
+static void test_sliding_window(uint8_t l, int loss_percent,
+				uint16_t batch_size, bool_t with_store,
+				bool_t systematic)
+{
+  packet_set_t set;
+  reduction_stat_t stat_table[MAX_BATCH];
+  coded_packet_t pkt_table[MAX_BATCH];
+  uint16_t nb_pkt = 0;
+  uint16_t i, k;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  if (with_store)
+    packet_set_init(&set, l, check_decoded, packet_set_free_decoded,
+		    NULL, NULL);
+  else packet_set_init(&set, l, check_decoded, make_room, get_decoded, NULL);
+
+  uint16_t nb_decoded = 0;
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= WINDOW(l)-1) ? i-(WINDOW(l)-1) : 0;
+    int j;
+    for (j=0; j<2; j++) {
+      make_combination(&pkt_table[nb_pkt], l,
+		       (systematic && j == 0) ? i : first, i);
+      if (rand()%100 < loss_percent)
+	continue;
+      nb_pkt ++;
+      if (nb_pkt < batch_size && i < NB_SOURCE-1)
+	continue;
+      if (batch_size <= 1)
+	packet_set_add(&set, &pkt_table[0], &stat_table[0], true);
+      else packet_set_add_batch(&set, pkt_table, nb_pkt, stat_table);
+      for (k=0; k<nb_pkt; k++)
+	nb_decoded += stat_table[k].decoded;
+      nb_pkt = 0;
+    }
+  }
+
+  uint16_t nb_notified = 0;
+  for (i=0; i<NB_SOURCE; i++)
+    nb_notified += is_decoded[i];
+  if (nb_notified != nb_decoded) {
+    fprintf(stdout, "ERROR: %u notified, %u counted as decoded\n",
+	    nb_notified, nb_decoded);
+    nb_error ++;
+  }
+  if (loss_percent == 0 && nb_notified != NB_SOURCE) {
+    fprintf(stdout, "ERROR: not all packets decoded without losses\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% batch=%u store=%u systematic=%u:"
+	  " %u/%u decoded\n", 1<<(1<<l), loss_percent, batch_size,
+	  with_store, systematic, nb_notified, NB_SOURCE);
+}
+
+/* a relay receives packets (with losses) and forwards recoded packets */
+static void test_recode(uint8_t l, int loss_percent)
+{
+  packet_set_t relay, set;
+  reduction_stat_t stat;
+  coef_generator_t generator;
+  coded_packet_t pkt;
+  uint16_t i;
+  int j;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  coef_generator_init(&generator, l);
+  packet_set_init(&relay, l, NULL, make_room, get_source, NULL);
+  packet_set_init(&set, l, check_decoded, make_room, get_decoded, NULL);
+
+  uint16_t nb_decoded = 0;
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= WINDOW(l)-1) ? i-(WINDOW(l)-1) : 0;
+    for (j=0; j<2; j++) {
+      make_combination(&pkt, l, first, i);
+      if (rand()%100 < loss_percent)
+	continue;
+      packet_set_add(&relay, &pkt, NULL, true);
+    }
+    for (j=0; j<2; j++) {
+      if (!packet_set_recode(&relay, &generator, &pkt, WINDOW(l)))
+	continue;
+      if (pkt.coef_pos_max - pkt.coef_pos_min >= WINDOW(l)) {
+	fprintf(stdout, "ERROR: recoded packet larger than window hint\n");
+	nb_error ++;
+      }
+      packet_set_add(&set, &pkt, &stat, true);
+      nb_decoded += stat.decoded;
+    }
+  }
+  if (loss_percent == 0 && nb_decoded != NB_SOURCE) {
+    fprintf(stdout, "ERROR: not all packets decoded without losses\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% recoded: %u/%u decoded\n",
+	  1<<(1<<l), loss_percent, nb_decoded, NB_SOURCE);
+}
+
+/* the decoded packets freed from a relay are still recoded, from 
+   get_decoded_packet_func, while they are in the window */
+static void test_recode_freed(uint8_t l)
+{
+  packet_set_t relay;
+  coef_generator_t generator;
+  coded_packet_t pkt;
+  uint16_t i;
+
+  coef_generator_init(&generator, l);
+  packet_set_init(&relay, l, NULL, NULL, get_source, NULL);
+  for (i=0; i<WINDOW(l); i++) {
+    coded_packet_init_from_base_packet(&pkt, l, i, source_table[i],
+				       DATA_SIZE);
+    packet_set_add(&relay, &pkt, NULL, true);
+  }
+  while (relay.coef_pos_min < WINDOW(l)-1)
+    packet_set_free_first(&relay);
+
+  if (!packet_set_recode(&relay, &generator, &pkt, WINDOW(l))
+      || pkt.coef_pos_min != 0 || pkt.coef_pos_max != WINDOW(l)-1) {
+    fprintf(stdout, "ERROR: GF(%u) freed packets were not recoded\n",
+	    1<<(1<<l));
+    nb_error ++;
+    return;
+  }
+  for (i=0; i<WINDOW(l); i++)
+    if (coded_packet_get_coef(&pkt, i) == 0) {
+      fprintf(stdout, "ERROR: GF(%u) source %u not recoded\n", 1<<(1<<l), i);
+      nb_error ++;
+    }
+}
+
+/* the receiver state is exported, serialized and parsed back after every
+   coded packet */
+static void test_receiver_state(uint8_t l, int loss_percent)
+{
+  packet_set_t set;
+  receiver_state_t state, parsed;
+  coded_packet_t pkt;
+  uint8_t buffer[RECEIVER_STATE_MAX_SERIALIZED_SIZE];
+  uint32_t total_size = 0, nb_state = 0;
+  uint16_t i, coef_pos, low = 0;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  packet_set_init(&set, l, check_decoded, make_room, get_decoded, NULL);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= WINDOW(l)-1) ? i-(WINDOW(l)-1) : 0;
+    make_combination(&pkt, l, first, i);
+    if (rand()%100 < loss_percent)
+      continue;
+    packet_set_add(&set, &pkt, NULL, true);
+    while (low < NB_SOURCE && is_decoded[low])
+      low ++;
+
+    /* from a base before the low watermark, to test its normalization */
+    uint16_t base = (low >= 2) ? low-2 : 0;
+    packet_set_get_receiver_state(&set, base, &state);
+    uint16_t size = receiver_state_serialize(&state, buffer, sizeof(buffer));
+    if (size == 0 || !receiver_state_parse(&parsed, buffer, size)
+	|| parsed.rank != state.rank || parsed.coef_pos_base < low) {
+      fprintf(stdout, "ERROR: receiver state not serialized or parsed\n");
+      nb_error ++;
+      continue;
+    }
+    for (coef_pos=base; coef_pos<base+RECEIVER_STATE_SIZE; coef_pos++)
+      if (receiver_state_is_decoded(&state, coef_pos)
+	  != receiver_state_is_decoded(&parsed, coef_pos)
+	  || receiver_state_is_seen(&state, coef_pos)
+	  != receiver_state_is_seen(&parsed, coef_pos)) {
+	fprintf(stdout, "ERROR: parsed receiver state differs at %u\n",
+		coef_pos);
+	nb_error ++;
+	break;
+      }
+    if (size > 1 && receiver_state_serialize(&state, buffer, size-1) != 0) {
+      fprintf(stdout, "ERROR: receiver state serialized in a short buffer\n");
+      nb_error ++;
+    }
+    total_size += size;
+    nb_state ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% receiver state: %.2f bytes on average\n",
+	  1<<(1<<l), loss_percent, nb_state > 0 ? 
+	  (double)total_size / nb_state : 0.0);
+}
+
+static void test_non_innovative(uint8_t l)
+{
+  packet_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt, copy;
+
+  packet_set_init(&set, l, NULL, NULL, NULL, NULL);
+  make_combination(&pkt, l, 0, WINDOW(l)-1);
+  coded_packet_copy_from(&copy, &pkt);
+  packet_set_add(&set, &pkt, &stat, false);
+
+  if (packet_set_is_innovative(&set, &copy)
+      || packet_set_add(&set, &copy, &stat, false) != PACKET_ID_NONE
+      || stat.non_innovative != 1 || stat.reduction_success != 0) {
+    fprintf(stdout, "ERROR: GF(%u) duplicate packet was not rejected\n",
+	    1<<(1<<l));
+    nb_error ++;
+  }
+}
+
+static bool_t is_same_set(packet_set_t* set1, packet_set_t* set2)
+{
+  uint16_t i;
+  for (i=0; i<MAX_CODED_PACKET; i++) {
+    if (set1->id_to_pos[i] != set2->id_to_pos[i])
+      return false;
+    if (set1->id_to_pos[i] != COEF_POS_NONE
+	&& !coded_packet_is_similar(&set1->coded_packet[i],
+				    &set2->coded_packet[i]))
+      return false;
+  }
+  return true;
+}
+
+/* the set must be the same after packet_set_add_batch as after successive
+   calls to packet_set_add; the packets of a batch are added from the
+   newest, so that their pivots are not increasing */
+static void test_batch(uint8_t l, int loss_percent)
+{
+  packet_set_t ref_set, set;
+  coded_packet_t pkt_table[MAX_BATCH], ref_pkt;
+  uint16_t nb_pkt = 0, i, k;
+  int j;
+
+  packet_set_init(&ref_set, l, NULL, packet_set_free_decoded, NULL, NULL);
+  packet_set_init(&set, l, NULL, packet_set_free_decoded, NULL, NULL);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= WINDOW(l)-1) ? i-(WINDOW(l)-1) : 0;
+    for (j=0; j<2; j++) {
+      make_combination(&pkt_table[MAX_BATCH-1-nb_pkt], l, first, i);
+      if (rand()%100 < loss_percent)
+	continue;
+      nb_pkt ++;
+      if (nb_pkt < MAX_BATCH && i < NB_SOURCE-1)
+	continue;
+      if (nb_pkt < MAX_BATCH)
+	memmove(pkt_table, &pkt_table[MAX_BATCH-nb_pkt],
+		nb_pkt*sizeof(coded_packet_t));
+      for (k=0; k<nb_pkt; k++) {
+	coded_packet_copy_from(&ref_pkt, &pkt_table[k]);
+	packet_set_add(&ref_set, &ref_pkt, NULL, true);
+      }
+      packet_set_add_batch(&set, pkt_table, nb_pkt, NULL);
+      nb_pkt = 0;
+      if (!is_same_set(&set, &ref_set)) {
+	fprintf(stdout, "ERROR: GF(%u) different sets after source %u\n",
+		1<<(1<<l), i);
+	nb_error ++;
+	return;
+      }
+    }
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% batch=%u: same set as packet_set_add\n",
+	  1<<(1<<l), loss_percent, MAX_BATCH);
+}
+
+#if PACKET_SET_QUEUE_SIZE > 0
+
+/* packets are queued and decoded by steps of at most `budget` row
+   operations (one step after each arrival): the set must be the same as
+   with packet_set_add whenever the queue is empty */
+static void test_step(uint8_t l, int loss_percent, uint32_t budget)
+{
+  packet_set_t ref_set, set;
+  reduction_stat_t stat;
+  coded_packet_t pkt;
+  uint32_t nb_step = 0, nb_op = 0;
+  uint16_t nb_decoded = 0, nb_notified = 0, i;
+  int j;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  packet_set_init(&ref_set, l, NULL, packet_set_free_decoded, NULL, NULL);
+  packet_set_init(&set, l, check_decoded, packet_set_free_decoded, NULL, NULL);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= WINDOW(l)-1) ? i-(WINDOW(l)-1) : 0;
+    for (j=0; j<2; j++) {
+      make_combination(&pkt, l, first, i);
+      if (rand()%100 < loss_percent)
+	continue;
+      while (!packet_set_enqueue(&set, &pkt)) {
+	nb_op += packet_set_step(&set, budget, &stat);
+	nb_decoded += stat.decoded;
+	nb_step ++;
+      }
+      packet_set_add(&ref_set, &pkt, NULL, true);
+
+      uint32_t nb_step_op = packet_set_step(&set, budget, &stat);
+      if (nb_step_op > budget) {
+	fprintf(stdout, "ERROR: %u row operations in a step\n", nb_step_op);
+	nb_error ++;
+      }
+      nb_op += nb_step_op;
+      nb_decoded += stat.decoded;
+      nb_step ++;
+      if (packet_set_get_nb_queued(&set) == 0 && !is_same_set(&set, &ref_set)) {
+	fprintf(stdout, "ERROR: GF(%u) different sets after source %u\n",
+		1<<(1<<l), i);
+	nb_error ++;
+	return;
+      }
+    }
+  }
+  nb_op += packet_set_step(&set, UINT32_MAX, &stat);
+  nb_decoded += stat.decoded;
+  if (packet_set_get_nb_queued(&set) != 0 || !is_same_set(&set, &ref_set)) {
+    fprintf(stdout, "ERROR: GF(%u) different sets at the end\n", 1<<(1<<l));
+    nb_error ++;
+  }
+
+  for (i=0; i<NB_SOURCE; i++)
+    nb_notified += is_decoded[i];
+  if (nb_notified != nb_decoded
+      || (loss_percent == 0 && nb_notified != NB_SOURCE)) {
+    fprintf(stdout, "ERROR: %u notified, %u counted as decoded\n",
+	    nb_notified, nb_decoded);
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% budget=%u: %u/%u decoded,"
+	  " %.2f row operations per step\n", 1<<(1<<l), loss_percent, budget,
+	  nb_notified, NB_SOURCE, (double)nb_op / nb_step);
+}
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+
+int main(int argc, char** argv)
+{
+  uint16_t i, j;
+  srand(1);
+  for (i=0; i<NB_SOURCE; i++)
+    for (j=0; j<DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+
+  uint8_t l;
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_sliding_window(l, 0, 1, false, false);
+    test_sliding_window(l, 20, 1, false, false);
+    test_sliding_window(l, 0, MAX_BATCH, false, false);
+    test_sliding_window(l, 20, MAX_BATCH, false, false);
+    test_sliding_window(l, 20, 1, false, true);
+    test_sliding_window(l, 20, MAX_BATCH, false, true);
+#if DECODED_STORE_SIZE > 0
+    test_sliding_window(l, 0, 1, true, false);
+    test_sliding_window(l, 20, MAX_BATCH, true, false);
+    test_sliding_window(l, 20, 1, true, true);
+#endif /* DECODED_STORE_SIZE > 0 */
+    test_batch(l, 0);
+    test_batch(l, 20);
+    test_recode(l, 0);
+    test_recode(l, 20);
+    test_recode_freed(l);
+    test_receiver_state(l, 0);
+    test_receiver_state(l, 20);
+    test_non_innovative(l);
+#if PACKET_SET_QUEUE_SIZE > 0
+    test_step(l, 0, 1);
+    test_step(l, 20, 1);
+    test_step(l, 20, 4);
+#endif /* PACKET_SET_QUEUE_SIZE > 0 */
+  }
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,284 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test decoding of sparse sliding window combinations with a peeling set
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "peeling-set.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 200
+#define DATA_SIZE 32
+#define WINDOW (MAX_CODED_PACKET-1)
+
+uint8_t source_table[NB_SOURCE][DATA_SIZE];
+coded_packet_t decoded_table[NB_SOURCE];
+bool_t is_decoded[NB_SOURCE];
+unsigned int nb_error = 0;
+
+static void check_decoded(peeling_set_t* set, uint16_t packet_id)
+{
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint16_t coef_pos = pkt->coef_pos_min;
+  if (!coded_packet_was_decoded(pkt) || coef_pos >= NB_SOURCE
+      || coded_packet_get_coef(pkt, coef_pos) != 1
+      || memcmp(coded_packet_data(pkt), source_table[coef_pos], DATA_SIZE)
+      != 0) {
+    fprintf(stdout, "ERROR: bad decoded packet %u\n", coef_pos);
+    nb_error ++;
+    return;
+  }
+  if (is_decoded[coef_pos]) {
+    fprintf(stdout, "ERROR: packet %u notified twice\n", coef_pos);
+    nb_error ++;
+  }
+  is_decoded[coef_pos] = true;
+  coded_packet_copy_from(&decoded_table[coef_pos], pkt);
+}
+
+static bool_t get_decoded(peeling_set_t* set, uint16_t coef_pos,
+			  coded_packet_t* result)
+{
+  if (coef_pos >= NB_SOURCE || !is_decoded[coef_pos])
+    return false;
+  coded_packet_copy_from(result, &decoded_table[coef_pos]);
+  return true;
+}
+
+static void count_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  unsigned int* nb_decoded = set->notif_data;
+  (*nb_decoded) ++;
+}
+
+static void peeling_count_decoded(peeling_set_t* set, uint16_t packet_id)
+{
+  unsigned int* nb_decoded = set->notif_data;
+  (*nb_decoded) ++;
+}
+
+/* combination of the source `last` and of at most `degree-1` other
+   sources from `first` */
+static void make_sparse_combination(coded_packet_t* pkt, uint8_t l,
+				    uint16_t first, uint16_t last,
+				    uint16_t degree)
+{
+  uint8_t coef_max = (1<<(1<<l))-1;
+  coded_packet_init(pkt, l);
+  uint16_t k;
+  for (k=0; k<degree; k++) {
+    uint16_t i = (k == 0 || first == last) ? last
+      : first + rand()%(last-first);
+    coded_packet_t src;
+    coded_packet_init_from_base_packet(&src, l, i, source_table[i],
+				       DATA_SIZE);
+    coded_packet_add_mult(pkt, 1 + rand()%coef_max, &src);
+  }
+  if (coded_packet_is_empty(pkt))
+    make_sparse_combination(pkt, l, first, last, 1);
+}
+
+static void test_sliding_window(uint8_t l, int loss_percent, uint16_t degree)
+{
+  peeling_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt;
+  uint16_t window = MIN(WINDOW, 1<<log2_window_size(l));
+  uint16_t i;
+  int j;
+
+  memset(is_decoded, 0, sizeof(is_decoded));
+  peeling_set_init(&set, l, check_decoded, peeling_set_free_decoded,
+		   get_decoded, NULL);
+
+  unsigned int nb_decoded = 0, nb_inactivated = 0;
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= window-1) ? i-(window-1) : 0;
+    for (j=0; j<2; j++) {
+      make_sparse_combination(&pkt, l, first, i, degree);
+      if (rand()%100 < loss_percent)
+	continue;
+      peeling_set_add(&set, &pkt, &stat, true);
+      nb_decoded += stat.decoded;
+      nb_inactivated += stat.inactivation;
+    }
+  }
+
+  unsigned int nb_notified = 0;
+  for (i=0; i<NB_SOURCE; i++)
+    nb_notified += is_decoded[i];
+  if (nb_notified != nb_decoded || nb_decoded != set.nb_decoded_packet) {
+    fprintf(stdout, "ERROR: %u notified, %u counted as decoded\n",
+	    nb_notified, nb_decoded);
+    nb_error ++;
+  }
+  if (loss_percent == 0 && nb_notified != NB_SOURCE) {
+    fprintf(stdout, "ERROR: not all packets decoded without losses\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) loss=%d%% degree=%u: %u/%u decoded"
+	  " (%u inactivated)\n", 1<<(1<<l), loss_percent, degree,
+	  nb_notified, NB_SOURCE, nb_inactivated);
+}
+
+/* the same packets, fewer than the sources of one window, are added to a
+   packet set and to a peeling set: after each one, the peeling set must
+   have decoded as many sources as Gaussian Elimination */
+static void test_versus_packet_set(uint8_t l, uint16_t degree)
+{
+  packet_set_t packet_set;
+  peeling_set_t peeling_set;
+  coded_packet_t pkt;
+  uint16_t window = MIN(WINDOW, 1<<log2_window_size(l));
+  unsigned int nb_packet_set = 0, nb_peeling_set = 0;
+  unsigned int total_packet_set = 0, total_peeling_set = 0;
+  uint16_t base, i;
+
+  for (base=0; base+window<=NB_SOURCE; base+=window) {
+    nb_packet_set = 0;
+    nb_peeling_set = 0;
+    packet_set_init(&packet_set, l, count_decoded, NULL, NULL,
+		    &nb_packet_set);
+    peeling_set_init(&peeling_set, l, peeling_count_decoded, NULL, NULL,
+		     &nb_peeling_set);
+    for (i=0; i<window-1; i++) {
+      make_sparse_combination(&pkt, l, base, base + rand()%window, degree);
+      coded_packet_t pkt_copy;
+      coded_packet_copy_from(&pkt_copy, &pkt);
+      packet_set_add(&packet_set, &pkt, NULL, true);
+      peeling_set_add(&peeling_set, &pkt_copy, NULL, true);
+      if (nb_peeling_set < nb_packet_set) {
+	fprintf(stdout, "ERROR: peeling set decoded %u sources,"
+		" packet set %u\n", nb_peeling_set, nb_packet_set);
+	nb_error ++;
+      }
+    }
+    total_packet_set += nb_packet_set;
+    total_peeling_set += nb_peeling_set;
+  }
+  fprintf(stdout, "GF(%u) degree=%u below full rank: %u decoded"
+	  " (packet set: %u)\n", 1<<(1<<l), degree, total_peeling_set,
+	  total_packet_set);
+}
+
+/* packets combining all the sources of one window, fewer than them: 
+   inactivation stalls, and must leave the stored packets unchanged */
+static void test_stalled_payload(uint8_t l)
+{
+  peeling_set_t set;
+  reduction_stat_t stat;
+  coded_packet_t pkt_table[MAX_CODED_PACKET];
+  uint16_t window = MIN(WINDOW, 1<<log2_window_size(l));
+  uint8_t coef_max = (1<<(1<<l))-1;
+  unsigned int nb_decoded = 0, nb_inactivated = 0;
+  uint16_t i, j;
+
+  peeling_set_init(&set, l, peeling_count_decoded, NULL, NULL, &nb_decoded);
+  for (i=0; i<window-1; i++) {
+    coded_packet_t* pkt = &pkt_table[i];
+    coded_packet_init(pkt, l);
+    for (j=0; j<window; j++) {
+      coded_packet_t src;
+      coded_packet_init_from_base_packet(&src, l, j, source_table[j],
+					 DATA_SIZE);
+      coded_packet_add_mult(pkt, 1 + rand()%coef_max, &src);
+    }
+    coded_packet_t pkt_copy;
+    coded_packet_copy_from(&pkt_copy, pkt);
+    uint16_t packet_id = peeling_set_add(&set, &pkt_copy, &stat, true);
+    nb_inactivated += stat.inactivation;
+    if (nb_decoded > 0)
+      return; /* (not expected) the packets are no longer stalled */
+    if (packet_id == PACKET_ID_NONE || stat.elimination != 0) {
+      fprintf(stdout, "ERROR: stalled packet %u not stored as it is\n", i);
+      nb_error ++;
+    }
+  }
+  for (i=0; i<window-1; i++) {
+    coded_packet_t* stored = NULL;
+    for (j=0; j<MAX_CODED_PACKET && stored == NULL; j++)
+      if (set.state[j] == PEELING_STATE_PENDING
+	  && coded_packet_is_similar(&set.coded_packet[j], &pkt_table[i])
+	  && memcmp(coded_packet_data(&set.coded_packet[j]),
+		    coded_packet_data(&pkt_table[i]), DATA_SIZE) == 0)
+	stored = &set.coded_packet[j];
+    if (stored == NULL) {
+      fprintf(stdout, "ERROR: stalled packet %u was modified\n", i);
+      nb_error ++;
+    }
+  }
+  if (window > 2 && l > 0 && nb_inactivated == 0) {
+    fprintf(stdout, "ERROR: no inactivation with stalled packets\n");
+    nb_error ++;
+  }
+  fprintf(stdout, "GF(%u) %u stalled packets: %u inactivated\n",
+	  1<<(1<<l), window-1, nb_inactivated);
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t i, j;
+  srand(1);
+  for (i=0; i<NB_SOURCE; i++)
+    for (j=0; j<DATA_SIZE; j++)
+      source_table[i][j] = rand() & 0xff;
+
+  uint8_t l;
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_sliding_window(l, 0, 1);
+    test_sliding_window(l, 0, 2);
+    test_sliding_window(l, 20, 2);
+    test_sliding_window(l, 20, 3);
+  }
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_versus_packet_set(l, 2);
+    test_versus_packet_set(l, 3);
+  }
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++)
+    test_stalled_payload(l);
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
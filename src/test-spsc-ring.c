@@ -0,0 +1,233 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the lock-free ring between two threads
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "general.h"
+#include "spsc-ring.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define RING_SIZE 16
+#define NB_ENTRY 200000
+
+typedef struct {
+  uint32_t index;
+  uint32_t check;
+} entry_t;
+
+spsc_ring_t ring;
+entry_t entry_table[RING_SIZE];
+unsigned int nb_error = 0;
+
+static void* produce(void* arg)
+{
+  uint32_t i;
+  (void)arg;
+  for (i=0; i<NB_ENTRY; i++) {
+    entry_t* entry = spsc_ring_reserve_wait(&ring);
+    entry->index = i;
+    entry->check = i * 2654435761u;
+    spsc_ring_commit(&ring);
+  }
+  return NULL;
+}
+
+/* the entries are received in order, and the statistics are consistent */
+static void test_threads(void)
+{
+  pthread_t producer;
+  uint32_t i = 0;
+  spsc_ring_init(&ring, entry_table, sizeof(entry_t), RING_SIZE);
+  if (pthread_create(&producer, NULL, produce, NULL) != 0) {
+    fprintf(stdout, "ERROR: cannot start the producer\n");
+    exit(EXIT_FAILURE);
+  }
+  while (i < NB_ENTRY) {
+    entry_t* entry = spsc_ring_peek_wait(&ring);
+    if (entry->index != i || entry->check != i * 2654435761u) {
+      fprintf(stdout, "ERROR: entry %u received instead of %u\n",
+	      entry->index, i);
+      nb_error ++;
+    }
+    spsc_ring_release(&ring);
+    i ++;
+  }
+  pthread_join(producer, NULL);
+
+  spsc_ring_stat_t stat;
+  uint32_t nb_hist = 0;
+  spsc_ring_get_stat(&ring, &stat);
+  for (i=0; i<SPSC_RING_NB_OCCUPANCY_BUCKET; i++)
+    nb_hist += stat.producer.occupancy_hist[i];
+  if (stat.producer.nb_commit != NB_ENTRY 
+      || stat.consumer.nb_release != NB_ENTRY || nb_hist != NB_ENTRY
+      || stat.producer.occupancy_max > RING_SIZE
+      || stat.producer.occupancy_max == 0
+      || spsc_ring_get_occupancy(&ring) != 0) {
+    fprintf(stdout, "ERROR: unexpected statistics\n");
+    nb_error ++;
+  }
+  spsc_ring_stat_pywrite(stdout, &stat);
+  fprintf(stdout, "\n");
+}
+
+/* a full ring refuses new entries, an empty ring has no entry */
+static void test_full(void)
+{
+  uint32_t i;
+  spsc_ring_init(&ring, entry_table, sizeof(entry_t), RING_SIZE);
+  for (i=0; i<RING_SIZE; i++) {
+    entry_t* entry = spsc_ring_reserve(&ring);
+    if (entry == NULL) {
+      fprintf(stdout, "ERROR: ring full after %u entries\n", i);
+      nb_error ++;
+      return;
+    }
+    entry->index = i;
+    spsc_ring_commit(&ring);
+  }
+  if (spsc_ring_reserve(&ring) != NULL
+      || ring.producer_stat.nb_full != 1
+      || ring.producer_stat.occupancy_max != RING_SIZE
+      || ring.producer_stat.occupancy_hist[5] != 1) {
+    fprintf(stdout, "ERROR: full ring not detected\n");
+    nb_error ++;
+  }
+  for (i=0; i<RING_SIZE; i++) {
+    entry_t* entry = spsc_ring_peek(&ring);
+    if (entry == NULL || entry->index != i) {
+      fprintf(stdout, "ERROR: bad entry %u\n", i);
+      nb_error ++;
+      return;
+    }
+    spsc_ring_release(&ring);
+  }
+  if (spsc_ring_peek(&ring) != NULL || ring.consumer_stat.nb_empty != 1) {
+    fprintf(stdout, "ERROR: empty ring not detected\n");
+    nb_error ++;
+  }
+}
+
+static void* consume_all(void* arg)
+{
+  uint32_t* nb_entry = arg;
+  while (spsc_ring_peek_wait(&ring) != NULL) {
+    spsc_ring_release(&ring);
+    (*nb_entry) ++;
+  }
+  return NULL;
+}
+
+static void* produce_one(void* arg)
+{
+  entry_t* entry = spsc_ring_reserve_wait(&ring);
+  (void)arg;
+  entry->index = RING_SIZE;
+  spsc_ring_commit(&ring);
+  return NULL;
+}
+
+/* a consumer waiting on an empty ring sleeps until a commit, and stops
+   when the ring is closed; a producer waiting on a full ring sleeps 
+   until a release */
+static void test_sleep(void)
+{
+  pthread_t thread;
+  uint32_t i, nb_entry = 0;
+  spsc_ring_init(&ring, entry_table, sizeof(entry_t), RING_SIZE);
+  if (pthread_create(&thread, NULL, consume_all, &nb_entry) != 0) {
+    fprintf(stdout, "ERROR: cannot start the consumer\n");
+    exit(EXIT_FAILURE);
+  }
+  usleep(100000);
+  spsc_ring_reserve(&ring);
+  spsc_ring_commit(&ring);
+  usleep(100000);
+  spsc_ring_close(&ring);
+  pthread_join(thread, NULL);
+  if (nb_entry != 1 || ring.consumer_stat.nb_sleep == 0) {
+    fprintf(stdout, "ERROR: consumer received %u entries, slept %u times\n",
+	    nb_entry, ring.consumer_stat.nb_sleep);
+    nb_error ++;
+  }
+
+  spsc_ring_init(&ring, entry_table, sizeof(entry_t), RING_SIZE);
+  for (i=0; i<RING_SIZE; i++) {
+    spsc_ring_reserve(&ring);
+    spsc_ring_commit(&ring);
+  }
+  if (pthread_create(&thread, NULL, produce_one, NULL) != 0) {
+    fprintf(stdout, "ERROR: cannot start the producer\n");
+    exit(EXIT_FAILURE);
+  }
+  usleep(100000);
+  spsc_ring_peek(&ring);
+  spsc_ring_release(&ring);
+  pthread_join(thread, NULL);
+  if (ring.producer_stat.nb_sleep == 0 
+      || spsc_ring_get_occupancy(&ring) != RING_SIZE) {
+    fprintf(stdout, "ERROR: producer slept %u times\n",
+	    ring.producer_stat.nb_sleep);
+    nb_error ++;
+  }
+  for (i=1; i<=RING_SIZE; i++) {
+    entry_t* entry = spsc_ring_peek(&ring);
+    spsc_ring_release(&ring);
+    if (i == RING_SIZE && entry->index != RING_SIZE) {
+      fprintf(stdout, "ERROR: entry of the producer not found\n");
+      nb_error ++;
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  test_full();
+  test_threads();
+  test_sleep();
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,218 @@
+/*---------------------------------------------------------------------------
+ * Copyright 2013-2017 Inria
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @ingroup     liblc
+ * @{
+ *
+ * @file
+ *
+ * @author  Cedric Adjih <cedric.adjih@inria.fr>
+ *
+ * @brief   Test the decoding with payload programs executed on stripes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "general.h"
+#include "packet-set.h"
+#include "stripe-pool.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define NB_SOURCE 200
+#define DATA_SIZE MIN(CODED_PACKET_SIZE, 100)
+#define WINDOW(l) MIN(MAX_CODED_PACKET-1, 1<<log2_window_size(l))
+#define NB_SET 4
+#define NB_THREAD 3
+#define STRIPE_SIZE 16
+#define MAX_BATCH 4
+
+/* set 0 operates on the payloads immediately, set 1 executes its payload 
+   program in the calling thread, set 2 on stripes with a pool (always 
+   with its threads), set 3 with a pool whose threads are not used for 
+   programs below STRIPE_POOL_MIN_PARALLEL_SIZE (all of them here) */
+packet_set_t set_table[NB_SET];
+payload_program_t program_table[NB_SET];
+stripe_pool_t pool, small_pool;
+
+uint8_t source_table[NB_SOURCE][DATA_SIZE];
+uint8_t source_size[NB_SOURCE];
+
+/* decoded source indices, in order of notification */
+uint16_t decoded_table[NB_SET][NB_SOURCE];
+uint16_t nb_decoded[NB_SET];
+unsigned int nb_error = 0;
+
+static void check_decoded(packet_set_t* set, uint16_t packet_id)
+{
+  uint16_t index = set - set_table;
+  coded_packet_t* pkt = &set->coded_packet[packet_id];
+  uint16_t coef_pos = pkt->coef_pos_min;
+  if (coef_pos >= NB_SOURCE || nb_decoded[index] >= NB_SOURCE
+      || pkt->data_size < source_size[coef_pos]
+      || memcmp(coded_packet_data(pkt), source_table[coef_pos],
+		source_size[coef_pos]) != 0) {
+    fprintf(stdout, "ERROR: set %u: bad decoded packet %u\n", index, 
+	    coef_pos);
+    nb_error ++;
+    return;
+  }
+  decoded_table[index][nb_decoded[index]++] = coef_pos;
+}
+
+static void make_combination(coded_packet_t* pkt, uint8_t l,
+			     uint16_t first, uint16_t last)
+{
+  uint8_t coef_max = (1<<(1<<l))-1;
+  coded_packet_init(pkt, l);
+  uint16_t i;
+  for (i=first; i<=last; i++) {
+    uint8_t coef = (i == last) ? 1 + rand()%coef_max : rand()%(coef_max+1);
+    if (coef == 0)
+      continue;
+    coded_packet_t src;
+    coded_packet_init_from_base_packet(&src, l, i, source_table[i],
+				       source_size[i]);
+    coded_packet_add_mult(pkt, coef, &src);
+  }
+}
+
+/* the same packets are added to each set, which must end up with exactly 
+   the same content and notifications */
+static void test_stripe(uint8_t l, int loss_percent, uint16_t batch_size)
+{
+  coded_packet_t pkt_table[NB_SET][MAX_BATCH];
+  uint16_t nb_pkt = 0;
+  uint16_t i, j, k;
+
+  memset(nb_decoded, 0, sizeof(nb_decoded));
+  for (k=0; k<NB_SET; k++)
+    packet_set_init(&set_table[k], l, check_decoded, packet_set_free_decoded,
+		    NULL, NULL);
+  packet_set_set_payload_executor(&set_table[1], &program_table[1], 
+				  NULL, NULL);
+  packet_set_set_payload_executor(&set_table[2], &program_table[2], 
+				  stripe_pool_execute, &pool);
+  packet_set_set_payload_executor(&set_table[3], &program_table[3], 
+				  stripe_pool_execute, &small_pool);
+
+  for (i=0; i<NB_SOURCE; i++) {
+    uint16_t first = (i >= WINDOW(l)-1) ? i-(WINDOW(l)-1) : 0;
+    for (j=0; j<2; j++) {
+      make_combination(&pkt_table[0][nb_pkt], l, first, i);
+      if (rand()%100 < loss_percent)
+	continue;
+      for (k=1; k<NB_SET; k++)
+	coded_packet_copy_from(&pkt_table[k][nb_pkt], &pkt_table[0][nb_pkt]);
+      nb_pkt ++;
+      if (nb_pkt < batch_size && i < NB_SOURCE-1)
+	continue;
+      for (k=0; k<NB_SET; k++) {
+	if (batch_size <= 1)
+	  packet_set_add(&set_table[k], &pkt_table[k][0], NULL, true);
+	else packet_set_add_batch(&set_table[k], pkt_table[k], nb_pkt, NULL);
+      }
+      nb_pkt = 0;
+
+      for (k=1; k<NB_SET; k++) {
+	uint16_t id;
+	for (id=0; id<MAX_CODED_PACKET; id++)
+	  if (set_table[k].id_to_pos[id] != set_table[0].id_to_pos[id]
+	      || (set_table[0].id_to_pos[id] != COEF_POS_NONE
+		  && !coded_packet_is_similar(&set_table[k].coded_packet[id],
+					      &set_table[0].coded_packet[id])))
+	    break;
+	if (id < MAX_CODED_PACKET) {
+	  fprintf(stdout, "ERROR: GF(%u) set %u differs after source %u\n",
+		  1<<(1<<l), k, i);
+	  nb_error ++;
+	  return;
+	}
+      }
+    }
+  }
+
+  for (k=1; k<NB_SET; k++)
+    if (nb_decoded[k] != nb_decoded[0]
+	|| memcmp(decoded_table[k], decoded_table[0],
+		  nb_decoded[0]*sizeof(uint16_t)) != 0) {
+      fprintf(stdout, "ERROR: GF(%u) set %u: different notifications\n",
+	      1<<(1<<l), k);
+      nb_error ++;
+    }
+  if (loss_percent == 0 && nb_decoded[0] != NB_SOURCE) {
+    fprintf(stdout, "ERROR: GF(%u): %u/%u decoded\n", 1<<(1<<l),
+	    nb_decoded[0], NB_SOURCE);
+    nb_error ++;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  uint16_t i, j;
+  uint8_t l;
+  srand(1);
+  for (i=0; i<NB_SOURCE; i++) {
+    source_size[i] = 1 + rand()%DATA_SIZE;
+    for (j=0; j<source_size[i]; j++)
+      source_table[i][j] = rand() & 0xff;
+  }
+  if (!stripe_pool_start(&pool, NB_THREAD, STRIPE_SIZE)
+      || !stripe_pool_start(&small_pool, 1, STRIPE_SIZE)) {
+    fprintf(stdout, "ERROR: cannot start the pool\n");
+    exit(EXIT_FAILURE);
+  }
+  pool.min_parallel_size = 0;
+  for (l=0; l<=MAX_LOG2_NB_BIT_COEF; l++) {
+    test_stripe(l, 0, 1);
+    test_stripe(l, 30, 1);
+    test_stripe(l, 0, MAX_BATCH);
+    test_stripe(l, 30, MAX_BATCH);
+  }
+  stripe_pool_pywrite(stdout, &pool);
+  fprintf(stdout, "\n");
+  stripe_pool_pywrite(stdout, &small_pool);
+  fprintf(stdout, "\n");
+  stripe_pool_stop(&pool);
+  stripe_pool_stop(&small_pool);
+  if (pool.stat.nb_parallel == 0) {
+    fprintf(stdout, "ERROR: no program executed in parallel\n");
+    nb_error ++;
+  }
+  if (small_pool.stat.nb_program == 0 || small_pool.stat.nb_parallel > 0) {
+    fprintf(stdout, "ERROR: small programs executed in parallel\n");
+    nb_error ++;
+  }
+
+  if (nb_error > 0) {
+    fprintf(stdout, "%u errors\n", nb_error);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @} */